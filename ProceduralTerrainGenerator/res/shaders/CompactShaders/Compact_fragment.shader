@@ -0,0 +1,35 @@
+#version 450 core
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 Color;
+
+out vec4 FragColor;
+
+struct Light {
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform bool lightOn;
+uniform Light light;
+
+void main()
+{
+    if(!lightOn){
+        FragColor = vec4(Color, 1.0);
+        return;
+    }
+
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(light.position - FragPos);
+
+    vec3 ambient = light.ambient * Color;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * Color;
+
+    FragColor = vec4(ambient + diffuse, 1.0);
+}
@@ -0,0 +1,36 @@
+#version 450 core
+
+layout(location = 0) in float aHeight;
+layout(location = 1) in vec2 aNormal;
+layout(location = 2) in vec2 aColorIndex;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform int gridWidth;
+uniform float heightMin;
+uniform float heightRange;
+uniform sampler2D palette;
+
+vec3 OctDecode(vec2 e) {
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0) {
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main() {
+    //Grid position is implicit, vertices are stored row by row
+    vec3 mapPos = vec3(float(gl_VertexID % gridWidth), heightMin + aHeight * heightRange, float(gl_VertexID / gridWidth));
+    vec4 worldPos = model * vec4(mapPos, 1.0);
+
+    FragPos = worldPos.xyz;
+    Normal = normalize(mat3(transpose(inverse(model))) * OctDecode(aNormal));
+    Color = texelFetch(palette, ivec2(int(aColorIndex.x * 255.0 + 0.5), 0), 0).rgb;
+    gl_Position = projection * view * worldPos;
+}
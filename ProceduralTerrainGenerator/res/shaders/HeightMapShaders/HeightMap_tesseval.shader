@@ -9,6 +9,9 @@ out vec3 aColor;
 out vec3 aNormal;
 
 uniform sampler2D heightMap;
+//Octahedral encoded normals precomputed on the CPU, used instead of the height differences when useNormalMap is set
+uniform sampler2D normalMap;
+uniform bool useNormalMap;
 uniform bool flatten;
 uniform int size;
 uniform int displayMode;
@@ -17,6 +20,15 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0) {
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
 void main()
 {
     float u = gl_TessCoord.x;
@@ -34,15 +46,20 @@ void main()
     Height =  texture(heightMap, texCoord).r * heightScale;
 
     //Normal (gradient)
-    float texel = 1.0 / float(textureSize(heightMap, 0).x);
-    float hL = texture(heightMap, texCoord + vec2(-texel, 0)).r * heightScale;
-    float hR = texture(heightMap, texCoord + vec2( texel, 0)).r * heightScale;
-    float hD = texture(heightMap, texCoord + vec2(0, -texel)).r * heightScale;
-    float hU = texture(heightMap, texCoord + vec2(0,  texel)).r * heightScale;
-
-    vec3 dx = vec3(2.0 * texel, hR - hL, 0.0);
-    vec3 dz = vec3(0.0, hU - hD, 2.0 * texel);
-    aNormal = normalize(cross(dz, dx));
+    if (useNormalMap) {
+        aNormal = OctDecode(texture(normalMap, texCoord).rg);
+    }
+    else {
+        float texel = 1.0 / float(textureSize(heightMap, 0).x);
+        float hL = texture(heightMap, texCoord + vec2(-texel, 0)).r * heightScale;
+        float hR = texture(heightMap, texCoord + vec2( texel, 0)).r * heightScale;
+        float hD = texture(heightMap, texCoord + vec2(0, -texel)).r * heightScale;
+        float hU = texture(heightMap, texCoord + vec2(0,  texel)).r * heightScale;
+
+        vec3 dx = vec3(2.0 * texel, hR - hL, 0.0);
+        vec3 dz = vec3(0.0, hU - hD, 2.0 * texel);
+        aNormal = normalize(cross(dz, dx));
+    }
     //Normal
 
     vec4 p00 = gl_in[0].gl_Position;
@@ -0,0 +1,56 @@
+#version 450 core
+
+layout(location = 0) in vec2 aGrid;
+//Selected quadtree node, one per instance: origin x, origin z, size
+layout(location = 1) in vec3 node;
+//Camera distances between which the vertices of the node morph to the parent grid
+layout(location = 2) in vec2 morphRange;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform sampler2D heightMap;
+uniform vec2 mapSize;
+uniform float heightScale;
+//Range of a normalized (16 bit) height map, 0 and 1 for float maps
+uniform float heightMin;
+uniform float heightRange;
+uniform int gridResolution;
+//Camera position in map space and the map -> world scale of the selection, distances match the CPU side
+uniform vec3 lodCamera;
+uniform vec3 lodWorldScale;
+
+float SampleHeight(vec2 p) {
+    return heightMin + textureLod(heightMap, (p + 0.5) / mapSize, 0.0).r * heightRange;
+}
+
+vec3 TopoColor(float h) {
+    if (h < 0.5)
+        return mix(vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), h * 2.0);
+    return mix(vec3(0.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), (h - 0.5) * 2.0);
+}
+
+void main() {
+    //Odd grid vertices slide onto the parent grid by their distance from the camera (CDLOD geomorphing),
+    //vertices shared by two nodes get the same morph so borders between levels stay closed
+    vec2 gridPos = aGrid * float(gridResolution);
+    vec2 vertexPos = min(node.xy + gridPos / float(gridResolution) * node.z, mapSize - 1.0);
+    float distance = length((vec3(vertexPos.x, SampleHeight(vertexPos) * heightScale, vertexPos.y) - lodCamera) * lodWorldScale);
+    float morph = clamp((distance - morphRange.x) / max(morphRange.y - morphRange.x, 1e-3), 0.0, 1.0);
+    gridPos -= fract(gridPos * 0.5) * 2.0 * morph;
+    vec2 mapPos = min(node.xy + gridPos / float(gridResolution) * node.z, mapSize - 1.0);
+
+    float h = SampleHeight(mapPos);
+    float dx = (SampleHeight(mapPos + vec2(1.0, 0.0)) - SampleHeight(mapPos - vec2(1.0, 0.0))) * 0.5 * heightScale;
+    float dz = (SampleHeight(mapPos + vec2(0.0, 1.0)) - SampleHeight(mapPos - vec2(0.0, 1.0))) * 0.5 * heightScale;
+
+    vec4 worldPos = model * vec4(mapPos.x, h * heightScale, mapPos.y, 1.0);
+    FragPos = worldPos.xyz;
+    Normal = normalize(mat3(transpose(inverse(model))) * vec3(-dx, 1.0, -dz));
+    Color = TopoColor(clamp(h, 0.0, 1.0));
+    gl_Position = projection * view * worldPos;
+}
@@ -9,15 +9,35 @@ out vec3 aColor;
 out vec3 aNormal;
 
 uniform sampler2D heightMap;
+//Octahedral encoded normals precomputed on the CPU, used instead of the height differences when useNormalMap is set
+uniform sampler2D normalMap;
+uniform bool useNormalMap;
 uniform sampler2D biomeMap;
 uniform bool flatten;
 uniform int size;
 uniform int displayMode;
 uniform float heightScale;
+//Range of a normalized (16 bit) height map, 0 and 1 for float maps
+uniform float heightMin;
+uniform float heightRange;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+float SampleHeight(vec2 uv)
+{
+    return (heightMin + texture(heightMap, uv).r * heightRange) * heightScale;
+}
+
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0) {
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
 void main()
 {
     float u = gl_TessCoord.x;
@@ -32,18 +52,23 @@ void main()
     vec2 t1 = (t11 - t10) * u + t10;
     vec2 texCoord = (t1 - t0) * v + t0;
 
-    Height =  texture(heightMap, texCoord).r * heightScale;
+    Height = SampleHeight(texCoord);
 
     //Normal (gradient)
-    float texel = 1.0 / float(textureSize(heightMap, 0).x);
-    float hL = texture(heightMap, texCoord + vec2(-texel, 0)).r * heightScale;
-    float hR = texture(heightMap, texCoord + vec2( texel, 0)).r * heightScale;
-    float hD = texture(heightMap, texCoord + vec2(0, -texel)).r * heightScale;
-    float hU = texture(heightMap, texCoord + vec2(0,  texel)).r * heightScale;
-
-    vec3 dx = vec3(2.0 * texel, hR - hL, 0.0);
-    vec3 dz = vec3(0.0, hU - hD, 2.0 * texel);
-    aNormal = normalize(cross(dz, dx));
+    if (useNormalMap) {
+        aNormal = OctDecode(texture(normalMap, texCoord).rg);
+    }
+    else {
+        float texel = 1.0 / float(textureSize(heightMap, 0).x);
+        float hL = SampleHeight(texCoord + vec2(-texel, 0));
+        float hR = SampleHeight(texCoord + vec2( texel, 0));
+        float hD = SampleHeight(texCoord + vec2(0, -texel));
+        float hU = SampleHeight(texCoord + vec2(0,  texel));
+
+        vec3 dx = vec3(2.0 * texel, hR - hL, 0.0);
+        vec3 dz = vec3(0.0, hU - hD, 2.0 * texel);
+        aNormal = normalize(cross(dz, dx));
+    }
     //Normal
 
     vec4 p00 = gl_in[0].gl_Position;
@@ -0,0 +1,40 @@
+#version 450 core
+
+in vec3 FragPos;
+in vec3 Normal;
+in float LocalHeight;
+
+out vec4 FragColor;
+
+struct Light {
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform bool lightOn;
+uniform Light light;
+uniform vec3 trunkColor;
+uniform vec3 crownColor;
+uniform float crownHeight;
+
+void main()
+{
+    vec3 baseColor = LocalHeight < crownHeight ? trunkColor : crownColor;
+
+    if(!lightOn){
+        FragColor = vec4(baseColor, 1.0);
+        return;
+    }
+
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(light.position - FragPos);
+
+    vec3 ambient = light.ambient * baseColor;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * baseColor;
+
+    FragColor = vec4(ambient + diffuse, 1.0);
+}
@@ -0,0 +1,33 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+//Per instance attributes
+layout(location = 3) in vec3 iPosition;
+layout(location = 4) in float iScale;
+layout(location = 5) in float iRotation;
+
+out vec3 FragPos;
+out vec3 Normal;
+out float LocalHeight;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float instanceScale;
+
+void main() {
+    //Instance position is given in map space, the mesh itself is not stretched by the map transform
+    float c = cos(iRotation);
+    float s = sin(iRotation);
+    mat3 rotation = mat3(c, 0.0, -s,
+                         0.0, 1.0, 0.0,
+                         s, 0.0, c);
+    vec3 worldPos = vec3(model * vec4(iPosition, 1.0)) + rotation * aPos * iScale * instanceScale;
+
+    FragPos = worldPos;
+    Normal = rotation * aNormal;
+    LocalHeight = aPos.y;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
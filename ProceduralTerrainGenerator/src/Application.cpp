@@ -1,9 +1,11 @@
 #include "TerrainGenApp.h"
 
 #include <iostream>
+#include "Trace.h"
 
 int main(void)
 {
+	utilities::SetTraceThreadName("Main");
 	TerrainGenApp* app = new TerrainGenApp();
 	app->Initialize();
 	app->Start();
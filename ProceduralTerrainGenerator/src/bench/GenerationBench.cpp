@@ -0,0 +1,209 @@
+//Microbenchmarks of the generation kernels, runs headless on the GL-free core (see src/cli/TerrainGenCli.cpp for the source list)
+//plus utility/Benchmark.cpp. Every fixture uses fixed seeds so results are comparable between versions.
+//
+//Usage: GenerationBench [--size N] [--filter text] [--min-time ms] [--min-iterations N] [--threads N] [--json report.json] [--verbose]
+//Build in release mode, the report records whether NDEBUG was defined.
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "Noise.h"
+#include "Erosion.h"
+#include "TerrainGenerator.h"
+#include "BiomeGenerator.h"
+#include "NormalMap.h"
+#include "utilities.h"
+#include "Parallel.h"
+#include "Benchmark.h"
+#include "Log.h"
+
+namespace
+{
+	struct BenchConfig {
+		utilities::BenchmarkSettings settings;
+		int size = 512;
+		int threads = 0;
+		int droplets = 20000;
+		std::string jsonPath;
+	};
+
+	bool ParseArguments(int argc, char** argv, BenchConfig& config)
+	{
+		try {
+			for (int i = 1; i < argc; i++) {
+				const std::string arg = argv[i];
+				const bool hasValue = i + 1 < argc;
+				if (arg == "--verbose") config.settings.quiet = false;
+				else if (!hasValue) {
+					std::cout << "Usage: GenerationBench [--size N] [--filter text] [--min-time ms] [--min-iterations N] [--threads N] [--droplets N] [--json report.json] [--verbose]\n";
+					return false;
+				}
+				else if (arg == "--size") config.size = std::stoi(argv[++i]);
+				else if (arg == "--filter") config.settings.filter = argv[++i];
+				else if (arg == "--min-time") config.settings.minTime = std::stod(argv[++i]);
+				else if (arg == "--min-iterations") config.settings.minIterations = std::stoi(argv[++i]);
+				else if (arg == "--threads") config.threads = std::stoi(argv[++i]);
+				else if (arg == "--droplets") config.droplets = std::stoi(argv[++i]);
+				else if (arg == "--json") config.jsonPath = argv[++i];
+				else {
+					std::cout << "[ERROR] Unknown option: " << arg << "\n";
+					return false;
+				}
+			}
+		}
+		catch (const std::exception&) {
+			std::cout << "[ERROR] Invalid number in command line\n";
+			return false;
+		}
+		return config.size > 1;
+	}
+
+	void NoiseBenchmarks(utilities::BenchmarkSuite& suite, int size)
+	{
+		const double samples = static_cast<double>(size) * size;
+		noise::SimplexNoiseClass noise;
+		noise.Initialize(size, size);
+
+		struct NoiseCase {
+			const char* name;
+			noise::Options option;
+			bool ridge, island;
+		};
+		const NoiseCase cases[] = {
+			{ "refit", noise::Options::REFIT_ALL, false, false },
+			{ "revert", noise::Options::REVERT_NEGATIVES, false, false },
+			{ "ridge", noise::Options::REVERT_NEGATIVES, true, false },
+			{ "island", noise::Options::REVERT_NEGATIVES, false, true }
+		};
+		for (int octaves : { 1, 4, 8 }) {
+			for (const NoiseCase& c : cases) {
+				noise::NoiseConfigParameters config(1337);
+				config.octaves = octaves;
+				config.option = c.option;
+				config.Ridge = c.ridge;
+				config.island = c.island;
+				noise.SetConfig(config);
+				suite.Run("GenerateFractalNoise/" + std::string(c.name) + "/octaves:" + std::to_string(octaves), "samples", samples,
+					[&]() { noise.GenerateFractalNoise(0.0f, 0.0f); });
+			}
+		}
+
+		//Interleaved sampling of differently seeded noises, the access pattern of the terrain evaluation
+		noise::SimplexNoiseClass other;
+		other.Initialize(size, size);
+		other.SetConfig(noise::NoiseConfigParameters(7331));
+		noise.SetConfig(noise::NoiseConfigParameters(1337));
+		volatile float sink = 0.0f;
+		suite.Run("PointNoise/interleaved seeds", "samples", samples, [&]() {
+			float sum = 0.0f;
+			for (int y = 0; y < size; y++) {
+				for (int x = 0; x < size; x += 2) {
+					sum += noise.PointNoise(static_cast<float>(x), static_cast<float>(y));
+					sum += other.PointNoise(static_cast<float>(x + 1), static_cast<float>(y));
+				}
+			}
+			sink = sum;
+		});
+	}
+
+	void TerrainBenchmarks(utilities::BenchmarkSuite& suite, int size)
+	{
+		const double samples = static_cast<double>(size) * size;
+		TerrainGenerator terrainGen;
+		terrainGen.Initialize(size, size);
+		for (size_t i = 0; i < terrainGen.GetEvaluators().size(); i++) {
+			terrainGen.GetEvaluatorRef() = static_cast<int>(i);
+			suite.Run("GenerateTerrain/" + terrainGen.GetEvaluators()[i].name, "samples", samples,
+				[&]() { terrainGen.GenerateTerrain(0.0f, 0.0f); });
+		}
+
+		BiomeGenerator biomeGen;
+		biomeGen.Initialize(size, size);
+		terrainGen.GenerateNoises();
+		suite.Run("Biomify", "samples", samples, [&]() {
+			biomeGen.Biomify(terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::CONTINENTALNESS),
+				terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS),
+				terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::WEIRDNESS));
+		});
+		biomeGen.GetBlendRadiusRef() = 8;
+		suite.Run("BlendBiomes/radius:8", "samples", samples, [&]() { biomeGen.BlendBiomes(); });
+	}
+
+	void ErosionBenchmarks(utilities::BenchmarkSuite& suite, int size, int droplets)
+	{
+		noise::SimplexNoiseClass noise;
+		noise.Initialize(size, size);
+		noise.SetConfig(noise::NoiseConfigParameters(1337));
+		noise.GenerateFractalNoise(0.0f, 0.0f);
+
+		erosion::Erosion erosion(size, size);
+		erosion.GetConfigRef().seed = 42;
+		erosion.SetDropletCount(droplets);
+		suite.Run("Erode/droplets:" + std::to_string(droplets), "droplets", droplets,
+			[&]() { erosion.Erode(std::nullopt); }, [&]() { erosion.SetMap(noise.GetView()); });
+	}
+
+	void MeshBenchmarks(utilities::BenchmarkSuite& suite, int size)
+	{
+		const double samples = static_cast<double>(size) * size;
+		const unsigned int stride = 9;
+		noise::SimplexNoiseClass noise;
+		noise.Initialize(size, size);
+		noise.SetConfig(noise::NoiseConfigParameters(1337));
+		noise.GenerateFractalNoise(0.0f, 0.0f);
+
+		std::vector<float> vertices(static_cast<size_t>(size) * size * stride);
+		utilities::ParseNoiseIntoVertices(vertices.data(), noise.GetMap(), size, size, 100.0f, stride, 0);
+
+		suite.Run("CalculateNormalMap", "samples", samples,
+			[&]() { utilities::CalculateNormalMap(noise.GetMap(), size, size, 100.0f, vertices.data(), stride, 3); });
+
+		utilities::OctNormalMap normalMap;
+		suite.Run("OctNormalMap/Build", "samples", samples,
+			[&]() { normalMap.Build(noise.GetMap(), size, size, 100.0f * size); });
+
+		std::vector<unsigned int> indices(utilities::GetStripIndexCount(size, size));
+		suite.Run("MeshIndicesStrips", "indices", static_cast<double>(indices.size()),
+			[&]() { utilities::MeshIndicesStrips(indices.data(), size, size); });
+
+		const std::pair<const char*, utilities::heightMapMode> modes[] = {
+			{ "greyscale", utilities::heightMapMode::GREYSCALE },
+			{ "topographical", utilities::heightMapMode::TOPOGRAPHICAL },
+			{ "monocolor", utilities::heightMapMode::MONOCOLOR }
+		};
+		for (const auto& mode : modes) {
+			suite.Run("PaintVerticesByHeight/" + std::string(mode.first), "samples", samples,
+				[&]() { utilities::PaintVerticesByHeight(vertices.data(), size, size, 100.0f, stride, mode.second, 1, 6); });
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	BenchConfig config;
+	if (!ParseArguments(argc, argv, config)) {
+		return 1;
+	}
+	utilities::SetWorkerCount(config.threads);
+
+	utilities::BenchmarkSuite suite("Generation kernels " + std::to_string(config.size) + "x" + std::to_string(config.size)
+		+ ", " + std::to_string(utilities::GetWorkerCount()) + " threads", config.settings);
+
+	//Setup of the kernels between the benchmarks logs too, quiet runs keep it out of the results
+	std::ostream* logSink = utilities::GetLogSink();
+	if (config.settings.quiet) {
+		utilities::SetLogSink(nullptr);
+	}
+	NoiseBenchmarks(suite, config.size);
+	TerrainBenchmarks(suite, config.size);
+	ErosionBenchmarks(suite, config.size, config.droplets);
+	MeshBenchmarks(suite, config.size);
+	utilities::SetLogSink(logSink);
+
+	suite.PrintTable(std::cout);
+	if (!config.jsonPath.empty() && !suite.WriteJson(config.jsonPath)) {
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,331 @@
+//End-to-end scenario benchmark, runs the generation pipeline headless stage by stage for a list of map sizes
+//and records wall time, peak resident memory and heap allocations of every stage.
+//Builds from the GL-free core (see src/cli/TerrainGenCli.cpp for the source list) plus utility/Benchmark.cpp.
+//
+//Usage: PipelineBench [--sizes 256,512,...] [--stages init,generate,biomify,erode,mesh,export] [--droplet-density d]
+//	[--threads N] [--out directory] [--json report.json] [--trace trace.json]
+//Stages run in the given order on the same state, so a script can f.e. generate twice to measure biome shaping.
+//Peak memory is reset before every stage on Linux, on other platforms it is the peak of the whole process.
+//Scratch is the largest amount of the per thread scratch arenas used by any thread during the stage.
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <filesystem>
+
+#include "Erosion.h"
+#include "TerrainGenerator.h"
+#include "BiomeGenerator.h"
+#include "HeightPyramid.h"
+#include "NormalMap.h"
+#include "MapExport.h"
+#include "utilities.h"
+#include "Parallel.h"
+#include "Benchmark.h"
+#include "ScratchArena.h"
+#include "Trace.h"
+#include "Log.h"
+
+//Heap allocations of the whole program are counted by replacing the global allocation functions
+static std::atomic<size_t> allocationCount{ 0 };
+static std::atomic<size_t> allocatedBytes{ 0 };
+
+static void* CountedAllocate(std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+//Over-aligned allocations of the grids, the size is rounded up to the alignment as aligned_alloc requires
+static void* CountedAllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	const std::size_t align = static_cast<std::size_t>(alignment);
+	const std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+#ifdef _WIN32
+	void* p = _aligned_malloc(rounded, align);
+#else
+	void* p = std::aligned_alloc(align, rounded);
+#endif
+	if (p) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+static void AlignedFree(void* p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+void operator delete(void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+
+namespace
+{
+	struct ScenarioConfig {
+		std::vector<int> sizes = { 256, 512, 1024, 2048, 4096, 8192 };
+		std::vector<std::string> stages = { "init", "generate", "biomify", "erode", "mesh", "export" };
+		float dropletDensity = 0.02f;
+		int threads = 0;
+		std::string outputDirectory = "bench_out";
+		std::string jsonPath;
+		std::string tracePath;
+	};
+
+	//Measurements of one stage
+	//@param peakMemory: Peak resident memory during the stage in bytes
+	struct StageRecord {
+		int size;
+		std::string stage;
+		double milliseconds;
+		size_t peakMemory;
+		size_t allocations;
+		size_t allocatedBytes;
+		size_t scratchBytes;
+		bool succeeded;
+	};
+
+	//State shared by the stages of one scenario
+	struct Pipeline {
+		int size = 0;
+		TerrainGenerator terrainGen;
+		BiomeGenerator biomeGen;
+		std::unique_ptr<erosion::Erosion> erosion;
+		utilities::HeightPyramid heightPyramid;
+		utilities::OctNormalMap normalMap;
+		std::vector<unsigned int> stripIndices;
+		const float* heightMap = nullptr;
+	};
+
+	std::vector<std::string> Split(const std::string& s)
+	{
+		std::vector<std::string> parts;
+		std::stringstream stream(s);
+		std::string part;
+		while (std::getline(stream, part, ',')) {
+			if (!part.empty()) {
+				parts.push_back(part);
+			}
+		}
+		return parts;
+	}
+
+	bool ParseArguments(int argc, char** argv, ScenarioConfig& config)
+	{
+		if (argc % 2 == 0) {
+			std::cout << "Usage: PipelineBench [--sizes 256,512,...] [--stages init,generate,biomify,erode,mesh,export] [--droplet-density d] [--threads N] [--out directory] [--json report.json] [--trace trace.json]\n";
+			return false;
+		}
+		try {
+			for (int i = 1; i + 1 < argc; i += 2) {
+				const std::string arg = argv[i];
+				const std::string value = argv[i + 1];
+				if (arg == "--sizes") {
+					config.sizes.clear();
+					for (const std::string& size : Split(value)) {
+						config.sizes.push_back(std::stoi(size));
+					}
+				}
+				else if (arg == "--stages") config.stages = Split(value);
+				else if (arg == "--droplet-density") config.dropletDensity = std::stof(value);
+				else if (arg == "--threads") config.threads = std::stoi(value);
+				else if (arg == "--out") config.outputDirectory = value;
+				else if (arg == "--json") config.jsonPath = value;
+				else if (arg == "--trace") config.tracePath = value;
+				else {
+					std::cout << "[ERROR] Unknown option: " << arg << "\n";
+					return false;
+				}
+			}
+		}
+		catch (const std::exception&) {
+			std::cout << "[ERROR] Invalid number in command line\n";
+			return false;
+		}
+		return true;
+	}
+
+	//Runs one stage of the pipeline, the same steps TerrainGenApp performs before the first frame
+	bool RunStage(const std::string& stage, Pipeline& pipeline, const ScenarioConfig& config)
+	{
+		const int size = pipeline.size;
+		if (stage == "init") {
+			if (!pipeline.terrainGen.Initialize(size, size) || !pipeline.biomeGen.Initialize(size, size)) {
+				return false;
+			}
+			pipeline.terrainGen.ClearBiomeHeightCurves();
+			for (const auto& it : pipeline.biomeGen.GetBiomes()) {
+				pipeline.terrainGen.SetBiomeHeightCurve(it.first, it.second.GetHeightCurve());
+			}
+			pipeline.heightMap = pipeline.terrainGen.GetHeightMap();
+			return true;
+		}
+		if (stage == "generate") {
+			if (!pipeline.terrainGen.GenerateTerrain(0.0f, 0.0f)) {
+				return false;
+			}
+			pipeline.heightMap = pipeline.terrainGen.GetHeightMap();
+			return true;
+		}
+		if (stage == "biomify") {
+			if (!pipeline.biomeGen.Biomify(pipeline.terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::CONTINENTALNESS),
+				pipeline.terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS),
+				pipeline.terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::WEIRDNESS))) {
+				return false;
+			}
+			pipeline.terrainGen.SetBiomeMap(pipeline.biomeGen.GetBiomeMap(), pipeline.biomeGen.GetBiomeWeights());
+			return true;
+		}
+		if (stage == "erode") {
+			if (!pipeline.heightMap) {
+				return false;
+			}
+			pipeline.erosion = std::make_unique<erosion::Erosion>(size, size);
+			pipeline.erosion->GetConfigRef().seed = 42;
+			pipeline.erosion->SetDropletCount(std::max(1, static_cast<int>(config.dropletDensity * size * size)));
+			pipeline.erosion->SetMap(pipeline.terrainGen.GetHeightView());
+			pipeline.erosion->Erode(std::nullopt);
+			pipeline.heightMap = pipeline.erosion->GetMap();
+			return true;
+		}
+		if (stage == "mesh") {
+			//GPU ready data of the tessellated terrain: height pyramid, octahedral normals and the strip index grid
+			if (!pipeline.heightMap || !pipeline.heightPyramid.Build(pipeline.heightMap, size, size, utilities::MipReduction::MAX) ||
+				!pipeline.normalMap.Build(pipeline.heightMap, size, size, 100.0f * size)) {
+				return false;
+			}
+			pipeline.stripIndices.resize(utilities::GetStripIndexCount(size, size));
+			utilities::MeshIndicesStrips(pipeline.stripIndices.data(), size, size);
+			return true;
+		}
+		if (stage == "export") {
+			const std::filesystem::path directory(config.outputDirectory);
+			const std::string name = "map_" + std::to_string(size);
+			if (!pipeline.heightMap || !utilities::WriteHeightPgm((directory / (name + "_height.pgm")).string(), pipeline.heightMap, size, size)) {
+				return false;
+			}
+			if (pipeline.biomeGen.IsGenerated()) {
+				return utilities::WriteBiomePgm((directory / (name + "_biome.pgm")).string(), pipeline.biomeGen.GetBiomeMap(), size, size);
+			}
+			return true;
+		}
+		std::cout << "[ERROR] Unknown stage: " << stage << "\n";
+		return false;
+	}
+
+	bool WriteReport(const std::string& path, const std::vector<StageRecord>& records, bool peakPerStage)
+	{
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			std::cout << "[ERROR] Could not open scenario report: " << path << "\n";
+			return false;
+		}
+		file << std::setprecision(9);
+		file << "{\n  \"suite\": \"pipeline scenarios\",\n  \"threads\": " << utilities::GetWorkerCount()
+			<< ",\n  \"peakMemoryPerStage\": " << (peakPerStage ? "true" : "false") << ",\n  \"stages\": [\n";
+		for (size_t i = 0; i < records.size(); i++) {
+			const StageRecord& r = records[i];
+			file << "    {\"size\": " << r.size << ", \"stage\": \"" << utilities::BenchmarkSuite::EscapeJson(r.stage) << "\", \"ms\": " << r.milliseconds
+				<< ", \"peakMemoryBytes\": " << r.peakMemory << ", \"allocations\": " << r.allocations << ", \"allocatedBytes\": " << r.allocatedBytes
+				<< ", \"scratchBytes\": " << r.scratchBytes << ", \"succeeded\": " << (r.succeeded ? "true" : "false") << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+		}
+		file << "  ]\n}\n";
+		return file.good();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	ScenarioConfig config;
+	if (!ParseArguments(argc, argv, config)) {
+		return 1;
+	}
+	utilities::SetWorkerCount(config.threads);
+	utilities::SetTraceThreadName("Main");
+
+	std::error_code error;
+	std::filesystem::create_directories(config.outputDirectory, error);
+
+	std::vector<StageRecord> records;
+	bool peakPerStage = true;
+
+	std::cout << std::left << std::setw(8) << "size" << std::setw(10) << "stage" << std::right << std::setw(12) << "ms"
+		<< std::setw(14) << "peak RSS MB" << std::setw(14) << "allocations" << std::setw(14) << "allocated MB" << std::setw(12) << "scratch MB" << "\n";
+	for (int size : config.sizes) {
+		auto pipeline = std::make_unique<Pipeline>();
+		pipeline->size = size;
+		double total = 0.0;
+
+		for (const std::string& stage : config.stages) {
+			peakPerStage &= utilities::ResetPeakResidentMemory();
+			utilities::ResetScratchHighWaterMark();
+			const size_t allocationsBefore = allocationCount.load();
+			const size_t bytesBefore = allocatedBytes.load();
+
+			//Log of the kernels is kept out of the report
+			utilities::SetLogSink(nullptr);
+			auto start = std::chrono::high_resolution_clock::now();
+			bool succeeded = false;
+			{
+				//Stage names live in the config until the trace is written
+				TRACE_ZONE(stage.c_str());
+				succeeded = RunStage(stage, *pipeline, config);
+			}
+			std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+			utilities::SetLogSink(&std::cout);
+
+			StageRecord record{ size, stage, duration.count(), utilities::GetPeakResidentMemory(),
+				allocationCount.load() - allocationsBefore, allocatedBytes.load() - bytesBefore, utilities::GetScratchHighWaterMark(), succeeded };
+			records.push_back(record);
+			total += record.milliseconds;
+
+			std::cout << std::left << std::setw(8) << size << std::setw(10) << stage << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(12) << record.milliseconds << std::setw(14) << record.peakMemory / (1024.0 * 1024.0)
+				<< std::setw(14) << record.allocations << std::setw(14) << record.allocatedBytes / (1024.0 * 1024.0)
+				<< std::setw(12) << record.scratchBytes / (1024.0 * 1024.0)
+				<< (succeeded ? "" : "  FAILED") << "\n";
+		}
+		std::cout << std::left << std::setw(8) << size << std::setw(10) << "total" << std::right << std::setw(12) << total << "\n";
+		std::cout.unsetf(std::ios::floatfield);
+	}
+
+	if (!peakPerStage) {
+		std::cout << "[LOG] Peak memory could not be reset between stages, reported values are the peak of the process\n";
+	}
+	if (!config.jsonPath.empty() && !WriteReport(config.jsonPath, records, peakPerStage)) {
+		return 1;
+	}
+	if (!config.tracePath.empty() && !utilities::WriteChromeTrace(config.tracePath)) {
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,408 @@
+//Headless batch generator, writes heightmaps and biome maps of a range of tiles to disk without a window or GPU.
+//Builds as a separate executable from the GL-free core, no OpenGL, GLFW or ImGui code is linked:
+//	terrainGeneration/Noise.cpp, TerrainGenerator.cpp, Biome.cpp, BiomeGenerator.cpp, Erosion.cpp
+//	utility/utilities.cpp, NormalMap.cpp, HeightPyramid.cpp, MapExport.cpp, JobSystem.cpp, ScratchArena.cpp, Trace.cpp, Log.cpp
+//	(Parallel.h, Grid.h and CurveLut.h are header only)
+//	vendor/Simplex/SimplexNoise.cpp
+//Include directories are the same as the application: src/vendor, src/terrainGeneration and src/utility.
+//
+//Usage: TerrainGenCli [--config world.ini] [--seed N] [--tiles x0:x1,y0:y1] [--tile-size N] [--threads N]
+//	[--out directory] [--format pgm|raw] [--biomes] [--trace trace.json] [--log-level debug|info|warning|error|none]
+//Tiles are generated with origins (x * tileSize, y * tileSize), so neighbouring tiles share the same continuous world.
+
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "TerrainGenerator.h"
+#include "BiomeGenerator.h"
+#include "MapExport.h"
+#include "Parallel.h"
+#include "Trace.h"
+#include "Log.h"
+
+namespace
+{
+	enum class OutputFormat {
+		PGM,
+		RAW
+	};
+
+	//World description read from the config file and the command line
+	//@param sections: Sections of the config file by name, key -> value
+	//@param seed: World seed added to the seed of every noise, 0 keeps the seeds of the config
+	//@param tileX0, tileX1, tileY0, tileY1: Inclusive range of generated tiles
+	struct WorldConfig {
+		std::map<std::string, std::map<std::string, std::string>> sections;
+		int seed = 0;
+		int tileSize = 512;
+		int tileX0 = 0, tileX1 = 0, tileY0 = 0, tileY1 = 0;
+		int threads = 0;
+		bool biomes = false;
+		int blendRadius = 0;
+		TerrainGenerator::EvaluationMethod evaluation = TerrainGenerator::EvaluationMethod::LINEAR_COMBINE;
+		OutputFormat format = OutputFormat::PGM;
+		std::string outputDirectory = "out";
+		std::string tracePath;
+	};
+
+	std::string Trim(const std::string& s)
+	{
+		const size_t begin = s.find_first_not_of(" \t\r\n");
+		if (begin == std::string::npos) {
+			return "";
+		}
+		const size_t end = s.find_last_not_of(" \t\r\n");
+		return s.substr(begin, end - begin + 1);
+	}
+
+	//Reads an INI file, lines "key = value" are stored under the last "[section]", ';' and '#' start a comment
+	bool LoadIni(const std::string& path, std::map<std::string, std::map<std::string, std::string>>& sections)
+	{
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			std::cout << "[ERROR] Could not open config file: " << path << "\n";
+			return false;
+		}
+
+		std::string line, section;
+		int lineNumber = 0;
+		while (std::getline(file, line)) {
+			lineNumber++;
+			line = Trim(line.substr(0, line.find_first_of(";#")));
+			if (line.empty()) {
+				continue;
+			}
+			if (line.front() == '[' && line.back() == ']') {
+				section = Trim(line.substr(1, line.size() - 2));
+				continue;
+			}
+			const size_t separator = line.find('=');
+			if (separator == std::string::npos) {
+				std::cout << "[ERROR] " << path << ":" << lineNumber << " expected key = value\n";
+				return false;
+			}
+			sections[section][Trim(line.substr(0, separator))] = Trim(line.substr(separator + 1));
+		}
+		return true;
+	}
+
+	bool ParseBool(const std::string& value)
+	{
+		return value == "1" || value == "true" || value == "yes" || value == "on";
+	}
+
+	//Applies the keys of one config section onto the noise parameters, unknown keys are reported and skipped
+	bool ApplyNoiseSection(const std::map<std::string, std::string>& section, noise::NoiseConfigParameters& config)
+	{
+		static const std::map<std::string, noise::Options> options = {
+			{ "refit_all", noise::Options::REFIT_ALL }, { "flatten_negatives", noise::Options::FLATTEN_NEGATIVES },
+			{ "revert_negatives", noise::Options::REVERT_NEGATIVES }, { "nothing", noise::Options::NOTHING }
+		};
+		static const std::map<std::string, noise::IslandType> islandTypes = {
+			{ "cone", noise::IslandType::CONE }, { "diagonal", noise::IslandType::DIAGONAL },
+			{ "euclidean_squared", noise::IslandType::EUCLIDEAN_SQUARED }, { "square_bump", noise::IslandType::SQUARE_BUMP },
+			{ "hyperboloid", noise::IslandType::HYPERBOLOID }, { "squircle", noise::IslandType::SQUIRCLE }, { "trig", noise::IslandType::TRIG }
+		};
+
+		try {
+			for (const auto& [key, value] : section) {
+				if (key == "seed") config.seed = std::stoi(value);
+				else if (key == "octaves") config.octaves = std::stoi(value);
+				else if (key == "resolution") config.resolution = std::stoi(value);
+				else if (key == "xoffset") config.xoffset = std::stof(value);
+				else if (key == "yoffset") config.yoffset = std::stof(value);
+				else if (key == "scale") config.scale = std::stof(value);
+				else if (key == "contrast") config.constrast = std::stof(value);
+				else if (key == "redistribution") config.redistribution = std::stof(value);
+				else if (key == "lacunarity") config.lacunarity = std::stof(value);
+				else if (key == "persistance") config.persistance = std::stof(value);
+				else if (key == "revertGain") config.revertGain = std::stof(value);
+				else if (key == "ridge") config.Ridge = ParseBool(value);
+				else if (key == "ridgeGain") config.RidgeGain = std::stof(value);
+				else if (key == "ridgeOffset") config.RidgeOffset = std::stof(value);
+				else if (key == "island") config.island = ParseBool(value);
+				else if (key == "mixPower") config.mixPower = std::stof(value);
+				else if (key == "symmetrical") config.symmetrical = ParseBool(value);
+				else if (key == "negatives" && options.count(value)) config.option = options.at(value);
+				else if (key == "islandType" && islandTypes.count(value)) config.islandType = islandTypes.at(value);
+				else {
+					std::cout << "[ERROR] Unknown noise key or value: " << key << " = " << value << "\n";
+				}
+			}
+		}
+		catch (const std::exception&) {
+			std::cout << "[ERROR] Invalid number in noise config\n";
+			return false;
+		}
+		return true;
+	}
+
+	bool ApplyWorldSection(const std::map<std::string, std::string>& section, WorldConfig& world)
+	{
+		static const std::map<std::string, TerrainGenerator::EvaluationMethod> methods = {
+			{ "linear", TerrainGenerator::EvaluationMethod::LINEAR_COMBINE }, { "spline", TerrainGenerator::EvaluationMethod::SPLINE_COMBINE },
+			{ "ridged", TerrainGenerator::EvaluationMethod::RIDGED_COMBINE }, { "terraced", TerrainGenerator::EvaluationMethod::TERRACED_COMBINE }
+		};
+
+		try {
+			for (const auto& [key, value] : section) {
+				if (key == "seed") world.seed = std::stoi(value);
+				else if (key == "tileSize") world.tileSize = std::stoi(value);
+				else if (key == "biomes") world.biomes = ParseBool(value);
+				else if (key == "blendRadius") world.blendRadius = std::stoi(value);
+				else if (key == "evaluation" && methods.count(value)) world.evaluation = methods.at(value);
+				else {
+					std::cout << "[ERROR] Unknown world key or value: " << key << " = " << value << "\n";
+				}
+			}
+		}
+		catch (const std::exception&) {
+			std::cout << "[ERROR] Invalid number in world config\n";
+			return false;
+		}
+		return true;
+	}
+
+	//Parses "x0:x1,y0:y1", a single number instead of a range selects one tile
+	bool ParseTileRange(const std::string& value, WorldConfig& world)
+	{
+		auto parseRange = [](const std::string& range, int& first, int& last) {
+			const size_t colon = range.find(':');
+			try {
+				first = std::stoi(range.substr(0, colon));
+				last = colon == std::string::npos ? first : std::stoi(range.substr(colon + 1));
+			}
+			catch (const std::exception&) {
+				return false;
+			}
+			return first <= last;
+		};
+
+		const size_t comma = value.find(',');
+		if (comma == std::string::npos || !parseRange(value.substr(0, comma), world.tileX0, world.tileX1) ||
+			!parseRange(value.substr(comma + 1), world.tileY0, world.tileY1)) {
+			std::cout << "[ERROR] Invalid tile range: " << value << ", expected x0:x1,y0:y1\n";
+			return false;
+		}
+		return true;
+	}
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: TerrainGenCli [options]\n"
+			"  --config <file>        INI world config, sections [world], [continentalness], [mountainousness],\n"
+			"                         [weirdness], [temperature], [humidity]\n"
+			"  --seed <n>             world seed added to the seed of every noise\n"
+			"  --tiles <x0:x1,y0:y1>  inclusive range of tiles, default 0:0,0:0\n"
+			"  --tile-size <n>        tile width and height in samples, default 512\n"
+			"  --threads <n>          number of worker threads, default all hardware threads\n"
+			"  --out <directory>      output directory, default out\n"
+			"  --format <pgm|raw>     16 bit PGM or raw 32 bit float heightmaps, default pgm\n"
+			"  --biomes               also generate biomes, shape the terrain by them and write biome id maps\n"
+			"  --trace <file>         write a Chrome trace of the generation stages\n"
+			"  --log-level <level>    debug, info, warning, error or none, default info\n";
+	}
+
+	bool ParseLogLevel(const std::string& value)
+	{
+		static const std::map<std::string, utilities::LogLevel> levels = {
+			{ "debug", utilities::LogLevel::DEBUG }, { "info", utilities::LogLevel::INFO }, { "warning", utilities::LogLevel::WARNING },
+			{ "error", utilities::LogLevel::ERR }, { "none", utilities::LogLevel::NONE }
+		};
+		auto level = levels.find(value);
+		if (level == levels.end()) {
+			std::cout << "[ERROR] Unknown log level: " << value << "\n";
+			return false;
+		}
+		utilities::SetLogLevel(level->second);
+		return true;
+	}
+
+	//Command line options override the config file
+	bool ParseArguments(int argc, char** argv, WorldConfig& world)
+	{
+		std::vector<std::string> args(argv + 1, argv + argc);
+		auto config = std::find(args.begin(), args.end(), "--config");
+		if (config != args.end() && config + 1 != args.end()) {
+			if (!LoadIni(*(config + 1), world.sections) || !ApplyWorldSection(world.sections["world"], world)) {
+				return false;
+			}
+		}
+
+		try {
+			for (size_t i = 0; i < args.size(); i++) {
+				const std::string& arg = args[i];
+				const bool hasValue = i + 1 < args.size();
+				if (arg == "--biomes") world.biomes = true;
+				else if (arg == "--help" || arg == "-h") { PrintUsage(); return false; }
+				else if (!hasValue) { std::cout << "[ERROR] Missing value of " << arg << "\n"; return false; }
+				else if (arg == "--config") i++;
+				else if (arg == "--seed") world.seed = std::stoi(args[++i]);
+				else if (arg == "--tile-size") world.tileSize = std::stoi(args[++i]);
+				else if (arg == "--threads") world.threads = std::stoi(args[++i]);
+				else if (arg == "--out") world.outputDirectory = args[++i];
+				else if (arg == "--tiles") { if (!ParseTileRange(args[++i], world)) return false; }
+				else if (arg == "--trace") world.tracePath = args[++i];
+				else if (arg == "--log-level") { if (!ParseLogLevel(args[++i])) return false; }
+				else if (arg == "--format") world.format = args[++i] == "raw" ? OutputFormat::RAW : OutputFormat::PGM;
+				else { std::cout << "[ERROR] Unknown option: " << arg << "\n"; PrintUsage(); return false; }
+			}
+		}
+		catch (const std::exception&) {
+			std::cout << "[ERROR] Invalid number in command line\n";
+			return false;
+		}
+
+		if (world.tileSize <= 0) {
+			std::cout << "[ERROR] Tile size must be greater than 0\n";
+			return false;
+		}
+		return true;
+	}
+
+	//Copies the config of a noise section onto the noise and offsets its seed by the world seed
+	bool ConfigureNoise(const WorldConfig& world, const std::string& name, noise::NoiseConfigParameters& config)
+	{
+		auto section = world.sections.find(name);
+		if (section != world.sections.end() && !ApplyNoiseSection(section->second, config)) {
+			return false;
+		}
+		config.seed += world.seed;
+		return true;
+	}
+
+	//Generators of one worker, every worker owns its own so tiles are generated concurrently
+	struct TileWorker {
+		TerrainGenerator terrainGen;
+		BiomeGenerator biomeGen;
+
+		bool Initialize(const WorldConfig& world)
+		{
+			if (!terrainGen.Initialize(world.tileSize, world.tileSize)) {
+				return false;
+			}
+			terrainGen.SetEvaluationMethod(world.evaluation);
+			if (!ConfigureNoise(world, "continentalness", terrainGen.GetSelectedNoiseConfig(TerrainGenerator::WorldGenParameter::CONTINENTALNESS)) ||
+				!ConfigureNoise(world, "mountainousness", terrainGen.GetSelectedNoiseConfig(TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS)) ||
+				!ConfigureNoise(world, "weirdness", terrainGen.GetSelectedNoiseConfig(TerrainGenerator::WorldGenParameter::WEIRDNESS))) {
+				return false;
+			}
+			if (!world.biomes) {
+				return true;
+			}
+
+			if (!biomeGen.Initialize(world.tileSize, world.tileSize)) {
+				return false;
+			}
+			biomeGen.GetBlendRadiusRef() = world.blendRadius;
+			if (!ConfigureNoise(world, "temperature", biomeGen.GetTemperatureNoiseConfig()) ||
+				!ConfigureNoise(world, "humidity", biomeGen.GetHumidityNoiseConfig())) {
+				return false;
+			}
+			terrainGen.ClearBiomeHeightCurves();
+			for (const auto& it : biomeGen.GetBiomes()) {
+				terrainGen.SetBiomeHeightCurve(it.first, it.second.GetHeightCurve());
+			}
+			return true;
+		}
+
+		//Generates one tile, biomes are assigned from the component noises sampled at the same origin as the terrain
+		bool Generate(const WorldConfig& world, int tileX, int tileY)
+		{
+			TRACE_ZONE("Generate tile");
+			const float originx = static_cast<float>(tileX) * world.tileSize;
+			const float originy = static_cast<float>(tileY) * world.tileSize;
+
+			terrainGen.SetBiomeMap(nullptr, nullptr);
+			if (world.biomes) {
+				if (!terrainGen.GenerateNoises(originx, originy) || !biomeGen.GenerateComponentNoises(originx, originy)) {
+					return false;
+				}
+				if (!biomeGen.Biomify(terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::CONTINENTALNESS),
+					terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS),
+					terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::WEIRDNESS))) {
+					return false;
+				}
+				if (biomeGen.GetBlendRadiusRef() > 0) {
+					biomeGen.BlendBiomes();
+				}
+				terrainGen.SetBiomeMap(biomeGen.GetBiomeMap(), biomeGen.GetBiomeWeights());
+			}
+			return terrainGen.GenerateTerrain(originx, originy);
+		}
+
+		bool Write(const WorldConfig& world, int tileX, int tileY)
+		{
+			TRACE_ZONE("Write tile");
+			const std::filesystem::path directory(world.outputDirectory);
+			const std::string name = "tile_" + std::to_string(tileX) + "_" + std::to_string(tileY);
+			const int size = world.tileSize;
+
+			bool written = world.format == OutputFormat::RAW ?
+				utilities::WriteHeightRaw((directory / (name + "_height.r32")).string(), terrainGen.GetHeightMap(), size, size) :
+				utilities::WriteHeightPgm((directory / (name + "_height.pgm")).string(), terrainGen.GetHeightMap(), size, size);
+			if (written && world.biomes) {
+				written = utilities::WriteBiomePgm((directory / (name + "_biome.pgm")).string(), biomeGen.GetBiomeMap(), size, size);
+			}
+			if (!written) {
+				LOG_ERROR("Could not write tile " << name << " to " << world.outputDirectory);
+			}
+			return written;
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	WorldConfig world;
+	if (!ParseArguments(argc, argv, world)) {
+		return 1;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(world.outputDirectory, error);
+	if (error) {
+		std::cout << "[ERROR] Could not create output directory: " << world.outputDirectory << "\n";
+		return 1;
+	}
+
+	utilities::SetWorkerCount(world.threads);
+	utilities::SetTraceThreadName("Main");
+
+	const int tilesX = world.tileX1 - world.tileX0 + 1;
+	const int tileCount = tilesX * (world.tileY1 - world.tileY0 + 1);
+	std::atomic<int> failed{ 0 };
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//Every band of tiles is generated by its own worker, bands of one tile spread tiles over all of the threads
+	utilities::ParallelFor(0, tileCount, [&](int bandBegin, int bandEnd) {
+		TileWorker worker;
+		if (!worker.Initialize(world)) {
+			failed += bandEnd - bandBegin;
+			return;
+		}
+		for (int i = bandBegin; i < bandEnd; i++) {
+			const int tileX = world.tileX0 + i % tilesX;
+			const int tileY = world.tileY0 + i / tilesX;
+			if (!worker.Generate(world, tileX, tileY) || !worker.Write(world, tileX, tileY)) {
+				failed++;
+			}
+		}
+	}, 1);
+
+	std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+	utilities::FlushLog();
+	std::cout << "[LOG] Generated " << tileCount - failed.load() << "/" << tileCount << " tiles of " << world.tileSize << "x" << world.tileSize
+		<< " on " << utilities::GetWorkerCount() << " threads in " << duration.count() << " ms\n";
+	if (!world.tracePath.empty() && !utilities::WriteChromeTrace(world.tracePath)) {
+		return 1;
+	}
+	return failed.load() == 0 ? 0 : 1;
+}
@@ -1,5 +1,9 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "utility/utilities.h"
+
+#include <map>
+#include <vector>
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : m_Count(count)
 {
@@ -33,3 +37,22 @@ void IndexBuffer::UpdateData(const unsigned int* data, unsigned int count)
     GLCALL(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, count * sizeof(unsigned int), data));
 }
 
+
+
+//Returns the index buffer of a width x height vertex grid drawn as restart separated triangle strips.
+//Buffers are shared, every mesh or chunk of the same resolution uses the same one while any owner keeps it alive
+//@param width - number of vertices in a row
+//@param height - number of rows
+std::shared_ptr<IndexBuffer> IndexBuffer::GetStripGrid(int width, int height)
+{
+    static std::map<std::pair<int, int>, std::weak_ptr<IndexBuffer>> grids;
+    std::weak_ptr<IndexBuffer>& cached = grids[{ width, height }];
+    if (std::shared_ptr<IndexBuffer> buffer = cached.lock()) {
+        return buffer;
+    }
+    std::vector<unsigned int> indices(utilities::GetStripIndexCount(width, height));
+    utilities::MeshIndicesStrips(indices.data(), width, height);
+    std::shared_ptr<IndexBuffer> buffer = std::make_shared<IndexBuffer>(indices.data(), static_cast<unsigned int>(indices.size()));
+    cached = buffer;
+    return buffer;
+}
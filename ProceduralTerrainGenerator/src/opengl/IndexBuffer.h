@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 class  IndexBuffer
 {
 private:
@@ -15,4 +17,6 @@ public:
 	void UpdateData(const unsigned int* data, unsigned int count);
 
 	inline unsigned int GetCount() const { return m_Count; }
+
+	static std::shared_ptr<IndexBuffer> GetStripGrid(int width, int height);
 };
@@ -22,14 +22,46 @@ void Renderer::DrawTriangles(const VertexArray& va, const IndexBuffer& ib, const
 
 	glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr);
 }
-void Renderer::DrawTriangleStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int numStrips, int numVertPerStrip) const {
+//@param baseInstance - first element of the instance buffers read by the draw, f.e. StreamingVertexBuffer::GetBaseElement
+void Renderer::DrawTrianglesInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int instanceCount, unsigned int baseInstance) const {
+	shader.Bind();
+	va.Bind();
+	ib.Bind();
+
+	glDrawElementsInstancedBaseInstance(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr, instanceCount, baseInstance);
+}
+//Draws restart separated triangle strips (see utilities::MeshIndicesStrips) with a single call
+void Renderer::DrawTriangleStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const {
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glDrawElements(GL_TRIANGLE_STRIP, ib.GetCount(), GL_UNSIGNED_INT, nullptr);
+}
+void Renderer::DrawTriangleStripsInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int instanceCount, unsigned int baseInstance) const {
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLE_STRIP, ib.GetCount(), GL_UNSIGNED_INT, nullptr, instanceCount, baseInstance);
+}
+//Draws a batch of equal sized chunks stored in one vertex buffer with a single call, every chunk reuses the same strip indices
+//@param baseVertices - index of the first vertex of every chunk in the vertex buffer
+void Renderer::MultiDrawTriangleStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const std::vector<int>& baseVertices) const {
+    if (baseVertices.empty()) {
+        return;
+    }
     shader.Bind();
     va.Bind();
     ib.Bind();
 
-    for(unsigned int i = 0; i < numStrips; i++) {
-       glDrawElements(GL_TRIANGLE_STRIP, numVertPerStrip, GL_UNSIGNED_INT, (void*)(sizeof(unsigned) * (numVertPerStrip) * i));
-	}
+    std::vector<GLsizei> counts(baseVertices.size(), ib.GetCount());
+    std::vector<void*> offsets(baseVertices.size(), nullptr);
+    std::vector<GLint> bases(baseVertices.begin(), baseVertices.end());
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(bases.size()), bases.data());
 }
 
 void Renderer::DrawPatches(const VertexArray& va, const Shader& shader, int numPatches, int numPatchPts) const
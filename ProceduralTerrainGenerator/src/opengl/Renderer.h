@@ -12,6 +12,7 @@
 	x;\
 	ASSERT(GLLogCall(#x, __FILE__,__LINE__));
 #include <ostream>
+#include <vector>
 
 void GLClearError();
 
@@ -23,7 +24,10 @@ public:
 	void SetPatches(int numVertsPerPatch) {	glPatchParameteri(GL_PATCH_VERTICES, numVertsPerPatch);}
 
 	void DrawTriangles(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
-	void DrawTriangleStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int numStrips, int numVertPerStrip) const;
+	void DrawTrianglesInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int instanceCount, unsigned int baseInstance = 0) const;
+	void DrawTriangleStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+	void DrawTriangleStripsInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int instanceCount, unsigned int baseInstance = 0) const;
+	void MultiDrawTriangleStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const std::vector<int>& baseVertices) const;
 	void DrawPatches(const VertexArray& va, const Shader& shader, int numPatches, int numPatchPts) const;
 	void Clear(glm::vec3 color) const;
 };
\ No newline at end of file
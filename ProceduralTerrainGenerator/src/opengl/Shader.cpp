@@ -122,6 +122,11 @@ void Shader::SetUniform1f(const std::string& name, float value)
     glUniform1f(GetUniformLocation(name), value);
 }
 
+void Shader::SetUniform2f(const std::string& name, float v0, float v1)
+{
+    glUniform2f(GetUniformLocation(name), v0, v1);
+}
+
 void Shader::SetUniform1i(const std::string& name, int value)
 {
 	glUniform1i(GetUniformLocation(name), value);
@@ -21,6 +21,7 @@ public:
 
 	//uniforms
 	void SetUniform1f(const std::string& name, float value);
+	void SetUniform2f(const std::string& name, float v0, float v1);
 	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
 	void SetUniform1i(const std::string& name, int value);
 	void SetUniform3fv(const std::string& name, glm::vec3 v);
@@ -0,0 +1,114 @@
+#include "StreamingVertexBuffer.h"
+#include "Renderer.h"
+#include "utility/Log.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+//@param elementSize - size of one vertex or instance in bytes
+//@param capacity - number of elements of a single frame region
+//@param frameCount - number of regions used in turn, 3 lets the CPU run two frames ahead of the GPU
+StreamingVertexBuffer::StreamingVertexBuffer(unsigned int elementSize, unsigned int capacity, unsigned int frameCount) :
+	m_ElementSize(elementSize), m_Capacity(0), m_FrameCount(std::max(frameCount, 1u)), m_Frame(0), m_Mapped(nullptr),
+	m_Fences(std::max(frameCount, 1u), nullptr)
+{
+	Allocate(std::max(capacity, 1u));
+}
+
+StreamingVertexBuffer::~StreamingVertexBuffer()
+{
+	for (GLsync& fence : m_Fences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	if (m_Mapped) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+}
+
+//Makes sure a frame region holds at least count elements, the capacity is at least doubled when growing
+//@return - true if the storage was recreated, vertex arrays using the buffer have to add it again
+bool StreamingVertexBuffer::Reserve(unsigned int count)
+{
+	if (count <= m_Capacity) {
+		return false;
+	}
+	Allocate(std::max(count, m_Capacity * 2));
+	return true;
+}
+
+//Advances to the next frame region and waits until the GPU is done reading it
+//@return - pointer to the region, GetCapacity() elements can be written, nullptr if the buffer is not mapped
+void* StreamingVertexBuffer::BeginFrame()
+{
+	m_Frame = (m_Frame + 1) % m_FrameCount;
+	WaitForFrame(m_Frame);
+	if (!m_Mapped) {
+		return nullptr;
+	}
+	return m_Mapped + static_cast<size_t>(m_Frame) * m_Capacity * m_ElementSize;
+}
+
+//Protects the current region with a fence, has to be called after the last draw call reading it
+void StreamingVertexBuffer::EndFrame()
+{
+	m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+//Copies count elements into the next frame region, growing the storage if needed
+//@return - index of the first written element, to be used as the base vertex or base instance of the draw call
+unsigned int StreamingVertexBuffer::Write(const void* data, unsigned int count)
+{
+	void* region = BeginFrame();
+	if (!region) {
+		return GetBaseElement();
+	}
+	if (count > m_Capacity) {
+		LOG_ERROR("Streaming buffer region too small, call Reserve before writing");
+		count = m_Capacity;
+	}
+	std::memcpy(region, data, static_cast<size_t>(count) * m_ElementSize);
+	return GetBaseElement();
+}
+
+void StreamingVertexBuffer::Allocate(unsigned int capacity)
+{
+	for (unsigned int i = 0; i < m_FrameCount; i++) {
+		WaitForFrame(i);
+	}
+	if (m_RendererID) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glDeleteBuffers(1, &m_RendererID);
+	}
+
+	m_Capacity = capacity;
+	m_Frame = 0;
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr size = static_cast<GLsizeiptr>(m_Capacity) * m_ElementSize * m_FrameCount;
+	GLCALL(glGenBuffers(1, &m_RendererID));
+	GLCALL(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+	GLCALL(glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags));
+	m_Mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+	if (!m_Mapped) {
+		LOG_ERROR("Streaming vertex buffer couldnt be mapped");
+	}
+}
+
+void StreamingVertexBuffer::WaitForFrame(unsigned int frame)
+{
+	GLsync& fence = m_Fences[frame];
+	if (!fence) {
+		return;
+	}
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+#include "VertexBuffer.h"
+
+//Vertex buffer for data rewritten every frame (instances, streamed mesh chunks).
+//Storage is created once with glBufferStorage and stays persistently and coherently mapped. It is split into
+//frameCount regions of capacity elements each, every frame writes into the next region and a fence placed after
+//the draw protects it until the GPU is done reading it, so writing never reallocates or stalls on the driver.
+//Fences are waited for and placed on the GL thread (BeginFrame / EndFrame), the pointer returned by BeginFrame
+//can be filled from any thread until the draw call is issued.
+class StreamingVertexBuffer : public VertexBuffer
+{
+private:
+	unsigned int m_ElementSize;
+	unsigned int m_Capacity;
+	unsigned int m_FrameCount;
+	unsigned int m_Frame;
+	unsigned char* m_Mapped;
+	std::vector<GLsync> m_Fences;
+
+	void Allocate(unsigned int capacity);
+	void WaitForFrame(unsigned int frame);
+public:
+	StreamingVertexBuffer(unsigned int elementSize, unsigned int capacity, unsigned int frameCount = 3);
+	~StreamingVertexBuffer();
+
+	//Storage is immutable, data is written through BeginFrame or Write
+	void UpdateData(const void* data, unsigned int size) = delete;
+
+	bool Reserve(unsigned int count);
+	void* BeginFrame();
+	void EndFrame();
+	unsigned int Write(const void* data, unsigned int count);
+
+	inline unsigned int GetCapacity() const { return m_Capacity; }
+	inline unsigned int GetBaseElement() const { return m_Frame * m_Capacity; }
+};
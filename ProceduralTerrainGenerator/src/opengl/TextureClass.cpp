@@ -2,6 +2,14 @@
 #include "stb_image/stb_image.h"
 #include "utility/utilities.h"
 #include "Renderer.h"
+#include "utility/HeightPyramid.h"
+#include "utility/NormalMap.h"
+#include "utility/Trace.h"
+#include "utility/PerfStats.h"
+#include "utility/Log.h"
+
+#include <algorithm>
+#include <cstring>
 
 TextureClass::TextureClass() :
 	m_RendererID(0), m_FilePath(""),
@@ -49,35 +57,19 @@ TextureClass::TextureClass(unsigned int height, unsigned int width, unsigned cha
 
 TextureClass::TextureClass(float* data, unsigned int width, unsigned int height): m_RendererID(0), m_FilePath(""), m_Height(height), m_Width(width), m_BPP(0), m_LocalBuffer(nullptr)
 {
-	glGenTextures(1, &m_RendererID);
-	glBindTexture(GL_TEXTURE_2D, m_RendererID);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_Width, m_Height, 0, GL_RED, GL_FLOAT, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	Update(data, width, height);
 }
 
 TextureClass::TextureClass(std::vector<glm::vec3> colorData, unsigned int width, unsigned int height) : m_RendererID(0), m_FilePath(""), m_Height(height), m_Width(width), m_BPP(0), m_LocalBuffer(nullptr)
 {
-	glGenTextures(1, &m_RendererID);
-	glBindTexture(GL_TEXTURE_2D, m_RendererID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, m_Width, m_Height, 0, GL_RGB, GL_FLOAT, colorData.data());
-	glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	Update(colorData, width, height);
 }
 
 TextureClass::~TextureClass()
 {
+	SetStorageBytes(0);
 	glDeleteTextures(1, &m_RendererID);
+	ReleasePixelBuffers();
 }
 
 void TextureClass::SetNewImage(unsigned char* image)
@@ -120,3 +112,302 @@ void TextureClass::Unbind() const
 {
 	glBindTexture(GL_TEXTURE_2D, 0);
 }
+
+
+//Replaces the whole content of a single channel float texture, storage is reallocated only if the size changed
+//@param data - width * height floats
+//@param width, height - size of the data
+bool TextureClass::Update(const float* data, int width, int height)
+{
+	if (!data || width <= 0 || height <= 0) {
+		LOG_ERROR("Invalid texture data");
+		return false;
+	}
+	if (!Allocate(width, height, GL_R32F, GL_RED, GL_FLOAT, true)) {
+		return false;
+	}
+	m_ValueMin = 0.0f;
+	m_ValueRange = 1.0f;
+	Upload(data, 0, 0, 0, width, height, width);
+	GenerateMipmaps();
+	return true;
+}
+
+//Replaces the whole content of an RGB float texture, storage is reallocated only if the size changed
+//@param colorData - width * height colours
+//@param width, height - size of the data
+bool TextureClass::Update(const std::vector<glm::vec3>& colorData, int width, int height)
+{
+	if (colorData.size() < static_cast<size_t>(std::max(width, 0)) * std::max(height, 0)) {
+		LOG_ERROR("Invalid texture data");
+		return false;
+	}
+	return Update(colorData.data(), width, height);
+}
+
+//Replaces the whole content of an RGB float texture from a buffer of width * height colours, f.e. carved from a scratch arena
+bool TextureClass::Update(const glm::vec3* colorData, int width, int height)
+{
+	if (!colorData || width <= 0 || height <= 0) {
+		LOG_ERROR("Invalid texture data");
+		return false;
+	}
+	if (!Allocate(width, height, GL_RGB32F, GL_RGB, GL_FLOAT, true)) {
+		return false;
+	}
+	m_ValueMin = 0.0f;
+	m_ValueRange = 1.0f;
+	Upload(colorData, 0, 0, 0, width, height, width);
+	GenerateMipmaps();
+	return true;
+}
+
+//Replaces the content with a 16 bit quantized heightmap, every level of the CPU built pyramid is uploaded as a mip level
+//Sampled values are normalized to [0, 1], heights are GetValueMin() + value * GetValueRange()
+//@param pyramid - quantized heightmap with its mip levels
+bool TextureClass::Update(const utilities::HeightPyramid& pyramid)
+{
+	if (pyramid.GetLevelCount() == 0) {
+		LOG_ERROR("Height pyramid is not built");
+		return false;
+	}
+	const utilities::HeightPyramidLevel& base = pyramid.GetLevel(0);
+	if (!Allocate(base.width, base.height, GL_R16, GL_RED, GL_UNSIGNED_SHORT, true)) {
+		return false;
+	}
+	m_ValueMin = pyramid.GetHeightMin();
+	m_ValueRange = pyramid.GetHeightRange();
+	for (int level = 0; level < std::min(pyramid.GetLevelCount(), m_Levels); level++) {
+		const utilities::HeightPyramidLevel& l = pyramid.GetLevel(level);
+		Upload(l.texels.data(), level, 0, 0, l.width, l.height, l.width);
+	}
+	return true;
+}
+
+//Uploads the dirty region of an octahedral normal map into an RG16_SNORM texture, the whole map after a resize
+//@param normals - normal map, its dirty region is taken and cleared
+bool TextureClass::Update(utilities::OctNormalMap& normals)
+{
+	if (!normals.IsBuilt()) {
+		return false;
+	}
+	bool reallocated = m_RendererID == 0 || m_Width != normals.GetWidth() || m_Height != normals.GetHeight() || m_InternalFormat != GL_RG16_SNORM;
+	if (!Allocate(normals.GetWidth(), normals.GetHeight(), GL_RG16_SNORM, GL_RG, GL_SHORT, false)) {
+		return false;
+	}
+	utilities::TexelRegion region = normals.TakeDirtyRegion();
+	if (reallocated) {
+		region = utilities::TexelRegion{ 0, 0, m_Width, m_Height };
+	}
+	if (region.IsEmpty()) {
+		return true;
+	}
+	Upload(normals.GetData() + (static_cast<size_t>(region.y) * m_Width + region.x) * 2, 0, region.x, region.y, region.width, region.height, m_Width);
+	return true;
+}
+
+//Uploads only the changed rectangle of a single channel float texture
+//@param data - whole map of the texture size, the rectangle is read from it
+//@param x, y - corner of the dirty rectangle in texels
+//@param regionWidth, regionHeight - size of the dirty rectangle
+bool TextureClass::UpdateRegion(const float* data, int x, int y, int regionWidth, int regionHeight)
+{
+	if (m_RendererID == 0 || m_InternalFormat != GL_R32F) {
+		LOG_ERROR("Texture region update requires an allocated float texture");
+		return false;
+	}
+	x = std::max(x, 0);
+	y = std::max(y, 0);
+	regionWidth = std::min(regionWidth, m_Width - x);
+	regionHeight = std::min(regionHeight, m_Height - y);
+	if (!data || regionWidth <= 0 || regionHeight <= 0) {
+		return false;
+	}
+	Upload(data + static_cast<size_t>(y) * m_Width + x, 0, x, y, regionWidth, regionHeight, m_Width);
+	GenerateMipmaps();
+	return true;
+}
+
+//Creates immutable storage if the texture does not exist yet or its size or format changed
+//@return - false if the size is invalid
+bool TextureClass::Allocate(int width, int height, GLenum internalFormat, GLenum format, GLenum type, bool mipmaps)
+{
+	if (width <= 0 || height <= 0) {
+		return false;
+	}
+	if (m_RendererID != 0 && m_Width == width && m_Height == height && m_InternalFormat == internalFormat) {
+		return true;
+	}
+
+	//Immutable storage can not be resized, a new texture name is needed
+	glDeleteTextures(1, &m_RendererID);
+	m_Width = width;
+	m_Height = height;
+	m_InternalFormat = internalFormat;
+	m_Format = format;
+	m_Type = type;
+	m_Levels = 1;
+	if (mipmaps) {
+		while ((std::max(width, height) >> m_Levels) > 0) {
+			m_Levels++;
+		}
+	}
+
+	glGenTextures(1, &m_RendererID);
+	glBindTexture(GL_TEXTURE_2D, m_RendererID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_Levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexStorage2D(GL_TEXTURE_2D, m_Levels, m_InternalFormat, m_Width, m_Height);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	size_t storageBytes = 0;
+	for (int level = 0; level < m_Levels; level++) {
+		storageBytes += static_cast<size_t>(std::max(m_Width >> level, 1)) * std::max(m_Height >> level, 1) * GetPixelSize();
+	}
+	SetStorageBytes(storageBytes);
+	return true;
+}
+
+//Moves the GPU memory gauge of the performance panel by the difference to the previous storage size
+void TextureClass::SetStorageBytes(size_t bytes)
+{
+	if (bytes != m_StorageBytes) {
+		utilities::AddMemoryUsage("GPU textures", static_cast<long long>(bytes) - static_cast<long long>(m_StorageBytes));
+		m_StorageBytes = bytes;
+	}
+}
+
+//Writes a rectangle of texels into a level of the existing storage
+//With streaming enabled rows are copied into the next of the two mapped pixel buffers once the GPU is done with its
+//previous transfer, the other buffer may still be read meanwhile
+//@param rowLength - distance between the rows of data in pixels
+void TextureClass::Upload(const void* data, int level, int x, int y, int regionWidth, int regionHeight, int rowLength)
+{
+	TRACE_ZONE("Texture upload");
+	const size_t pixelSize = GetPixelSize();
+	const size_t rowBytes = regionWidth * pixelSize;
+	const size_t size = rowBytes * regionHeight;
+	utilities::AddUploadBytes(size);
+	glBindTexture(GL_TEXTURE_2D, m_RendererID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	bool streamed = false;
+	if (m_Streaming && ReservePixelBuffers(size)) {
+		const int index = m_PixelBufferIndex;
+		m_PixelBufferIndex = (m_PixelBufferIndex + 1) % 2;
+		WaitForPixelBuffer(index);
+		unsigned char* mapped = m_PixelBufferData[index];
+		const unsigned char* source = static_cast<const unsigned char*>(data);
+		for (int row = 0; row < regionHeight; row++) {
+			std::memcpy(mapped + row * rowBytes, source + row * rowLength * pixelSize, rowBytes);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffers[index]);
+		glTexSubImage2D(GL_TEXTURE_2D, level, x, y, regionWidth, regionHeight, m_Format, m_Type, nullptr);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_PixelBufferFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		streamed = true;
+	}
+	if (!streamed) {
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+		glTexSubImage2D(GL_TEXTURE_2D, level, x, y, regionWidth, regionHeight, m_Format, m_Type, data);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//Copies every level of a texture created by the Update functions on the GPU, f.e. as the base a region update starts from
+//@return - false if the source has no storage
+bool TextureClass::CopyFrom(const TextureClass& source)
+{
+	if (source.m_RendererID == 0 || source.m_InternalFormat == 0) {
+		return false;
+	}
+	if (!Allocate(source.m_Width, source.m_Height, source.m_InternalFormat, source.m_Format, source.m_Type, source.m_Levels > 1)) {
+		return false;
+	}
+	for (int level = 0; level < std::min(m_Levels, source.m_Levels); level++) {
+		glCopyImageSubData(source.m_RendererID, GL_TEXTURE_2D, level, 0, 0, 0, m_RendererID, GL_TEXTURE_2D, level, 0, 0, 0,
+			std::max(m_Width >> level, 1), std::max(m_Height >> level, 1), 1);
+	}
+	m_ValueMin = source.m_ValueMin;
+	m_ValueRange = source.m_ValueRange;
+	return true;
+}
+
+//Makes sure both pixel buffers hold size bytes, the storage is immutable so a larger upload recreates them
+//@return - false if the buffers couldnt be mapped, the upload then falls back to a direct copy
+bool TextureClass::ReservePixelBuffers(size_t size)
+{
+	if (size <= m_PixelBufferCapacity) {
+		return true;
+	}
+	ReleasePixelBuffers();
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(2, m_PixelBuffers);
+	for (int i = 0; i < 2; i++) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffers[i]);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+		m_PixelBufferData[i] = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	if (!m_PixelBufferData[0] || !m_PixelBufferData[1]) {
+		LOG_ERROR("Pixel unpack buffers couldnt be mapped, textures are uploaded directly");
+		ReleasePixelBuffers();
+		m_Streaming = false;
+		return false;
+	}
+	m_PixelBufferCapacity = size;
+	m_PixelBufferIndex = 0;
+	return true;
+}
+
+//Blocks until the GPU finished the transfer from the pixel buffer
+void TextureClass::WaitForPixelBuffer(int index)
+{
+	GLsync& fence = m_PixelBufferFences[index];
+	if (!fence) {
+		return;
+	}
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+//Deleting a mapped buffer unmaps it and the driver keeps its storage until pending transfers are done,
+//so the fences are only dropped
+void TextureClass::ReleasePixelBuffers()
+{
+	for (int i = 0; i < 2; i++) {
+		if (m_PixelBufferFences[i]) {
+			glDeleteSync(m_PixelBufferFences[i]);
+			m_PixelBufferFences[i] = nullptr;
+		}
+		m_PixelBufferData[i] = nullptr;
+	}
+	if (m_PixelBuffers[0] != 0) {
+		glDeleteBuffers(2, m_PixelBuffers);
+		m_PixelBuffers[0] = m_PixelBuffers[1] = 0;
+	}
+	m_PixelBufferCapacity = 0;
+}
+
+void TextureClass::GenerateMipmaps()
+{
+	if (m_Levels > 1) {
+		glBindTexture(GL_TEXTURE_2D, m_RendererID);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+size_t TextureClass::GetPixelSize() const
+{
+	size_t channels = m_Format == GL_RGB ? 3 : m_Format == GL_RGBA ? 4 : m_Format == GL_RG ? 2 : 1;
+	size_t channelSize = m_Type == GL_FLOAT ? sizeof(float) : (m_Type == GL_UNSIGNED_SHORT || m_Type == GL_SHORT) ? sizeof(short) : sizeof(unsigned char);
+	return channels * channelSize;
+}
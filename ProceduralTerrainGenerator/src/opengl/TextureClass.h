@@ -6,6 +6,13 @@
 #include <iostream>
 #include <vector>
 
+namespace utilities { class HeightPyramid; class OctNormalMap; }
+
+//Float textures (height maps, noise previews, colour maps) and 16 bit height pyramids use immutable storage which
+//is reallocated only when the size or format changes. Regenerated data is written in place with glTexSubImage2D, either whole or as a dirty
+//rectangle, and by default streamed through two alternating pixel unpack buffers. Their storage is created once
+//with glBufferStorage for the largest upload seen and stays persistently mapped, a fence placed after every transfer
+//protects a buffer until the GPU has read it, so the upload neither reallocates nor waits for the previous one.
 class TextureClass
 {
 	private:
@@ -13,6 +20,26 @@ class TextureClass
 	std::string m_FilePath;
 	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+	GLenum m_InternalFormat = 0, m_Format = 0, m_Type = 0;
+	int m_Levels = 1;
+	bool m_Streaming = true;
+	unsigned int m_PixelBuffers[2] = { 0, 0 };
+	unsigned char* m_PixelBufferData[2] = { nullptr, nullptr };
+	GLsync m_PixelBufferFences[2] = { nullptr, nullptr };
+	size_t m_PixelBufferCapacity = 0;
+	int m_PixelBufferIndex = 0;
+	float m_ValueMin = 0.0f, m_ValueRange = 1.0f;
+	//Size of the immutable storage including the mip chain, reported to the performance panel
+	size_t m_StorageBytes = 0;
+
+	bool Allocate(int width, int height, GLenum internalFormat, GLenum format, GLenum type, bool mipmaps);
+	void Upload(const void* data, int level, int x, int y, int regionWidth, int regionHeight, int rowLength);
+	bool ReservePixelBuffers(size_t size);
+	void WaitForPixelBuffer(int index);
+	void ReleasePixelBuffers();
+	void GenerateMipmaps();
+	size_t GetPixelSize() const;
+	void SetStorageBytes(size_t bytes);
 public:
 	TextureClass();
 	TextureClass(const std::string& path);
@@ -29,4 +56,17 @@ public:
 
 	void SetNewImage(unsigned char* image);
 	void SetNewImage(const std::string& path);
+
+	bool Update(const float* data, int width, int height);
+	bool Update(const std::vector<glm::vec3>& colorData, int width, int height);
+	bool Update(const glm::vec3* colorData, int width, int height);
+	bool Update(const utilities::HeightPyramid& pyramid);
+	bool Update(utilities::OctNormalMap& normals);
+	bool UpdateRegion(const float* data, int x, int y, int regionWidth, int regionHeight);
+	bool CopyFrom(const TextureClass& source);
+	void SetStreaming(bool streaming) { m_Streaming = streaming; }
+	inline bool IsAllocated() const { return m_RendererID != 0; }
+	//Range of the values stored in a normalized texture, sampled value v means m_ValueMin + v * m_ValueRange
+	inline float GetValueMin() const { return m_ValueMin; }
+	inline float GetValueRange() const { return m_ValueRange; }
 };
@@ -28,6 +28,24 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 	}
 }
 
+//Adds per instance attributes, locations start at firstAttribute and advance once per instance
+void VertexArray::AddInstanceBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int firstAttribute)
+{
+	Bind();
+	vb.Bind();
+	const auto& elements = layout.GetElements();
+	unsigned int offset = 0;
+	for (unsigned int i = 0; i < elements.size(); i++)
+	{
+		const auto& element = elements[i];
+		GLCALL(glEnableVertexAttribArray(firstAttribute + i));
+		GLCALL(glVertexAttribPointer(firstAttribute + i, element.count, element.type,
+			element.normalized, layout.GetStride(), (const void*)offset));
+		GLCALL(glVertexAttribDivisor(firstAttribute + i, 1));
+		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
+	}
+}
+
 void VertexArray::Bind() const
 {
 	glBindVertexArray(m_RendererID);
@@ -2,8 +2,9 @@
 
 class  VertexBuffer
 {
-private:
+protected:
 	unsigned int m_RendererID;
+	VertexBuffer() : m_RendererID(0) {}
 public:
 	VertexBuffer(const void* data, unsigned int size);
 	~VertexBuffer();
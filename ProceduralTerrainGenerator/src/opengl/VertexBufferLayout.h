@@ -18,6 +18,9 @@ struct VertexBufferElement
 		case GL_FLOAT:			return 4;
 		case GL_UNSIGNED_INT:	return 4;
 		case GL_UNSIGNED_BYTE:	return 1;
+		case GL_BYTE:			return 1;
+		case GL_UNSIGNED_SHORT:	return 2;
+		case GL_SHORT:			return 2;
 		}
 		ASSERT(false);
 		return 0;
@@ -58,6 +61,28 @@ public:
 		m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE)*count;
 	}
 
+	//Integer types below are normalized, shader reads them as floats in [0, 1] or [-1, 1]
+	template<>
+	void Push<signed char>(unsigned int count)
+	{
+		m_Elements.push_back({ GL_BYTE, count, GL_TRUE });
+		m_Stride += VertexBufferElement::GetSizeOfType(GL_BYTE) * count;
+	}
+
+	template<>
+	void Push<unsigned short>(unsigned int count)
+	{
+		m_Elements.push_back({ GL_UNSIGNED_SHORT, count, GL_TRUE });
+		m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_SHORT) * count;
+	}
+
+	template<>
+	void Push<short>(unsigned int count)
+	{
+		m_Elements.push_back({ GL_SHORT, count, GL_TRUE });
+		m_Stride += VertexBufferElement::GetSizeOfType(GL_SHORT) * count;
+	}
+
 	inline const std::vector<VertexBufferElement> GetElements() const { return m_Elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
 };
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "imgui/imgui.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "PerfStats.h"
+#include "Log.h"
 
 NoiseBasedGenerationSys::NoiseBasedGenerationSys() : noise(), erosion(1, 1), vertices(nullptr),
 width(0), height(0), heightScale(1.0f), modelScale(1.0f), topoBandWidth(0.2f), topoStep(10.0f), stride(5), mapResolution(50)
@@ -36,13 +38,17 @@ bool NoiseBasedGenerationSys::Initialize(int _height, int _width, float _heightS
 	utilities::GenerateVerticesForResolution(vertices, height*4, width*4, mapResolution, stride, 0, 3);
 	mainVertexBuffer = std::make_unique<VertexBuffer>(vertices, (mapResolution * mapResolution) * stride * 4 * sizeof(float));
 	mainVAO->AddBuffer(*mainVertexBuffer, layout);
+	terrainTexture = std::make_unique<TextureClass>();
+	erosionTexture = std::make_unique<TextureClass>();
+	terrainNormalTexture = std::make_unique<TextureClass>();
+	erosionNormalTexture = std::make_unique<TextureClass>();
 
 	if(!GenerateNoise(0.0f, 0.0f)) {
-		std::cout << "[ERROR] Invalid height or width value" << std::endl;
+		LOG_ERROR("Invalid height or width value");
 		return false;
 	}
 
-	std::cout << "[LOG] NoiseBasedGenerationSys initialized\n";
+	LOG_INFO("NoiseBasedGenerationSys initialized");
 	return true;
 }
 
@@ -59,36 +65,63 @@ bool NoiseBasedGenerationSys::Resize()
 bool NoiseBasedGenerationSys::GenerateNoise(float originx, float originy)
 {
 	Resize();
-	if (!noise.GenerateFractalNoise(originx, originy)) {
-		return false;
+	{
+		utilities::StageTimer timer("Noise");
+		if (!noise.GenerateFractalNoise(originx, originy)) {
+			return false;
+		}
 	}
 
-	terrainTexture = std::make_unique<TextureClass>(noise.GetMap(), width, height);
-	std::cout << "[LOG] Noise based terrain initialized" << std::endl;
+	terrainTexture->Update(noise.GetMap(), width, height);
+	{
+		utilities::StageTimer timer("Normals");
+		terrainNormals.Build(noise.GetMap(), width, height, heightScale * width);
+	}
+	ReportMemoryUsage();
+	LOG_INFO("Noise based terrain initialized");
 	return true;
 }
 
 bool NoiseBasedGenerationSys::SimulateErosion()
 {
 	if(width <=1 || height <= 1) {
-		std::cout << "[ERROR] Invalid height or width value" << std::endl;
+		LOG_ERROR("Invalid height or width value");
 		return false;
 	}
 	if (!noise.GetMap()) {
-		std::cout << "[ERROR] Noise map not initialized" << std::endl;
+		LOG_ERROR("Noise map not initialized");
 		return false;
 	}
 	if(height != erosion.GetHeight() || width != erosion.GetWidth()) {
 		erosion.Resize(width, height);
 	}
 
-	erosion.SetMap(noise.GetMap());
-	erosion.Erode(std::nullopt);
+	{
+		utilities::StageTimer timer("Erosion");
+		erosion.SetMap(noise.GetView());
+		erosion.Erode(std::nullopt);
+	}
 	erosion.DontChangeMap();
 	erosionDraw = true;
-	erosionTexture = std::make_unique<TextureClass>(erosion.GetMap(), width, height);
 
-	std::cout << "[LOG] Erosion simulated successfully" << std::endl;
+	//Eroded map starts as the noise map, the terrain texture is copied on the GPU and only the changed texels are
+	//uploaded and re-encoded into the normals
+	utilities::TexelRegion changed = utilities::FindChangedRegion(noise.GetMap(), erosion.GetMap(), width, height);
+	if (erosionTexture->CopyFrom(*terrainTexture)) {
+		if (!changed.IsEmpty()) {
+			erosionTexture->UpdateRegion(erosion.GetMap(), changed.x, changed.y, changed.width, changed.height);
+		}
+	}
+	else {
+		erosionTexture->Update(erosion.GetMap(), width, height);
+	}
+	erosionNormals = terrainNormals;
+	if (!changed.IsEmpty()) {
+		erosionNormals.Update(erosion.GetMap(), changed.x, changed.y, changed.width, changed.height);
+	}
+	ReportMemoryUsage();
+
+	LOG_INFO("Erosion simulated successfully");
 	return true;
 }
 
@@ -114,6 +147,7 @@ void NoiseBasedGenerationSys::Draw(Renderer& renderer, Camera& camera, LightSour
 	mainShader->SetUniform1f("heightScale", heightScale);
 
 	terrainTexture->Bind(0);
+	BindNormals(terrainNormals, *terrainNormalTexture, noise.GetMap(), 2);
 	renderer.DrawPatches(*mainVAO, *mainShader, mapResolution * mapResolution, 4);
 
 	if (erosionDraw) {
@@ -121,10 +155,27 @@ void NoiseBasedGenerationSys::Draw(Renderer& renderer, Camera& camera, LightSour
 		mainShader->SetModel(model);
 		erosionTexture->Bind(1);
 		mainShader->SetUniform1i("heightMap", 1);
+		BindNormals(erosionNormals, *erosionNormalTexture, erosion.GetMap(), 3);
 		renderer.DrawPatches(*mainVAO, *mainShader, mapResolution * mapResolution, 4);
 	}
 }
 
+//Uploads the dirty part of the normal map and binds it for the next draw, slopes are stored scaled,
+//so the whole map is re-encoded after a height scale change
+void NoiseBasedGenerationSys::BindNormals(utilities::OctNormalMap& normals, TextureClass& texture, const float* map, unsigned int slot)
+{
+	bool useNormalMap = precomputedNormals && normals.IsBuilt() && normals.GetWidth() == width && normals.GetHeight() == height;
+	if (useNormalMap) {
+		if (normals.GetSlopeScale() != heightScale * width) {
+			normals.Build(map, width, height, heightScale * width);
+		}
+		texture.Update(normals);
+		texture.Bind(slot);
+		mainShader->SetUniform1i("normalMap", slot);
+	}
+	mainShader->SetUniform1i("useNormalMap", useNormalMap);
+}
+
 void NoiseBasedGenerationSys::ImGuiRightPanel()
 {
 	if(utilities::MapSizeImGui(width, height)) {
@@ -158,6 +209,7 @@ void NoiseBasedGenerationSys::ImGuiLeftPanel()
 		mainShader->Bind();
 		mainShader->SetUniform1i("displayMode", static_cast<int>(displayMode));
 	}
+	ImGui::Checkbox("Precomputed normal map", &precomputedNormals);
 }
 
 void NoiseBasedGenerationSys::ErosionImGui()
@@ -177,6 +229,7 @@ void NoiseBasedGenerationSys::ErosionImGui()
 		ImGui::InputFloat("Min slope", &erosion.GetConfigRef().minSlope, 0.0f, 1.0f);
 		ImGui::InputInt("Erosion radius", &erosion.GetConfigRef().erosionRadius);
 		ImGui::InputFloat("Blur", &erosion.GetConfigRef().blur, 0.0f, 1.0f);
+		ImGui::InputScalar("Seed (0 - random)", ImGuiDataType_U32, &erosion.GetConfigRef().seed);
 
 		if (ImGui::Button("Erode map")) {
 			SimulateErosion();
@@ -189,6 +242,14 @@ void NoiseBasedGenerationSys::ErosionImGui()
 	}
 }
 
+//Reports the CPU memory of the noise and erosion maps to the performance panel
+void NoiseBasedGenerationSys::ReportMemoryUsage() const
+{
+	size_t bytes = noise.GetByteSize() + erosion.GetByteSize() + terrainNormals.GetByteSize() + erosionNormals.GetByteSize();
+	bytes += static_cast<size_t>(mapResolution) * mapResolution * stride * 4 * sizeof(float);
+	utilities::SetMemoryUsage("Noise system", bytes);
+}
+
 void NoiseBasedGenerationSys::ImGuiOutput()
 {
 	if (noise.GetHeight() * noise.GetWidth() > 500 * 500) {
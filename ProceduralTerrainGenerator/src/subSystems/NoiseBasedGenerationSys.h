@@ -26,6 +26,11 @@ class NoiseBasedGenerationSys
 		std::unique_ptr<VertexBuffer> mainVertexBuffer;
 		std::unique_ptr<TextureClass> terrainTexture;
 		std::unique_ptr<TextureClass> erosionTexture;
+		//Octahedral normal maps sampled by the tessellation shader, the eroded one is updated only where erosion changed the map
+		utilities::OctNormalMap terrainNormals, erosionNormals;
+		std::unique_ptr<TextureClass> terrainNormalTexture;
+		std::unique_ptr<TextureClass> erosionNormalTexture;
+		bool precomputedNormals = true;
 
 		//Perlin Noise object
 		noise::SimplexNoiseClass noise;
@@ -40,9 +45,11 @@ class NoiseBasedGenerationSys
 		bool SimulateErosion();
 
 		void Draw(Renderer& renderer, Camera& camera, LightSource& light);
+		void BindNormals(utilities::OctNormalMap& normals, TextureClass& texture, const float* map, unsigned int slot);
 		void ImGuiRightPanel();
 		void ImGuiLeftPanel();
 		void ErosionImGui();
 		void ImGuiOutput();
+		void ReportMemoryUsage() const;
 };
 
@@ -10,6 +10,8 @@
 #include "stb_image/stb_image.h"
 
 #include "utilities.h"
+#include "PerfStats.h"
+#include "Log.h"
 
 TerrainGenApp::TerrainGenApp() : window(nullptr), windowWidth(0), windowHeight(0), deltaTime(0.0f), lastFrame(0.0f),
 rightPanelWidth(400.0f),topPanelHeight(30.0f), bottomPanelHeight(200.0f), leftPanelWidth(400.0f),
@@ -59,7 +61,7 @@ int TerrainGenApp::Initialize()
     glfwSwapInterval(1);
 
     if (glewInit() != GLEW_OK) {
-        std::cout << "error" << std::endl;
+        LOG_ERROR("GLEW couldnt be initialized");
     }
 
     glEnable(GL_DEPTH_TEST);
@@ -85,7 +87,7 @@ int TerrainGenApp::Initialize()
     light.Initialize();
     light.SetPosition(glm::vec3(0.0f, 2000.0f, 0.0f));
    
-    std::cout << "[LOG] Hub initialized" << std::endl;
+    LOG_INFO("Hub initialized");
     return 0;
 }
 
@@ -96,6 +98,7 @@ void TerrainGenApp::Start()
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        utilities::RecordFrame(deltaTime);
 
 		camera.CameraAnchor(false);
         camera.SteerCamera(window, deltaTime, true);
@@ -162,6 +165,7 @@ void TerrainGenApp::ImGuiRender()
     }
     camera.ImGuiDraw();
     light.ImGuiDraw();
+    utilities::JobSystemImGui();
     if (currentMode == mode::NOISE_HEIGHTMAP) {
         noiseGenSys.ImGuiLeftPanel();
     }
@@ -207,6 +211,7 @@ void TerrainGenApp::ImGuiRender()
     ImGui::SetNextWindowSize(ImVec2(windowWidth - rightPanelWidth - leftPanelWidth, bottomPanelHeight), ImGuiCond_Always);
     ImGui::Begin("OutPut", nullptr, ImGuiWindowFlags_None | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoScrollbar);
     ImGui::TextWrapped("FPS: %.1f", 1.0f / deltaTime);
+    utilities::PerformanceImGui();
 	
     camera.ImGuiOutPut();
     if (currentMode == mode::NOISE_HEIGHTMAP) {
@@ -1,10 +1,26 @@
 #include "TerrainGenerationSys.h"
 
 #include <iostream>
+#include <cmath>
 #include <algorithm>
 
 #include "imgui/imgui.h"
 #include "ImPlot/implot.h"
+#include "Trace.h"
+#include "PerfStats.h"
+#include "Log.h"
+
+namespace {
+	//Hash of every field of a noise configuration which changes the generated map
+	utilities::StageHash HashNoiseConfig(const noise::NoiseConfigParameters& config)
+	{
+		utilities::StageHash hash;
+		hash.Add(config.xoffset).Add(config.yoffset).Add(config.resolution).Add(config.seed).Add(config.octaves);
+		hash.Add(config.scale).Add(config.constrast).Add(config.redistribution).Add(config.lacunarity).Add(config.persistance);
+		hash.Add(config.revertGain).Add(config.option).Add(config.Ridge).Add(config.RidgeGain).Add(config.RidgeOffset);
+		return hash.Add(config.island).Add(config.mixPower).Add(config.islandType).Add(config.symmetrical);
+	}
+}
 
 TerrainGenerationSys::TerrainGenerationSys() : terrainVertices(nullptr), mapResolution(50),
 heightScale(1.0f), modelScale(1.0f), stride(5), width(0), height(0), terrainGen(), biomeGen() {
@@ -33,54 +49,460 @@ bool TerrainGenerationSys::Initialize(unsigned int _height, unsigned int _width,
 	utilities::GenerateVerticesForResolution(terrainVertices, width*4, height*4, mapResolution, stride, 0, 3);
 	mainVertexBuffer = std::make_unique<VertexBuffer>(terrainVertices, (mapResolution * mapResolution) * stride * 4 * sizeof(float));
 	mainVAO->AddBuffer(*mainVertexBuffer, layout);
+	terrainTxt = std::make_unique<TextureClass>();
+	noiseTxt = std::make_unique<TextureClass>();
+	biomeTxt = std::make_unique<TextureClass>();
+	paletteTxt = std::make_unique<TextureClass>();
+	normalTxt = std::make_unique<TextureClass>();
 	terrainGen.Initialize(width, height);
 	biomeGen.Initialize(width, height);
-	GenerateTerrain(0.0f, 0.0f);
+	BakeBiomeHeightCurves();
+	vegetationGen.GetConfigRef().heightScale = heightScale;
+	vegetationGen.Initialize(width, height);
+	lodShader = std::make_unique<Shader>("res/shaders/LodShaders/Lod_vertex.shader", "res/shaders/CompactShaders/Compact_fragment.shader");
+	compactShader = std::make_unique<Shader>("res/shaders/CompactShaders/Compact_vertex.shader", "res/shaders/CompactShaders/Compact_fragment.shader");
+	vegetationShader = std::make_unique<Shader>("res/shaders/VegetationShaders/Vegetation_vertex.shader", "res/shaders/VegetationShaders/Vegetation_fragment.shader");
+	treeModel = modelCache.Request("res/models/Tree.obj");
+	modelCache.LoadAsync();
+	BuildStageGraph();
+	UpdateStages();
 
-	std::cout << "[LOG] TerrainGenerationSys initialized\n";
+	LOG_INFO("TerrainGenerationSys initialized");
 	return true;
 
 }
 bool TerrainGenerationSys::Resize() {
+	bool resized = false;
 	if (terrainGen.GetHeight() != height || terrainGen.GetWidth() != width) {
 		terrainGen.Resize(width, height);
-		return  true;
+		resized = true;
 	}
-	return false;
+	if (biomeGen.GetHeight() != height || biomeGen.GetWidth() != width) {
+		biomeGen.Resize(height, width);
+		resized = true;
+	}
+	return resized;
 }
-bool TerrainGenerationSys::GenerateTerrain(float originx, float originy) {
-	Resize();
+//Biome map covers only the map at the origin, moving terrain is generated without biome shaping
+bool TerrainGenerationSys::IsBiomeShapingActive() const
+{
+	return biomeHeightShaping && biomesGeneration && terrainOrigin == glm::vec2(0.0f);
+}
+//Declares the generation stages, their inputs and the configuration each of them depends on
+//Component noise maps feed the biome classification, the noise preview and the combine pass, which reads them at the
+//origin and samples the noises per point only for infinite generation. Stages touching textures run on the main thread.
+void TerrainGenerationSys::BuildStageGraph()
+{
+	using utilities::StageThread;
+	const TerrainGenerator::WorldGenParameter components[3] = { TerrainGenerator::WorldGenParameter::CONTINENTALNESS,
+		TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS, TerrainGenerator::WorldGenParameter::WEIRDNESS };
+	const char* componentNames[3] = { "Continentalness noise", "Mountainousness noise", "Weirdness noise" };
+	for (int i = 0; i < 3; i++) {
+		const TerrainGenerator::WorldGenParameter p = components[i];
+		stages.componentNoises[i] = stageGraph.AddStage(componentNames[i], {}, StageThread::WORKER,
+			[this, p]() { return HashNoiseConfig(terrainGen.GetSelectedNoiseConfig(p)).Add(width).Add(height).Get(); },
+			[this, p]() { return terrainGen.GetSelectedNoise(p).GenerateFractalNoise(0.0f, 0.0f); });
+	}
+	const BiomeParameter biomeComponents[2] = { BiomeParameter::TEMPERATURE, BiomeParameter::HUMIDITY };
+	const char* biomeComponentNames[2] = { "Temperature noise", "Humidity noise" };
+	for (int i = 0; i < 2; i++) {
+		const BiomeParameter p = biomeComponents[i];
+		stages.biomeNoises[i] = stageGraph.AddStage(biomeComponentNames[i], {}, StageThread::WORKER,
+			[this, p]() { return HashNoiseConfig(biomeGen.GetNoiseByParameter(p).GetConfigRef()).Add(width).Add(height).Get(); },
+			[this, p]() { return biomeGen.GetNoiseByParameter(p).GenerateFractalNoise(0.0f, 0.0f); });
+		stageGraph.SetCondition(stages.biomeNoises[i], [this]() { return biomesGeneration; });
+	}
+
+	stages.biomeClassify = stageGraph.AddStage("Biome classify",
+		{ stages.componentNoises[0], stages.componentNoises[1], stages.componentNoises[2], stages.biomeNoises[0], stages.biomeNoises[1] }, StageThread::WORKER,
+		[this]() {
+			utilities::StageHash hash;
+			for (BiomeParameter p : { BiomeParameter::TEMPERATURE, BiomeParameter::HUMIDITY, BiomeParameter::CONTINENTALNESS, BiomeParameter::MOUNTAINOUSNESS, BiomeParameter::WEIRDNESS }) {
+				hash.Add(biomeGen.GetLevelsByParameter(p));
+			}
+			return hash.Get();
+		},
+		[this]() {
+			return biomeGen.Biomify(terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::CONTINENTALNESS),
+				terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS),
+				terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::WEIRDNESS));
+		});
+	stages.biomeBlend = stageGraph.AddStage("Biome blend", { stages.biomeClassify }, StageThread::WORKER,
+		[this]() { return utilities::StageHash().Add(biomeGen.GetBlendRadiusRef()).Get(); },
+		[this]() {
+			//Blending with radius 0 only drops the weights of the previous blend
+			const bool blended = biomeGen.BlendBiomes();
+			return blended || biomeGen.GetBlendRadiusRef() <= 0;
+		});
+	//Bakes the height curves of the biomes and passes changes of the biome maps on to the combine pass while shaping is on
+	stages.biomeShaping = stageGraph.AddStage("Biome height curves", { stages.biomeBlend }, StageThread::WORKER,
+		[this]() {
+			utilities::StageHash hash;
+			for (const auto& it : biomeGen.GetBiomes()) {
+				hash.Add(it.first).Add(it.second.GetHeightCurve());
+			}
+			return hash.Get();
+		},
+		[this]() { BakeBiomeHeightCurves(); return true; });
+	stages.biomeColors = stageGraph.AddStage("Biome colours", { stages.biomeBlend }, StageThread::WORKER, {},
+		[this]() {
+			utilities::ScratchScope scope(utilities::GetThreadScratch());
+			const glm::vec3* colors = utilities::GetBiomeColorMap(biomeGen, width, height, scope.GetArena());
+			if (!colors) {
+				return false;
+			}
+			biomeColors.assign(colors, colors + static_cast<size_t>(width) * height);
+			return true;
+		});
+	for (int stage : { stages.biomeClassify, stages.biomeBlend, stages.biomeColors }) {
+		stageGraph.SetCondition(stage, [this]() { return biomesGeneration; });
+	}
+	stageGraph.SetCondition(stages.biomeShaping, [this]() { return IsBiomeShapingActive(); });
 
-	if (!terrainGen.GenerateTerrain(originx, originy)) {
+	stages.combine = stageGraph.AddStage("Combine",
+		{ stages.componentNoises[0], stages.componentNoises[1], stages.componentNoises[2], stages.biomeShaping }, StageThread::WORKER,
+		[this, components]() {
+			utilities::StageHash hash;
+			const evaluation::EvaluationParameters& parameters = terrainGen.GetEvaluationParametersRef();
+			hash.Add(terrainGen.GetEvaluatorRef()).Add(parameters.ridgeStrength).Add(parameters.terraceCount).Add(parameters.terraceSharpness);
+			for (TerrainGenerator::WorldGenParameter p : components) {
+				hash.Add(terrainGen.GetSplinePoints(p));
+			}
+			hash.Add(terrainGen.GetSplineLutResolutionRef()).Add(terrainGen.GetSplineLutMaxErrorRef());
+			return hash.Add(terrainOrigin.x).Add(terrainOrigin.y).Add(width).Add(height).Add(IsBiomeShapingActive()).Get();
+		},
+		[this]() {
+			bool biomesMatch = biomeGen.IsGenerated() && biomeGen.GetWidth() * biomeGen.GetHeight() == width * height;
+			if (IsBiomeShapingActive() && biomesMatch) {
+				terrainGen.SetBiomeMap(biomeGen.GetBiomeMap(), biomeGen.GetBiomeWeights());
+			}
+			else {
+				terrainGen.SetBiomeMap(nullptr, nullptr);
+			}
+			//Component maps are generated at the origin only
+			if (terrainOrigin == glm::vec2(0.0f)) {
+				return terrainGen.GenerateTerrainFromNoiseMaps();
+			}
+			return terrainGen.GenerateTerrain(terrainOrigin.x, terrainOrigin.y);
+		});
+	//Edited component noises are previewed on their own, the terrain follows once the changes are accepted
+	stageGraph.SetCondition(stages.combine, [this]() { return !editNoise; });
+	stages.heightPyramid = stageGraph.AddStage("Height pyramid", { stages.combine }, StageThread::WORKER,
+		[this]() { return utilities::StageHash().Add(heightMipReduction).Get(); },
+		[this]() { return heightPyramid.Build(terrainGen.GetHeightMap(), width, height, heightMipReduction); });
+	stageGraph.SetCondition(stages.heightPyramid, [this]() { return quantizedHeights; });
+	stages.normals = stageGraph.AddStage("Normals", { stages.combine }, StageThread::WORKER,
+		[this]() { return utilities::StageHash().Add(heightScale * width).Get(); },
+		[this]() { return normalMap.Build(terrainGen.GetHeightMap(), width, height, heightScale * width); });
+	//Scatters the instances over the height map weighted by the blended biomes and rebuilds their spatial index,
+	//the instances are uploaded per frame by the model cache after culling
+	stages.vegetation = stageGraph.AddStage("Vegetation", { stages.combine, stages.biomeBlend }, StageThread::WORKER,
+		[this]() {
+			const vegetation::VegetationConfig& config = vegetationGen.GetConfigRef();
+			utilities::StageHash hash;
+			hash.Add(config.seed).Add(config.patternCount).Add(config.tileSize).Add(config.minDistance).Add(config.chunkSize);
+			hash.Add(config.minHeight).Add(config.maxHeight).Add(config.heightFalloff).Add(config.maxSlope).Add(config.minScale).Add(config.maxScale);
+			for (const auto& it : biomeGen.GetBiomes()) {
+				hash.Add(it.first).Add(it.second.GetVegetationLevel());
+			}
+			return hash.Add(heightScale).Add(width).Add(height).Get();
+		},
+		[this]() { return GenerateVegetation(); });
+	stageGraph.SetCondition(stages.vegetation, [this]() { return biomesGeneration && scatterVegetation; });
+
+	stages.heightUpload = stageGraph.AddStage("Height texture upload", { stages.combine, stages.heightPyramid }, StageThread::MAIN,
+		[this]() { return utilities::StageHash().Add(quantizedHeights).Get(); },
+		[this]() { UpdateTerrainTexture(); return true; });
+	stages.normalUpload = stageGraph.AddStage("Normal texture upload", { stages.normals }, StageThread::MAIN, {},
+		[this]() { UpdateNormalTexture(); return true; });
+	stages.biomeUpload = stageGraph.AddStage("Biome texture upload", { stages.biomeColors }, StageThread::MAIN, {},
+		[this]() { return biomeTxt->Update(biomeColors, width, height); });
+	stageGraph.SetCondition(stages.biomeUpload, [this]() { return biomesGeneration; });
+	stages.noisePreview = stageGraph.AddStage("Noise preview upload",
+		{ stages.componentNoises[0], stages.componentNoises[1], stages.componentNoises[2], stages.biomeNoises[0], stages.biomeNoises[1] }, StageThread::MAIN,
+		[this]() { return utilities::StageHash().Add(reinterpret_cast<uintptr_t>(previewedNoise)).Get(); },
+		[this]() { UpdateNoiseTexture(*previewedNoise); return true; });
+	stageGraph.SetCondition(stages.noisePreview, [this]() { return heightMapUnit == 1 && previewedNoise; });
+}
+//Recomputes the stages whose configuration or inputs changed since the last frame
+void TerrainGenerationSys::UpdateStages()
+{
+	Resize();
+	if (stageGraph.Evaluate() == 0) {
+		return;
+	}
+	if (stageGraph.HasRun(stages.combine)) {
+		compactMeshDirty = true;
+		lodTreeDirty = true;
+	}
+	if (stageGraph.HasRun(stages.biomeColors)) {
+		compactMeshDirty = true;
+	}
+	ReportMemoryUsage();
+}
+//Builds the compact vertex mesh of the current height map, colours are biomes if generated or topographical gradient otherwise
+bool TerrainGenerationSys::BuildCompactMesh()
+{
+	TRACE_ZONE("BuildCompactMesh");
+	utilities::StageTimer timer("Compact mesh");
+	const float* map = terrainGen.GetHeightMap();
+	if (!map || width < 2 || height < 2) {
 		return false;
 	}
 
-	terrainTxt = std::make_unique<TextureClass>(terrainGen.GetHeightMap(), width, height);
+	//Biome indices and the vertex data only live until the upload
+	utilities::ScratchArena& scratch = utilities::GetThreadScratch();
+	utilities::ScratchScope scope(scratch);
+	const size_t pixelCount = static_cast<size_t>(width) * height;
 
+	std::vector<glm::vec3> palette = utilities::GetTopoPalette();
+	const unsigned char* colorIndices = nullptr;
+	if (biomesGeneration && biomeGen.IsGenerated()) {
+		const int* biomeMap = biomeGen.GetBiomeMap();
+		unsigned char* biomeIndices = scratch.Allocate<unsigned char>(pixelCount);
+		for (size_t i = 0; i < pixelCount; i++) {
+			biomeIndices[i] = static_cast<unsigned char>(std::clamp(biomeMap[i], 0, 255));
+		}
+		for (const auto& it : biomeGen.GetBiomes()) {
+			if (it.first >= 0 && it.first < 256) {
+				palette[it.first] = it.second.GetColor();
+			}
+		}
+		colorIndices = biomeIndices;
+	}
+
+	const size_t vertexBytes = pixelCount * utilities::GetCompactVertexSize(compactPrecision);
+	unsigned char* vertices = scratch.Allocate<unsigned char>(vertexBytes);
+	if (compactPrecision == utilities::NormalPrecision::OCT8) {
+		compactQuantization = utilities::MapToCompactVertices(map, colorIndices, width, height, heightScale, reinterpret_cast<utilities::CompactVertex8*>(vertices));
+	}
+	else {
+		compactQuantization = utilities::MapToCompactVertices(map, colorIndices, width, height, heightScale, reinterpret_cast<utilities::CompactVertex16*>(vertices));
+	}
+
+	//Bands overlap by one row of vertices, so the vertex buffer is not duplicated and bands differ only by the base vertex
+	compactBands.clear();
+	for (int firstRow = 0; firstRow < height - 1; firstRow += compactBandRows) {
+		CompactBand band;
+		band.firstRow = firstRow;
+		band.rows = std::min(compactBandRows, height - 1 - firstRow);
+		band.baseVertex = firstRow * width;
+		const float* first = map + static_cast<size_t>(firstRow) * width;
+		const float* last = first + static_cast<size_t>(band.rows + 1) * width;
+		auto range = std::minmax_element(first, last);
+		band.minHeight = *range.first * heightScale;
+		band.maxHeight = *range.second * heightScale;
+		compactBands.push_back(band);
+	}
+	compactBandIndices = IndexBuffer::GetStripGrid(width, compactBands.front().rows + 1);
+	compactLastBandIndices = IndexBuffer::GetStripGrid(width, compactBands.back().rows + 1);
+
+	compactVAO = std::make_unique<VertexArray>();
+	compactVertexBuffer = std::make_unique<VertexBuffer>(vertices, static_cast<unsigned int>(vertexBytes));
+	compactVAO->AddBuffer(*compactVertexBuffer, utilities::GetCompactVertexLayout(compactPrecision));
+	compactVAO->Unbind();
+	paletteTxt->Update(palette, 256, 1);
+	compactVertexBytes = vertexBytes;
+	compactMeshDirty = false;
+	return true;
+}
+//Rebuilds the LOD quadtree over the current height map and the shared grid mesh if its resolution changed
+bool TerrainGenerationSys::BuildLodTree()
+{
+	utilities::StageTimer timer("LOD tree");
+	if (!lodTree.Build(terrainGen.GetHeightMap(), width, height, heightScale, lodGridResolution)) {
+		return false;
+	}
+	if (!lodGridVAO || lodGridIndexBuffer->GetCount() != utilities::GetStripIndexCount(lodGridResolution + 1, lodGridResolution + 1)) {
+		std::vector<float> vertices;
+		lod::LodQuadtree::BuildGridMesh(lodGridResolution, vertices);
+		VertexBufferLayout gridLayout;
+		gridLayout.Push<float>(2);
+		lodGridVAO = std::make_unique<VertexArray>();
+		lodGridVertexBuffer = std::make_unique<VertexBuffer>(vertices.data(), static_cast<unsigned int>(vertices.size() * sizeof(float)));
+		lodNodeBuffer = std::make_unique<StreamingVertexBuffer>(static_cast<unsigned int>(sizeof(LodNodeInstance)), 256);
+		lodGridIndexBuffer = IndexBuffer::GetStripGrid(lodGridResolution + 1, lodGridResolution + 1);
+		lodGridVAO->AddBuffer(*lodGridVertexBuffer, gridLayout);
+		lodGridVAO->AddInstanceBuffer(*lodNodeBuffer, GetLodNodeLayout(), 1);
+		lodGridVAO->Unbind();
+	}
+	lodTreeDirty = false;
 	return true;
 }
-bool TerrainGenerationSys::GenerateBiomes()
+void TerrainGenerationSys::DrawLod(Renderer& renderer, Camera& camera, LightSource& light, const glm::mat4& model)
+{
+	if (lodTreeDirty && !BuildLodTree()) {
+		return;
+	}
+
+	glm::mat4 mapToWorld = GetMapToWorld(model);
+	if (!lodFreezeSelection) {
+		lod::LodSelectionSettings settings;
+		settings.cameraPosition = glm::vec3(glm::inverse(mapToWorld) * glm::vec4(camera.GetPosition(), 1.0f));
+		settings.frustum = spatial::Frustum::FromMatrix(*camera.GetProjectionMatrix() * *camera.GetViewMatrix() * mapToWorld);
+		settings.worldScale = glm::vec3(glm::length(glm::vec3(mapToWorld[0])), glm::length(glm::vec3(mapToWorld[1])), glm::length(glm::vec3(mapToWorld[2])));
+		settings.projectionScale = camera.GetScreenHeight() / (2.0f * std::tan(glm::radians(camera.GetFovRef()) * 0.5f));
+		settings.maxPixelError = lodPixelError;
+		lodTree.Select(settings);
+	}
+
+	lodShader->Bind();
+	light.SetLightUniforms(*lodShader);
+	camera.SetUniforms(*lodShader);
+	lodShader->SetModel(mapToWorld);
+	terrainTxt->Bind(0);
+	lodShader->SetUniform1i("heightMap", 0);
+	lodShader->SetUniform2f("mapSize", static_cast<float>(width), static_cast<float>(height));
+	lodShader->SetUniform1f("heightScale", heightScale);
+	lodShader->SetUniform1f("heightMin", terrainTxt->GetValueMin());
+	lodShader->SetUniform1f("heightRange", terrainTxt->GetValueRange());
+	lodShader->SetUniform1i("gridResolution", lodGridResolution);
+	const lod::LodSelectionSettings& selection = lodTree.GetSelectionSettings();
+	lodShader->SetUniform3fv("lodCamera", selection.cameraPosition);
+	lodShader->SetUniform3fv("lodWorldScale", selection.worldScale);
+
+	//Every selected node is one instance of the shared grid
+	lodNodeInstances.clear();
+	for (const auto& item : lodTree.GetDrawList()) {
+		lodNodeInstances.push_back({ glm::vec3(item.originX, item.originZ, item.size), glm::vec2(item.morphStart, item.morphEnd) });
+	}
+	if (lodNodeInstances.empty()) {
+		return;
+	}
+	unsigned int count = static_cast<unsigned int>(lodNodeInstances.size());
+	if (lodNodeBuffer->Reserve(count)) {
+		lodGridVAO->AddInstanceBuffer(*lodNodeBuffer, GetLodNodeLayout(), 1);
+	}
+	unsigned int baseInstance = lodNodeBuffer->Write(lodNodeInstances.data(), count);
+	renderer.DrawTriangleStripsInstanced(*lodGridVAO, *lodGridIndexBuffer, *lodShader, static_cast<int>(count), baseInstance);
+	lodNodeBuffer->EndFrame();
+}
+//Per instance node attributes of the LOD grid: origin x, origin z, size and the morph range
+VertexBufferLayout TerrainGenerationSys::GetLodNodeLayout()
+{
+	VertexBufferLayout nodeLayout;
+	nodeLayout.Push<float>(3);
+	nodeLayout.Push<float>(2);
+	return nodeLayout;
+}
+//Draws the compact mesh bands intersecting the frustum, all full bands with one multi-draw call
+void TerrainGenerationSys::DrawCompact(Renderer& renderer, Camera& camera, LightSource& light, const glm::mat4& model)
+{
+	glm::mat4 mapToWorld = GetMapToWorld(model);
+	spatial::Frustum frustum = spatial::Frustum::FromMatrix(*camera.GetProjectionMatrix() * *camera.GetViewMatrix() * mapToWorld);
+	compactVisibleBaseVertices.clear();
+	bool lastBandVisible = false;
+	for (size_t i = 0; i < compactBands.size(); i++) {
+		const CompactBand& band = compactBands[i];
+		glm::vec3 bmin(0.0f, band.minHeight, static_cast<float>(band.firstRow));
+		glm::vec3 bmax(static_cast<float>(width - 1), band.maxHeight, static_cast<float>(band.firstRow + band.rows));
+		if (frustum.TestBox(bmin, bmax) == 0) {
+			continue;
+		}
+		if (band.rows == compactBands.front().rows) {
+			compactVisibleBaseVertices.push_back(band.baseVertex);
+		}
+		else {
+			lastBandVisible = true;
+		}
+	}
+
+	compactShader->Bind();
+	light.SetLightUniforms(*compactShader);
+	camera.SetUniforms(*compactShader);
+	compactShader->SetModel(mapToWorld);
+	compactShader->SetUniform1i("gridWidth", width);
+	compactShader->SetUniform1f("heightMin", compactQuantization.heightMin);
+	compactShader->SetUniform1f("heightRange", compactQuantization.heightRange);
+	paletteTxt->Bind(3);
+	compactShader->SetUniform1i("palette", 3);
+	compactVisibleBands = static_cast<int>(compactVisibleBaseVertices.size()) + (lastBandVisible ? 1 : 0);
+	compactDrawCalls = 0;
+	if (!compactVisibleBaseVertices.empty()) {
+		renderer.MultiDrawTriangleStrips(*compactVAO, *compactBandIndices, *compactShader, compactVisibleBaseVertices);
+		compactDrawCalls++;
+	}
+	if (lastBandVisible) {
+		renderer.MultiDrawTriangleStrips(*compactVAO, *compactLastBandIndices, *compactShader, { compactBands.back().baseVertex });
+		compactDrawCalls++;
+	}
+}
+//Map cell space -> world space transform of the patch grid (see GenerateVerticesForResolution call in Initialize)
+glm::mat4 TerrainGenerationSys::GetMapToWorld(const glm::mat4& model) const
+{
+	glm::mat4 mapToWorld = glm::translate(model, glm::vec3(-2.0f * height, 0.0f, -2.0f * width));
+	return glm::scale(mapToWorld, glm::vec3(4.0f * height / width, 1.0f, 4.0f * width / height));
+}
+//Uploads the height map either as floats with driver generated mipmaps or quantized with the pyramid of the height pyramid stage
+void TerrainGenerationSys::UpdateTerrainTexture()
+{
+	if (quantizedHeights && heightPyramid.GetLevelCount() > 0) {
+		terrainTxt->Update(heightPyramid);
+		return;
+	}
+	terrainTxt->Update(terrainGen.GetHeightMap(), width, height);
+}
+//Uploads the changed part of the normal map, the normals stage re-encodes the whole map when the height scale changed
+//because the slopes are stored already scaled
+void TerrainGenerationSys::UpdateNormalTexture()
+{
+	if (!normalMap.IsBuilt() || normalMap.GetWidth() != width || normalMap.GetHeight() != height) {
+		return;
+	}
+	normalTxt->Update(normalMap);
+}
+//Uploads the edited component noise into the preview texture in place
+void TerrainGenerationSys::UpdateNoiseTexture(noise::SimplexNoiseClass& noise)
+{
+	noiseTxt->Update(noise.GetMap(), noise.GetWidth(), noise.GetHeight());
+}
+void TerrainGenerationSys::BakeBiomeHeightCurves()
+{
+	terrainGen.ClearBiomeHeightCurves();
+	for (const auto& it : biomeGen.GetBiomes()) {
+		terrainGen.SetBiomeHeightCurve(it.first, it.second.GetHeightCurve());
+	}
+}
+//Body of the vegetation stage, scatters the instances and rebuilds the index used for visibility queries
+bool TerrainGenerationSys::GenerateVegetation()
 {
-	if (biomeGen.IsGenerated()) {
+	if (!biomeGen.IsGenerated()) {
+		LOG_ERROR("Biomes have to be generated before vegetation");
 		return false;
 	}
-	if(!biomeGen.Biomify(terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::CONTINENTALNESS), 
-		terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS), 
-		terrainGen.GetSelectedNoise(TerrainGenerator::WorldGenParameter::WEIRDNESS))) {
-		std::cout << "[ERROR] Biomes couldnt be generated\n";
+	vegetationGen.GetConfigRef().heightScale = heightScale;
+	if (vegetationGen.GetWidth() != width || vegetationGen.GetHeight() != height) {
+		vegetationGen.Resize(width, height);
+	}
+	if (!vegetationGen.Generate(terrainGen.GetHeightMap(), biomeGen)) {
 		return false;
 	}
-	biomeTxt = std::make_unique<TextureClass>(utilities::GetBiomeColorMap(biomeGen, width, height), width, height);
+
+	//Rebuilding the chunk aligned index
+	vegetationIndex = spatial::SpatialGrid<vegetation::VegetationInstance>(static_cast<float>(vegetationGen.GetConfigRef().chunkSize));
+	for (const auto& chunk : vegetationGen.GetChunks()) {
+		vegetationIndex.InsertChunk(chunk.x, chunk.y, chunk.instances);
+	}
 	return true;
 }
+//Reports the CPU memory of the generators and the CPU side copies of the maps to the performance panel
+void TerrainGenerationSys::ReportMemoryUsage() const
+{
+	size_t terrainBytes = terrainGen.GetByteSize() + heightPyramid.GetByteSize() + normalMap.GetByteSize();
+	terrainBytes += static_cast<size_t>(mapResolution) * mapResolution * stride * 4 * sizeof(float);
+	utilities::SetMemoryUsage("Terrain generator", terrainBytes);
+	utilities::SetMemoryUsage("Biome generator", biomeGen.GetByteSize());
+	utilities::SetMemoryUsage("Vegetation", vegetationGen.GetByteSize());
+}
 void TerrainGenerationSys::Draw(Renderer& renderer, Camera& camera, LightSource& light) {
 	if (infiniteGeneration) {
-		if (oldCamPos.x != camera.GetPosition().x || oldCamPos.z != camera.GetPosition().z) {
-			GenerateTerrain(camera.GetPosition().x, camera.GetPosition().z);
-			oldCamPos = camera.GetPosition();
-		}
+		terrainOrigin = glm::vec2(camera.GetPosition().x, camera.GetPosition().z);
 		camera.CameraAnchor(true);
 	}
+	else {
+		terrainOrigin = glm::vec2(0.0f);
+	}
+	UpdateStages();
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::scale(model, glm::vec3(modelScale, modelScale, modelScale));
 	light.SetLightUniforms(*mainShader);
@@ -89,56 +511,133 @@ void TerrainGenerationSys::Draw(Renderer& renderer, Camera& camera, LightSource&
 	mainShader->SetUniform1i("size", height / 2);
 	mainShader->SetUniform1i("flatten", map2d);
 	mainShader->SetUniform1f("heightScale", heightScale);
+	const TextureClass& sampledHeights = heightMapUnit == 0 ? *terrainTxt : *noiseTxt;
+	mainShader->SetUniform1i("heightMap", heightMapUnit);
+	mainShader->SetUniform1f("heightMin", sampledHeights.GetValueMin());
+	mainShader->SetUniform1f("heightRange", sampledHeights.GetValueRange());
+	//Normal map describes the terrain, noise previews fall back to the height differences
+	bool useNormalMap = precomputedNormals && heightMapUnit == 0 && normalMap.IsBuilt();
+	if (useNormalMap) {
+		normalTxt->Bind(4);
+		mainShader->SetUniform1i("normalMap", 4);
+	}
+	mainShader->SetUniform1i("useNormalMap", useNormalMap);
+
+	if (scatterVegetation && vegetationGen.IsGenerated()) {
+		glm::mat4 mapToWorld = GetMapToWorld(model);
+		spatial::Frustum frustum = spatial::Frustum::FromMatrix(*camera.GetProjectionMatrix() * *camera.GetViewMatrix() * mapToWorld);
+		//The mesh is drawn in world units around the instance position, the culling runs in map units
+		const ModelBounds bounds = modelCache.GetBounds(treeModel);
+		const float worldScale = vegetationGen.GetConfigRef().maxScale * vegetationModelScale;
+		const glm::vec3 mapUnit(glm::length(glm::vec3(mapToWorld[0])), glm::length(glm::vec3(mapToWorld[1])), glm::length(glm::vec3(mapToWorld[2])));
+		const glm::vec3 extentMin = glm::vec3(-bounds.radius, bounds.minY, -bounds.radius) * worldScale / mapUnit;
+		const glm::vec3 extentMax = glm::vec3(bounds.radius, bounds.maxY, bounds.radius) * worldScale / mapUnit;
+		vegetationIndex.SetInstanceBounds(glm::min(extentMin, glm::vec3(0.0f)), glm::max(extentMax, glm::vec3(0.0f)));
+		std::vector<uint32_t> offsets;
+		visibleVegetation.clear();
+		vegetationIndex.QueryFrustum(&frustum, 1, visibleVegetation, offsets);
+		visibleVegetationCount = 0;
+		for (const auto& range : visibleVegetation) {
+			visibleVegetationCount += range.count;
+		}
+		DrawVegetation(renderer, camera, light, mapToWorld);
+	}
+
+	if (lodMesh) {
+		DrawLod(renderer, camera, light, model);
+		return;
+	}
+	if (compactMesh) {
+		if (compactMeshDirty) {
+			BuildCompactMesh();
+		}
+		if (compactVAO) {
+			DrawCompact(renderer, camera, light, model);
+			return;
+		}
+	}
 
 	terrainTxt->Bind(0);
-	if(noiseTxt)
-		noiseTxt->Bind(1);
-	if (biomesGeneration && biomeTxt) {
+	noiseTxt->Bind(1);
+	if (biomesGeneration && biomeTxt->IsAllocated()) {
 		biomeTxt->Bind(2);
 		mainShader->SetUniform1i("biomeMap", 2);
 	}
 	renderer.DrawPatches(*mainVAO, *mainShader, mapResolution * mapResolution, 4);
 }
-void TerrainGenerationSys::ImGuiRightPanel() {
-	if(utilities::MapSizeImGui(height, width)) {
-		GenerateTerrain(0.0f, 0.0f);
+void TerrainGenerationSys::DrawVegetation(Renderer& renderer, Camera& camera, LightSource& light, const glm::mat4& mapToWorld) {
+	modelCache.UploadPending();
+	if (!drawVegetation || !modelCache.IsReady(treeModel)) {
+		return;
 	}
 
+	//Buckets are filled from the visible ranges, LOD is selected by the world space distance from the camera
+	modelCache.ClearInstances();
+	glm::vec3 cameraPos = camera.GetPosition();
+	for (const auto& range : visibleVegetation) {
+		const std::vector<vegetation::VegetationInstance>* instances = vegetationIndex.GetChunkInstances(range.chunkX, range.chunkY);
+		if (!instances) {
+			continue;
+		}
+		for (uint32_t i = range.begin; i < range.begin + range.count; i++) {
+			const vegetation::VegetationInstance& instance = (*instances)[i];
+			glm::vec3 worldPos = glm::vec3(mapToWorld * glm::vec4(instance.x, instance.y, instance.z, 1.0f));
+			modelCache.AddInstance(treeModel, { glm::vec3(instance.x, instance.y, instance.z), instance.scale, instance.rotation }, glm::distance(worldPos, cameraPos));
+		}
+	}
+
+	vegetationShader->Bind();
+	light.SetLightUniforms(*vegetationShader);
+	camera.SetUniforms(*vegetationShader);
+	vegetationShader->SetModel(mapToWorld);
+	vegetationShader->SetUniform1f("instanceScale", vegetationModelScale);
+	vegetationShader->SetUniform1f("crownHeight", 0.8f);
+	vegetationShader->SetUniform3fv("trunkColor", glm::vec3(0.35f, 0.22f, 0.1f));
+	vegetationShader->SetUniform3fv("crownColor", glm::vec3(0.13f, 0.4f, 0.12f));
+	modelCache.Draw(renderer, *vegetationShader);
+}
+void TerrainGenerationSys::ImGuiRightPanel() {
+	//Size changes are picked up by UpdateStages
+	utilities::MapSizeImGui(height, width);
+
 	if (ImGui::CollapsingHeader("Terrain settings", ImGuiTreeNodeFlags_DefaultOpen)) {
 		ImGui::Text("Evaluating method");
-		static int evaluatingOption = 0;
-		const char* methodOptions[] = { "Linear", "Spline" };
-		if (ImGui::BeginCombo("Method: ", methodOptions[evaluatingOption]))
+		const auto& evaluators = terrainGen.GetEvaluators();
+		int& evaluatorId = terrainGen.GetEvaluatorRef();
+		if (ImGui::BeginCombo("Method: ", evaluators[evaluatorId].name.c_str()))
 		{
-			for (int n = 0; n < IM_ARRAYSIZE(methodOptions); n++)
+			for (int n = 0; n < static_cast<int>(evaluators.size()); n++)
 			{
-				bool is_selected = (evaluatingOption == n);
-				if (ImGui::Selectable(methodOptions[n], is_selected)) {
-					evaluatingOption = n;
-					terrainGen.GetEvaluationMethod() = static_cast<TerrainGenerator::EvaluationMethod>(evaluatingOption);
-					changeTerrain = true;
+				bool is_selected = (evaluatorId == n);
+				if (ImGui::Selectable(evaluators[n].name.c_str(), is_selected)) {
+					evaluatorId = n;
 				}
 				if (is_selected)
 					ImGui::SetItemDefaultFocus();
 			}
 			ImGui::EndCombo();
 		}
+		evaluation::EvaluationParameters& parameters = terrainGen.GetEvaluationParametersRef();
+		if (evaluatorId == static_cast<int>(TerrainGenerator::EvaluationMethod::RIDGED_COMBINE)) {
+			ImGui::SliderFloat("Ridge strength", &parameters.ridgeStrength, 0.0f, 1.0f);
+		}
+		if (evaluatorId == static_cast<int>(TerrainGenerator::EvaluationMethod::TERRACED_COMBINE)) {
+			ImGui::SliderInt("Terrace count", &parameters.terraceCount, 1, 32);
+			ImGui::SliderFloat("Terrace sharpness", &parameters.terraceSharpness, 1.0f, 16.0f);
+		}
 		ImGui::SliderInt("Sampling resolution", &terrainGen.GetResolitionRef(), 10, 1000);
 		if (ImGui::Button("Change resolution")) {
 			terrainGen.SetResolution();
-			GenerateTerrain(0.0f, 0.0f);
 		}
 		NoiseEditor();
 		if (!editNoise) {
 			SplineEditor();
 			BiomesEditor();
-			if (changeTerrain) {
-				GenerateTerrain(0.0f, 0.0f);
-				biomeGen.Regenerate();
-				changeTerrain = false;
-			}
 		}
 	}
+	if (ImGui::CollapsingHeader("Generation stages")) {
+		utilities::StageGraphImGui(stageGraph);
+	}
 }
 void TerrainGenerationSys::ImGuiLeftPanel() {
 	// Trash variables for function call
@@ -151,6 +650,44 @@ void TerrainGenerationSys::ImGuiLeftPanel() {
 		mainShader->Bind();
 		mainShader->SetUniform1i("displayMode", static_cast<int>(displayMode));
 	}
+	if (ImGui::Checkbox("CDLOD quadtree mesh", &lodMesh)) {
+		lodTreeDirty = true;
+	}
+	if (lodMesh) {
+		ImGui::SliderFloat("Max pixel error", &lodPixelError, 0.25f, 32.0f);
+		if (ImGui::SliderInt("LOD grid resolution", &lodGridResolution, 8, 128)) {
+			lodGridResolution = 1 << static_cast<int>(std::round(std::log2(lodGridResolution)));
+			lodTreeDirty = true;
+		}
+		ImGui::Checkbox("Freeze LOD selection", &lodFreezeSelection);
+		if (ImGui::Button("Log LOD selection")) {
+			lodTree.LogSelection();
+		}
+	}
+	ImGui::Checkbox("Precomputed normal map", &precomputedNormals);
+	ImGui::Checkbox("16-bit height texture", &quantizedHeights);
+	if (quantizedHeights) {
+		int reduction = static_cast<int>(heightMipReduction);
+		ImGui::SameLine();
+		ImGui::Combo("Mip reduction", &reduction, "Average\0Max\0");
+		heightMipReduction = static_cast<utilities::MipReduction>(reduction);
+	}
+	if (ImGui::Checkbox("Compact vertex mesh", &compactMesh)) {
+		compactMeshDirty = true;
+	}
+	if (compactMesh) {
+		int precision = static_cast<int>(compactPrecision);
+		bool changed = ImGui::RadioButton("8-bit normals", &precision, static_cast<int>(utilities::NormalPrecision::OCT8));
+		ImGui::SameLine();
+		changed |= ImGui::RadioButton("16-bit normals", &precision, static_cast<int>(utilities::NormalPrecision::OCT16));
+		if (changed) {
+			compactPrecision = static_cast<utilities::NormalPrecision>(precision);
+			compactMeshDirty = true;
+		}
+		if (ImGui::SliderInt("Rows per band", &compactBandRows, 8, 512)) {
+			compactMeshDirty = true;
+		}
+	}
 	utilities::SavingImGui();
 }
 void TerrainGenerationSys::ImGuiOutput(glm::vec3 pos) {
@@ -161,6 +698,25 @@ void TerrainGenerationSys::ImGuiOutput(glm::vec3 pos) {
 			ImGui::Text("Biome at camera position: %s", biomeGen.GetBiome(biomeGen.GetBiomeAt(posX, posZ)).GetName().c_str());
 		}
 	}
+	if (lodMesh && lodTree.IsBuilt()) {
+		const lod::LodSelectionStats& lodStats = lodTree.GetStats();
+		ImGui::Text("LOD nodes: %d selected, %d culled, %d visited, triangles: %zu", lodStats.nodesSelected, lodStats.nodesCulled, lodStats.nodesVisited, lodStats.triangles);
+	}
+	if (quantizedHeights && heightPyramid.GetLevelCount() > 0) {
+		size_t floatBytes = static_cast<size_t>(width) * height * sizeof(float) * 4 / 3;
+		ImGui::Text("Height texture: %.2f MB with %d levels (float: %.2f MB)", heightPyramid.GetByteSize() / (1024.0 * 1024.0), heightPyramid.GetLevelCount(), floatBytes / (1024.0 * 1024.0));
+	}
+	if (compactMesh && compactVAO) {
+		size_t floatBytes = static_cast<size_t>(width) * height * 9 * sizeof(float);
+		ImGui::Text("Compact mesh: %.2f MB (float vertices: %.2f MB)", compactVertexBytes / (1024.0 * 1024.0), floatBytes / (1024.0 * 1024.0));
+		ImGui::Text("Compact bands: %d of %zu visible, draw calls: %d", compactVisibleBands, compactBands.size(), compactDrawCalls);
+	}
+	if (vegetationGen.IsGenerated()) {
+		ImGui::Text("Vegetation instances: %zu (in view: %zu in %zu ranges)", vegetationGen.GetInstanceCount(), visibleVegetationCount, visibleVegetation.size());
+		for (int lod = 0; lod < ModelCache::LOD_COUNT; lod++) {
+			ImGui::Text("Tree LOD %d: %zu instances, %zu triangles each", lod, modelCache.GetInstanceCount(treeModel, lod), modelCache.GetTriangleCount(treeModel, lod));
+		}
+	}
 }
 
 void TerrainGenerationSys::NoiseEditor()
@@ -169,7 +725,8 @@ void TerrainGenerationSys::NoiseEditor()
 	ImGui::Separator();
 	if (ImGui::Checkbox("Edit component noise", &editNoise)) {
 		noisePressedButton = 0;
-		mainShader->SetUniform1i("heightMap", static_cast<int>(editNoise));
+		heightMapUnit = static_cast<int>(editNoise);
+		previewedNoise = nullptr;
 	}
 	if (editNoise) {
 		if (ImGui::CollapsingHeader("Terrain noise editor", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -177,19 +734,19 @@ void TerrainGenerationSys::NoiseEditor()
 			if (utilities::ImGuiButtonWrapper("Mountainousness", noisePressedButton == 1 ? true : false)) {
 				noisePressedButton = 1;
 				editedComponent = TerrainGenerator::WorldGenParameter::MOUNTAINOUSNESS;
-				noiseTxt = std::make_unique<TextureClass>(terrainGen.GetSelectedNoise(editedComponent).GetMap(), terrainGen.GetSelectedNoise(editedComponent).GetWidth(), terrainGen.GetSelectedNoise(editedComponent).GetHeight());
+				previewedNoise = &terrainGen.GetSelectedNoise(editedComponent);
 			}
 			ImGui::SameLine();
 			if (utilities::ImGuiButtonWrapper("Continentalness", noisePressedButton == 2 ? true : false)) {
 				noisePressedButton = 2;
 				editedComponent = TerrainGenerator::WorldGenParameter::CONTINENTALNESS;
-				noiseTxt = std::make_unique<TextureClass>(terrainGen.GetSelectedNoise(editedComponent).GetMap(), terrainGen.GetSelectedNoise(editedComponent).GetWidth(), terrainGen.GetSelectedNoise(editedComponent).GetHeight());
+				previewedNoise = &terrainGen.GetSelectedNoise(editedComponent);
 			}
 			ImGui::SameLine();
 			if (utilities::ImGuiButtonWrapper("Weirdness", noisePressedButton == 3 ? true : false)) {
 				noisePressedButton = 3;
 				editedComponent = TerrainGenerator::WorldGenParameter::WEIRDNESS;
-				noiseTxt = std::make_unique<TextureClass>(terrainGen.GetSelectedNoise(editedComponent).GetMap(), terrainGen.GetSelectedNoise(editedComponent).GetWidth(), terrainGen.GetSelectedNoise(editedComponent).GetHeight());
+				previewedNoise = &terrainGen.GetSelectedNoise(editedComponent);
 			}
 			if (noisePressedButton == 0) {
 				ImGui::Text("[Currently no noise is beeing changed]");
@@ -197,16 +754,12 @@ void TerrainGenerationSys::NoiseEditor()
 			}
 
 			biomesGeneration = false;
-			if (utilities::NoiseImGui(terrainGen.GetSelectedNoiseConfig(editedComponent))) {
-				terrainGen.GetSelectedNoise(editedComponent).GenerateFractalNoise(0.0f, 0.0f);
-				changeTerrain = true;
-				noiseTxt = std::make_unique<TextureClass>(terrainGen.GetSelectedNoise(editedComponent).GetMap(), terrainGen.GetSelectedNoise(editedComponent).GetWidth(), terrainGen.GetSelectedNoise(editedComponent).GetHeight());
-			}
+			//The noise stage regenerates the map and the preview, the terrain is recombined once the changes are accepted
+			utilities::NoiseImGui(terrainGen.GetSelectedNoiseConfig(editedComponent));
 			if (ImGui::Button("Accept changes")) {
 				editNoise = false;
 				noisePressedButton = 0;
-				GenerateTerrain(0.0f, 0.0f);
-				mainShader->SetUniform1i("heightMap", 0);
+				heightMapUnit = 0;
 			}
 		}
 	}
@@ -217,7 +770,6 @@ void TerrainGenerationSys::BiomesEditor()
 	ImGui::Separator();
 	if (ImGui::Checkbox("Biomes generation", &biomesGeneration)) {
 		if (biomesGeneration) {
-			GenerateBiomes();
 			displayMode = utilities::heightMapMode::BIOMES;
 		}
 		else {
@@ -227,9 +779,58 @@ void TerrainGenerationSys::BiomesEditor()
 	}
 	if (biomesGeneration) {
 		if (ImGui::CollapsingHeader("Biome generation settings", ImGuiTreeNodeFlags_DefaultOpen)) {
+			ImGui::SliderInt("Blend radius", &biomeGen.GetBlendRadiusRef(), 0, 64);
 			BiomeNoisesEditor();
 			NoisesLevelsForBiomes();
 		}
+		BiomeHeightCurvesEditor();
+		VegetationEditor();
+	}
+}
+
+void TerrainGenerationSys::BiomeHeightCurvesEditor()
+{
+	if (ImGui::CollapsingHeader("Biome height curves")) {
+		ImGui::Checkbox("Biome height shaping", &biomeHeightShaping);
+		std::string preview = biomeGen.HasBiome(editedHeightCurveBiome) ? biomeGen.GetBiome(editedHeightCurveBiome).GetName() : "Select biome";
+		if (ImGui::BeginCombo("Biome", preview.c_str())) {
+			for (const auto& it : biomeGen.GetBiomes()) {
+				if (ImGui::Selectable(it.second.GetName().c_str(), it.first == editedHeightCurveBiome)) {
+					editedHeightCurveBiome = it.first;
+					heightCurvePoints = it.second.GetHeightCurve();
+				}
+			}
+			ImGui::EndCombo();
+		}
+		if (!biomeGen.HasBiome(editedHeightCurveBiome)) {
+			return;
+		}
+
+		CurveEditor("##biomeHeightCurve", heightCurvePoints, 0.0, 1.0);
+		if (ImGui::Button("Set height curve")) {
+			biomeGen.GetBiome(editedHeightCurveBiome).SetHeightCurve(heightCurvePoints);
+		}
+	}
+}
+
+void TerrainGenerationSys::VegetationEditor()
+{
+	if (ImGui::CollapsingHeader("Vegetation settings")) {
+		vegetation::VegetationConfig& config = vegetationGen.GetConfigRef();
+		bool patternsChanged = false;
+		patternsChanged |= ImGui::InputInt("Vegetation seed", &config.seed);
+		patternsChanged |= ImGui::SliderInt("Pattern count", &config.patternCount, 1, 16);
+		patternsChanged |= ImGui::SliderFloat("Tile size", &config.tileSize, 4.0f, 64.0f);
+		patternsChanged |= ImGui::SliderFloat("Min distance", &config.minDistance, 0.5f, 8.0f);
+		ImGui::SliderFloat("Min height", &config.minHeight, 0.0f, 1.0f);
+		ImGui::SliderFloat("Max height", &config.maxHeight, 0.0f, 1.0f);
+		ImGui::SliderFloat("Max slope", &config.maxSlope, 0.0f, 5.0f);
+		if (patternsChanged) {
+			vegetationGen.GeneratePatterns();
+		}
+		ImGui::Checkbox("Scatter vegetation", &scatterVegetation);
+		ImGui::Checkbox("Draw vegetation", &drawVegetation);
+		ImGui::SliderFloat("Vegetation model scale", &vegetationModelScale, 0.1f, 10.0f);
 	}
 }
 
@@ -240,32 +841,26 @@ void TerrainGenerationSys::BiomeNoisesEditor()
 	if (utilities::ImGuiButtonWrapper("Temperature", biomeNoisePressedButton == 1 ? true : false)) {
 		biomeNoisePressedButton = 1;
 		editedBiomeComponent = BiomeParameter::TEMPERATURE;
-		noiseTxt = std::make_unique<TextureClass>(biomeGen.GetNoiseByParameter(editedBiomeComponent).GetMap(), biomeGen.GetNoiseByParameter(editedBiomeComponent).GetWidth(), biomeGen.GetNoiseByParameter(editedBiomeComponent).GetHeight());
+		previewedNoise = &biomeGen.GetNoiseByParameter(editedBiomeComponent);
 	}
 	ImGui::SameLine();
 	if (utilities::ImGuiButtonWrapper("Humidity", biomeNoisePressedButton == 2 ? true : false)) {
 		biomeNoisePressedButton = 2;
 		editedBiomeComponent = BiomeParameter::HUMIDITY;
-		noiseTxt = std::make_unique<TextureClass>(biomeGen.GetNoiseByParameter(editedBiomeComponent).GetMap(), biomeGen.GetNoiseByParameter(editedBiomeComponent).GetWidth(), biomeGen.GetNoiseByParameter(editedBiomeComponent).GetHeight());
-
+		previewedNoise = &biomeGen.GetNoiseByParameter(editedBiomeComponent);
 	}
 	if (biomeNoisePressedButton == 0) {
 		ImGui::Text("[Currently no noise is beeing changed]");
 		return;
 	}
 
-	mainShader->SetUniform1i("heightMap", 1);
+	heightMapUnit = 1;
 
-	if (utilities::NoiseImGui(biomeGen.GetNoiseByParameter(editedBiomeComponent).GetConfigRef())) {
-		biomeGen.GetNoiseByParameter(editedBiomeComponent).GenerateFractalNoise(0.0f, 0.0f);
-		biomeGen.Regenerate();
-		noiseTxt = std::make_unique<TextureClass>(biomeGen.GetNoiseByParameter(editedBiomeComponent).GetMap(), biomeGen.GetNoiseByParameter(editedBiomeComponent).GetWidth(), biomeGen.GetNoiseByParameter(editedBiomeComponent).GetHeight());
-	}
+	utilities::NoiseImGui(biomeGen.GetNoiseByParameter(editedBiomeComponent).GetConfigRef());
 
 	if (ImGui::Button("Accept changes")) {
 		biomeNoisePressedButton = 0;
-		GenerateBiomes();
-		mainShader->SetUniform1i("heightMap", 0);
+		heightMapUnit = 0;
 	}
 }
 
@@ -297,80 +892,101 @@ void TerrainGenerationSys::SplineEditor()
 				splinePlotPoints = terrainGen.GetSplinePoints(editedComponent);
 			}
 
+			bool rebake = ImGui::SliderInt("LUT min resolution", &terrainGen.GetSplineLutResolutionRef(), 8, 1024);
+			rebake |= ImGui::InputFloat("LUT max error", &terrainGen.GetSplineLutMaxErrorRef(), 0.0f, 0.0f, "%.6f");
+			if (rebake) {
+				terrainGen.BakeSplines();
+			}
+			const utilities::CurveLut& lut = terrainGen.GetSplineLut(editedComponent);
+			ImGui::Text("Baked LUT: %d segments, max error %.6f", lut.GetResolution(), lut.GetMaxError());
+
 			if (splinePressedButton == 0) {
 				ImGui::Text("[Currently no spline is beeing changed]");
 				return;
 			}
 
-			static int dragging = -1;
-			if (splinePlotPoints.size() != 2 || splinePlotPoints[0].size() != splinePlotPoints[1].size()) {
-				std::cout << "[ERROR] Spline points not set correctly\n";
-				return;
+			CurveEditor("##plot", splinePlotPoints, -1.0, 1.0);
+			if (ImGui::Button("Set new spline points")) {
+				terrainGen.SetSpline(editedComponent, splinePlotPoints);
 			}
+		}
+	}
+}
+//Plot with draggable control points of a curve, end points can be moved only vertically
+//@param label - ImPlot label of the plot, has to be unique in the window
+//@param points - control points {X, Y} of the curve, Y is kept in range [0, 1]
+//@param xmin, xmax - range of X axis
+//@return - true if any point was moved
+bool TerrainGenerationSys::CurveEditor(const char* label, std::vector<std::vector<double>>& points, double xmin, double xmax)
+{
+	static int dragging = -1;
+	static ImGuiID draggedPlot = 0;
+	if (points.size() != 2 || points[0].size() != points[1].size()) {
+		LOG_ERROR("Spline points not set correctly");
+		return false;
+	}
+
+	const double ymin = 0.0, ymax = 1.0;
+	const double pick_radius = 0.08;
+	const ImGuiID plotId = ImGui::GetID(label);
+	bool changed = false;
+
+	if (ImPlot::BeginPlot(label, ImVec2(-1, 320), ImPlotFlags_NoMenus)) {
+		ImPlot::SetupAxis(ImAxis_X1, "X", ImPlotAxisFlags_Lock);
+		ImPlot::SetupAxis(ImAxis_Y1, "Y", ImPlotAxisFlags_Lock);
+		ImPlot::SetupAxisLimits(ImAxis_X1, xmin, xmax, ImGuiCond_Always);
+		ImPlot::SetupAxisLimits(ImAxis_Y1, ymin, ymax, ImGuiCond_Always);
 
-			const double xmin = -1.0, xmax = 1.0;
-			const double ymin = 0.0, ymax = 1.0;
-			const double pick_radius = 0.08;
-
-			if (ImPlot::BeginPlot("##plot", ImVec2(-1, 320), ImPlotFlags_NoMenus)) {
-				ImPlot::SetupAxis(ImAxis_X1, "X", ImPlotAxisFlags_Lock);
-				ImPlot::SetupAxis(ImAxis_Y1, "Y", ImPlotAxisFlags_Lock);
-				ImPlot::SetupAxisLimits(ImAxis_X1, xmin, xmax, ImGuiCond_Always);
-				ImPlot::SetupAxisLimits(ImAxis_Y1, ymin, ymax, ImGuiCond_Always);
-
-				std::vector<double> xs, ys; xs.reserve(splinePlotPoints[0].size()); ys.reserve(splinePlotPoints[1].size());
-				for (auto& p : splinePlotPoints[0]) { xs.push_back(p); }
-				for (auto& p : splinePlotPoints[1]) { ys.push_back(p); }
-				ImPlot::PlotLine("Spline (lin.)", xs.data(), ys.data(), (int)splinePlotPoints[0].size());
-				ImPlot::PlotScatter("Spline points", xs.data(), ys.data(), (int)splinePlotPoints[0].size());
-
-				ImPlotPoint mouse = ImPlot::GetPlotMousePos();
-				if (dragging == -1 && ImPlot::IsPlotHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-					for (int i = 0; i < (int)splinePlotPoints[0].size(); ++i) {
-						double dx = (double)mouse.x - splinePlotPoints[0][i];
-						double dy = (double)mouse.y - splinePlotPoints[1][i];
-						if (dx * dx + dy * dy <= pick_radius * pick_radius) {
-							dragging = i;
-							break;
-						}
-					}
+		std::vector<double> xs, ys; xs.reserve(points[0].size()); ys.reserve(points[1].size());
+		for (auto& p : points[0]) { xs.push_back(p); }
+		for (auto& p : points[1]) { ys.push_back(p); }
+		ImPlot::PlotLine("Spline (lin.)", xs.data(), ys.data(), (int)points[0].size());
+		ImPlot::PlotScatter("Spline points", xs.data(), ys.data(), (int)points[0].size());
+
+		ImPlotPoint mouse = ImPlot::GetPlotMousePos();
+		if (dragging == -1 && ImPlot::IsPlotHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+			for (int i = 0; i < (int)points[0].size(); ++i) {
+				double dx = (double)mouse.x - points[0][i];
+				double dy = (double)mouse.y - points[1][i];
+				if (dx * dx + dy * dy <= pick_radius * pick_radius) {
+					dragging = i;
+					draggedPlot = plotId;
+					break;
 				}
+			}
+		}
 
-				if (dragging != -1) {
-					if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
-						if (dragging == 0 || dragging == (int)splinePlotPoints[0].size() - 1) {
-							splinePlotPoints[1][dragging] = std::clamp((double)mouse.y, ymin, ymax);
-						}
-						else {
-							double xmin_drag = splinePlotPoints[0][dragging - 1] + 0.01;
-							double xmax_drag = splinePlotPoints[0][dragging + 1] - 0.01;
-
-							splinePlotPoints[0][dragging] = std::clamp((double)mouse.x, xmin_drag, xmax_drag);
-							splinePlotPoints[1][dragging] = std::clamp((double)mouse.y, ymin, ymax);
-						}
-					}
-					else {
-						dragging = -1;
-					}
+		if (dragging != -1 && draggedPlot == plotId) {
+			if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+				changed = true;
+				if (dragging == 0 || dragging == (int)points[0].size() - 1) {
+					points[1][dragging] = std::clamp((double)mouse.y, ymin, ymax);
 				}
+				else {
+					double xmin_drag = points[0][dragging - 1] + 0.01;
+					double xmax_drag = points[0][dragging + 1] - 0.01;
 
-				if (dragging == -1 && ImPlot::IsPlotHovered()) {
-					for (int i = 0; i < splinePlotPoints[0].size(); i++) {
-						double dx = (double)mouse.x - splinePlotPoints[0][i], dy = (double)mouse.y - splinePlotPoints[1][i];
-						if (dx * dx + dy * dy <= pick_radius * pick_radius) {
-							ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
-							break;
-						}
-					}
+					points[0][dragging] = std::clamp((double)mouse.x, xmin_drag, xmax_drag);
+					points[1][dragging] = std::clamp((double)mouse.y, ymin, ymax);
 				}
-				ImPlot::EndPlot();
 			}
-			if (ImGui::Button("Set new spline points")) {
-				terrainGen.SetSpline(editedComponent, splinePlotPoints);
-				changeTerrain = true;
+			else {
+				dragging = -1;
 			}
 		}
+
+		if (dragging == -1 && ImPlot::IsPlotHovered()) {
+			for (int i = 0; i < points[0].size(); i++) {
+				double dx = (double)mouse.x - points[0][i], dy = (double)mouse.y - points[1][i];
+				if (dx * dx + dy * dy <= pick_radius * pick_radius) {
+					ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+					break;
+				}
+			}
+		}
+		ImPlot::EndPlot();
 	}
+	return changed;
 }
 void TerrainGenerationSys::NoisesLevelsForBiomes() {
 	if (ImGui::CollapsingHeader("Spline editor", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -1,14 +1,22 @@
 #pragma once
 
 #include "VertexBufferLayout.h"
+#include "StreamingVertexBuffer.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "utilities.h"
 #include "TerrainGenerator.h"
 #include "BiomeGenerator.h"
+#include "VegetationGenerator.h"
+#include "SpatialIndex.h"
+#include "ModelCache.h"
+#include "CompactVertex.h"
+#include "LodQuadtree.h"
+#include "HeightPyramid.h"
 #include "Camera.h"
 #include "LightSource.h"
+#include "StageGraph.h"
 
 class TerrainGenerationSys
 {
@@ -17,10 +25,10 @@ private:
 	float heightScale, modelScale;
 	unsigned int stride;
 	int width, height, mapResolution;
-	bool wireFrame = false, changeTerrain = false;
+	bool wireFrame = false;
 	bool biomesGeneration = false, map2d = false;
 	bool editNoise = false, editSpline = false, infiniteGeneration = false;
-	glm::vec3 oldCamPos = glm::vec3(0.0f);
+	bool biomeHeightShaping = false;
 
 	//OpenGl objects
 	VertexBufferLayout layout;
@@ -32,11 +40,85 @@ private:
 	std::unique_ptr<TextureClass> biomeTxt;
 
 	TerrainGenerator terrainGen;
-	TerrainGenerator::EvaluationMethod evaluatingMode = TerrainGenerator::EvaluationMethod::LINEAR_COMBINE;
 	TerrainGenerator::WorldGenParameter editedComponent = TerrainGenerator::WorldGenParameter::CONTINENTALNESS;
 	utilities::heightMapMode displayMode = utilities::heightMapMode::TOPOGRAPHICAL;
 	BiomeGenerator biomeGen;
 	BiomeParameter editedBiomeComponent = BiomeParameter::TEMPERATURE;
+	vegetation::VegetationGenerator vegetationGen;
+	spatial::SpatialGrid<vegetation::VegetationInstance> vegetationIndex;
+	std::vector<spatial::Range> visibleVegetation;
+	size_t visibleVegetationCount = 0;
+	ModelCache modelCache;
+	std::unique_ptr<Shader> vegetationShader;
+	int treeModel = -1;
+	//Vegetation is scattered by its stage once enabled and follows every change of the terrain and biomes afterwards
+	bool scatterVegetation = false;
+	bool drawVegetation = true;
+	float vegetationModelScale = 1.0f;
+
+	//Height texture quantized to 16 bits with a mip pyramid built on the CPU, kept for CPU side queries
+	bool quantizedHeights = false;
+	utilities::MipReduction heightMipReduction = utilities::MipReduction::AVERAGE;
+	utilities::HeightPyramid heightPyramid;
+	//Octahedral normal map sampled by the tessellation shader instead of four extra height fetches per vertex
+	bool precomputedNormals = true;
+	utilities::OctNormalMap normalMap;
+	std::unique_ptr<TextureClass> normalTxt;
+	//Texture unit sampled as heightMap by the main shader, 1 while a component noise is edited
+	int heightMapUnit = 0;
+	//Noise uploaded into the preview texture while heightMapUnit is 1
+	noise::SimplexNoiseClass* previewedNoise = nullptr;
+
+	//Generation stages recomputed by UpdateStages only when their configuration or inputs changed, see BuildStageGraph
+	struct GenerationStages {
+		int componentNoises[3], biomeNoises[2];
+		int biomeClassify, biomeBlend, biomeShaping, biomeColors;
+		int combine, heightPyramid, normals, vegetation;
+		int heightUpload, normalUpload, biomeUpload, noisePreview;
+	};
+	utilities::StageGraph stageGraph;
+	GenerationStages stages;
+	//Origin of the generated map, follows the camera during infinite generation
+	glm::vec2 terrainOrigin = glm::vec2(0.0f);
+	std::vector<glm::vec3> biomeColors;
+
+	//Compact vertex mesh drawn instead of the tessellated patches
+	//The mesh is split into bands of compactBandRows rows culled against the frustum, visible bands share one strip
+	//index buffer and are drawn with a single multi-draw call (the shorter last band uses its own buffer)
+	struct CompactBand {
+		int baseVertex;
+		int firstRow, rows;
+		float minHeight, maxHeight;
+	};
+	bool compactMesh = false, compactMeshDirty = true;
+	utilities::NormalPrecision compactPrecision = utilities::NormalPrecision::OCT16;
+	utilities::HeightQuantization compactQuantization;
+	size_t compactVertexBytes = 0;
+	int compactBandRows = 64;
+	std::vector<CompactBand> compactBands;
+	std::vector<int> compactVisibleBaseVertices;
+	int compactVisibleBands = 0, compactDrawCalls = 0;
+	std::unique_ptr<VertexArray> compactVAO;
+	std::unique_ptr<VertexBuffer> compactVertexBuffer;
+	std::shared_ptr<IndexBuffer> compactBandIndices, compactLastBandIndices;
+	std::unique_ptr<Shader> compactShader;
+	std::unique_ptr<TextureClass> paletteTxt;
+
+	//CDLOD quadtree drawn with a shared grid mesh instead of the tessellated patches
+	lod::LodQuadtree lodTree;
+	bool lodMesh = false, lodTreeDirty = true, lodFreezeSelection = false;
+	float lodPixelError = 2.0f;
+	int lodGridResolution = 32;
+	std::unique_ptr<VertexArray> lodGridVAO;
+	std::unique_ptr<VertexBuffer> lodGridVertexBuffer;
+	std::unique_ptr<StreamingVertexBuffer> lodNodeBuffer;
+	std::shared_ptr<IndexBuffer> lodGridIndexBuffer;
+	struct LodNodeInstance {
+		glm::vec3 node;
+		glm::vec2 morphRange;
+	};
+	std::vector<LodNodeInstance> lodNodeInstances;
+	std::unique_ptr<Shader> lodShader;
 
 	struct Point {
 		float x, y;
@@ -45,6 +127,8 @@ private:
 		{-1.0, 0.0, 1.0},
 		{0.0, 0.0, 0.0}
 	};
+	int editedHeightCurveBiome = -1;
+	std::vector<std::vector<double>> heightCurvePoints;
 
 public:
 	TerrainGenerationSys();
@@ -52,18 +136,36 @@ public:
 	
 	bool Initialize(unsigned int _height, unsigned int _width, float _heightScale);
 	bool Resize();
-	bool GenerateTerrain(float originx, float originy);
-	bool GenerateBiomes();
+	void BuildStageGraph();
+	void UpdateStages();
+	bool IsBiomeShapingActive() const;
+	bool GenerateVegetation();
+	void BakeBiomeHeightCurves();
+	void UpdateNoiseTexture(noise::SimplexNoiseClass& noise);
+	void UpdateTerrainTexture();
+	void UpdateNormalTexture();
+	const utilities::HeightPyramid& GetHeightPyramid() const { return heightPyramid; }
+	bool BuildCompactMesh();
+	bool BuildLodTree();
+	void DrawLod(Renderer& renderer, Camera& camera, LightSource& light, const glm::mat4& model);
+	void DrawCompact(Renderer& renderer, Camera& camera, LightSource& light, const glm::mat4& model);
+	static VertexBufferLayout GetLodNodeLayout();
+	glm::mat4 GetMapToWorld(const glm::mat4& model) const;
 
 	void Draw(Renderer& renderer, Camera& camera, LightSource& light);
+	void DrawVegetation(Renderer& renderer, Camera& camera, LightSource& light, const glm::mat4& mapToWorld);
 	void ImGuiRightPanel();
 	void ImGuiLeftPanel();
 	void ImGuiOutput(glm::vec3 pos);
+	void ReportMemoryUsage() const;
 	void NoiseEditor();
 	void BiomesEditor();
 	void BiomeNoisesEditor();
 	void SplineEditor();
+	bool CurveEditor(const char* label, std::vector<std::vector<double>>& points, double xmin, double xmax);
+	void BiomeHeightCurvesEditor();
 	void NoisesLevelsForBiomes();
+	void VegetationEditor();
 	void SegmentDrag(std::vector<float>& boundaries, std::string s);
 };
 
@@ -8,6 +8,16 @@
 #include "Noise.h"
 
 namespace biome {
+	//Maximal number of biomes stored per pixel by the biome blending stage
+	constexpr int MAX_BLENDED_BIOMES = 4;
+
+	//Compact biome blending entry of a single pixel, sorted by weight in descending order
+	//Weights are quantized so they sum up to 255, unused slots have weight equal to 0
+	struct BiomeWeights {
+		unsigned char ids[MAX_BLENDED_BIOMES];
+		unsigned char weights[MAX_BLENDED_BIOMES];
+	};
+
 	class Biome
 	{
 	private:
@@ -17,10 +27,12 @@ namespace biome {
 		std::string name;
 		glm::vec2 temperatureLevel,humidityLevel, continentalnessLevel, mountainousnessLevel, weirdnessLevel;
 		glm::vec3 color = glm::vec3(0.0f, 0.0f, 0.0f);
+		//Control points {X, Y} of the curve reshaping normalized elevation inside the biome, identity by default
+		std::vector<std::vector<double>> heightCurve = { {0.0, 1.0}, {0.0, 1.0} };
 	public:
 		Biome();
 		Biome(int _id, std::string _name);
-		Biome(int _id, std::string _name, glm::vec2 _temperatureLevel, glm::vec2 _humidityLevel, glm::vec2 _continentalnessLevel, glm::vec2 _mountainousnessLevel, glm::vec2 _weirdnessLevel, glm::vec3 _color, int _vegetationLevel);
+		Biome(int _id, std::string _name, glm::vec2 _temperatureLevel, glm::vec2 _humidityLevel, glm::vec2 _continentalnessLevel, glm::vec2 _mountainousnessLevel, glm::vec2 _weirdnessLevel, glm::vec3 _color, float _vegetationLevel);
 		Biome(const Biome& b) = default;
 		~Biome();
 
@@ -35,12 +47,14 @@ namespace biome {
 		glm::vec2 GetContinentalnessLevel() const { return continentalnessLevel; };
 		glm::vec2 GetMountainousnessLevel() const { return mountainousnessLevel; };
 		glm::vec3 GetColor() const { return color; };
+		const std::vector<std::vector<double>>& GetHeightCurve() const { return heightCurve; };
 		
 		void SetTemperatureLevel(glm::vec2 temperatureLevel) { this->temperatureLevel = temperatureLevel; }
 		void SetHumidityLevel(glm::vec2 humidityLevel) { this->humidityLevel = humidityLevel; }
 		void SetContinentalnessLevel(glm::vec2 continentalnessLevel) { this->continentalnessLevel = continentalnessLevel; }
 		void SetMountainousnessLevel(glm::vec2 mountainousnessLevel) { this->mountainousnessLevel = mountainousnessLevel; }
 		void SetWeirdnessLevel(glm::vec2 weirdnessLevel) { this->weirdnessLevel = weirdnessLevel; }
+		void SetHeightCurve(std::vector<std::vector<double>> heightCurve) { this->heightCurve = heightCurve; }
 
 	};
 }
\ No newline at end of file
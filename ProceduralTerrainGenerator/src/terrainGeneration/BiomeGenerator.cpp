@@ -1,30 +1,34 @@
 #include "BiomeGenerator.h"
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
 
-BiomeGenerator::BiomeGenerator() : temperatureNoise(), humidityNoise(), biomeMap(nullptr), height(0), width(0), biomesLevels(5)
+#include "Parallel.h"
+#include "ScratchArena.h"
+#include "Trace.h"
+#include "Log.h"
+
+BiomeGenerator::BiomeGenerator() : temperatureNoise(), humidityNoise(), height(0), width(0), biomesLevels(5)
 {
 }
 
 BiomeGenerator::~BiomeGenerator()
 {
-	if (biomeMap) {
-		delete[] biomeMap;
-	}
 }
 
 bool BiomeGenerator::Initialize(int _height, int _width)
 {
-	if (biomeMap) {
-		std::cout << "[ERROR] BiomeMap already initialized" << std::endl;
+	if (!biomeMap.IsEmpty()) {
+		LOG_ERROR("BiomeMap already initialized");
 		return false;
 	}
 
 	if (!temperatureNoise.Initialize(_height, _width)) {
-		std::cout << "[ERROR] Temperature noise couldnt be initialized\n";
+		LOG_ERROR("Temperature noise couldnt be initialized");
 		return false;
 	}
 	if (!humidityNoise.Initialize(_height, _width)) {
-		std::cout << "[ERROR] Humidity noise couldnt be initialized\n";
+		LOG_ERROR("Humidity noise couldnt be initialized");
 		return false;
 	}
 
@@ -44,15 +48,22 @@ bool BiomeGenerator::Initialize(int _height, int _width)
 	humidityNoise.GetConfigRef().scale = 0.3f;
 	humidityNoise.GetConfigRef().constrast = 1.5f;
 
+	//Last value is the vegetation density of the biome, 0 - 1
 	std::vector<biome::Biome>b = {
 		biome::Biome(0, "Grassplains",	{1, 2}, {1, 4}, {3, 5}, {0, 3}, {0, 1}, glm::vec3(0.2f, 0.8f, 0.2f), 1.0f),
-		biome::Biome(1, "Desert",		{2, 4}, {0, 1}, {3, 5}, {0, 4}, {0, 1}, glm::vec3(0.95f, 0.1f, 0.1f), 1.0f),
-		biome::Biome(2, "Snow",			{0, 1}, {0, 4}, {3, 5}, {0, 4}, {0, 1}, glm::vec3(0.95f, 0.95f, 0.95f), 1.0f),
-		biome::Biome(3, "Sand",			{0, 4}, {0, 4}, {2, 3}, {0, 7}, {0, 1}, glm::vec3(0.93f, 0.82f, 0.55f), 1.0f),
-		biome::Biome(4, "Mountain",		{0, 4}, {0, 4}, {4, 5}, {4, 7}, {0, 1}, glm::vec3(0.5f, 0.5f, 0.5f), 1.0f),
-		biome::Biome(5, "Ocean",		{0, 4}, {0, 4}, {0, 2}, {0, 7}, {0, 1}, glm::vec3(0.2f, 0.4f, 0.85f), 1.0f)
+		biome::Biome(1, "Desert",		{2, 4}, {0, 1}, {3, 5}, {0, 4}, {0, 1}, glm::vec3(0.95f, 0.1f, 0.1f), 0.05f),
+		biome::Biome(2, "Snow",			{0, 1}, {0, 4}, {3, 5}, {0, 4}, {0, 1}, glm::vec3(0.95f, 0.95f, 0.95f), 0.1f),
+		biome::Biome(3, "Sand",			{0, 4}, {0, 4}, {2, 3}, {0, 7}, {0, 1}, glm::vec3(0.93f, 0.82f, 0.55f), 0.2f),
+		biome::Biome(4, "Mountain",		{0, 4}, {0, 4}, {4, 5}, {4, 7}, {0, 1}, glm::vec3(0.5f, 0.5f, 0.5f), 0.4f),
+		biome::Biome(5, "Ocean",		{0, 4}, {0, 4}, {0, 2}, {0, 7}, {0, 1}, glm::vec3(0.2f, 0.4f, 0.85f), 0.0f)
 	};
 
+	//Height curves, plains and deserts are flattened, mountains get sharper peaks and oceans deeper floor
+	b[0].SetHeightCurve({ {0.0, 0.4, 1.0}, {0.0, 0.35, 0.8} });
+	b[1].SetHeightCurve({ {0.0, 0.5, 1.0}, {0.0, 0.45, 0.75} });
+	b[4].SetHeightCurve({ {0.0, 0.5, 0.8, 1.0}, {0.0, 0.45, 0.85, 1.0} });
+	b[5].SetHeightCurve({ {0.0, 0.3, 1.0}, {0.0, 0.2, 1.0} });
+
 	//Value -1 as a lower boundry
 	std::vector<std::vector<float>> r = {
 		{-1.0f, -0.5f, 0.0f, 0.5f, 1.01f},
@@ -69,7 +80,7 @@ bool BiomeGenerator::Initialize(int _height, int _width)
 		return false;
 	}
 	//Calculating component noises with basic configuration
-	if (GenerateComponentNoises()) {
+	if (!GenerateComponentNoises()) {
 		return false;
 	}
 
@@ -79,25 +90,24 @@ bool BiomeGenerator::Initialize(int _height, int _width)
 bool BiomeGenerator::Resize(int _height, int _width)
 {
 	if (_height <= 0 || _width <= 0) {
-		std::cout << "[ERROR] Biome map couldnt be resized, width and height must be greater than 0\n";
+		LOG_ERROR("Biome map couldnt be resized, width and height must be greater than 0");
 		return false;
 	}
 	if (_width == this->width && _height == this->height) {
-		std::cout << "[ERROR] Biome map is already initialized with the same size\n";
+		LOG_ERROR("Biome map is already initialized with the same size");
 		return false;
 	}
 
 	width = _width;
 	height = _height;
-	if (biomeMap) {
-		delete[] biomeMap;
-	}
-	biomeMap = new int[width * height];
+	biomeMap.Resize(width, height);
+	biomeWeights.Resize(width, height);
 	temperatureNoise.Resize(height, width);
 	humidityNoise.Resize(height, width);
 
-	std::cout << "[LOG] BiomeGenerator has been succesfully initialized with size: " << height << "x" << width << "\n";
+	LOG_INFO("BiomeGenerator has been succesfully initialized with size: " << height << "x" << width);
 	isGenerated = false;
+	isBlended = false;
 	return true;
 }
 
@@ -105,32 +115,177 @@ bool BiomeGenerator::Resize(int _height, int _width)
 
 bool BiomeGenerator::Biomify(noise::SimplexNoiseClass& continenatlness, noise::SimplexNoiseClass& mountainousness, noise::SimplexNoiseClass& weirdness)
 {
-	if(!biomeMap) {
-		std::cout << "[ERROR] BiomeMap not initialized\n";
+	TRACE_ZONE("Biomify");
+	if(biomeMap.IsEmpty()) {
+		LOG_ERROR("BiomeMap not initialized");
 		return false;
 	}
 	if( continenatlness.GetHeight() != height || continenatlness.GetWidth() != width ||
 		mountainousness.GetHeight() != height || mountainousness.GetWidth() != width ||
 		weirdness.GetHeight() != height || weirdness.GetWidth() != width) {
-		std::cout << "[ERROR] One of the component noises has invalid size\n";
+		LOG_ERROR("One of the component noises has invalid size");
 		return false;
 	}
 
-	int T, H, C, M, W;
+	//Component maps are read through views, the sizes were checked above
+	const utilities::GridView<const float> humidity = humidityNoise.GetView(), temperature = temperatureNoise.GetView();
+	const utilities::GridView<const float> c = continenatlness.GetView(), m = mountainousness.GetView(), w = weirdness.GetView();
+
+	utilities::ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+		int T, H, C, M, W;
 
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			H = DetermineLevel(BiomeParameter::HUMIDITY, humidityNoise.GetVal(x, y));
-			T = DetermineLevel(BiomeParameter::TEMPERATURE, temperatureNoise.GetVal(x, y));
-			C = DetermineLevel(BiomeParameter::CONTINENTALNESS, continenatlness.GetVal(x, y));
-			M = DetermineLevel(BiomeParameter::MOUNTAINOUSNESS, mountainousness.GetVal(x, y));
-			W = DetermineLevel(BiomeParameter::WEIRDNESS, weirdness.GetVal(x, y)); 
+		for (int y = bandBegin; y < bandEnd; y++) {
+			int* row = biomeMap.Row(y);
+			for (int x = 0; x < width; x++) {
+				H = DetermineLevel(BiomeParameter::HUMIDITY, humidity(x, y));
+				T = DetermineLevel(BiomeParameter::TEMPERATURE, temperature(x, y));
+				C = DetermineLevel(BiomeParameter::CONTINENTALNESS, c(x, y));
+				M = DetermineLevel(BiomeParameter::MOUNTAINOUSNESS, m(x, y));
+				W = DetermineLevel(BiomeParameter::WEIRDNESS, w(x, y));
 
-			biomeMap[y * width + x] = DetermineBiome(H, T, C, M, W);
+				row[x] = DetermineBiome(H, T, C, M, W);
+			}
 		}
-	}
-	std::cout << "[LOG] BiomeMap succesfully evaluated" << std::endl;
+	});
+	LOG_INFO("BiomeMap succesfully evaluated");
 	isGenerated = true;
+	isBlended = false;
+	return true;
+}
+
+//Computes up to MAX_BLENDED_BIOMES biome weights per pixel, weight of a biome is the fraction of pixels
+//belonging to it in the (2 * blendRadius + 1)^2 window around the pixel.
+//Every biome's one-hot mask is box filtered with separable running sums, so the cost does not depend on the radius,
+//the vertical pass is fused with the top-K selection. Rows are processed in parallel bands.
+//@return - true if the weights were computed, false if the biome map is missing or blending is disabled
+bool BiomeGenerator::BlendBiomes()
+{
+	TRACE_ZONE("BlendBiomes");
+	if (biomeMap.IsEmpty() || biomeWeights.IsEmpty() || !isGenerated) {
+		LOG_ERROR("BiomeMap has to be generated before blending");
+		return false;
+	}
+	if (blendRadius <= 0) {
+		isBlended = false;
+		return false;
+	}
+
+	const int K = biome::MAX_BLENDED_BIOMES;
+	const int r = blendRadius;
+	const size_t size = static_cast<size_t>(width) * height;
+
+	//Horizontally filtered mask of the current biome and per pixel top-K candidates, released with the scope
+	utilities::ScratchArena& scratch = utilities::GetThreadScratch();
+	utilities::ScratchScope scope(scratch);
+	uint16_t* rowSums = scratch.Allocate<uint16_t>(size);
+	uint32_t* topCounts = scratch.AllocateZeroed<uint32_t>(size * K);
+	unsigned char* topIds = scratch.AllocateZeroed<unsigned char>(size * K);
+
+	for (auto& it : biomes) {
+		const int id = it.first;
+		if (id < 0 || id > 255) {
+			LOG_ERROR("Biome id: " << id << " cant be stored in blending weights");
+			continue;
+		}
+
+		//Horizontal pass, running sum over window [x - r, x + r] clipped to the map
+		utilities::ParallelFor(0, height, [&](int y0, int y1) {
+			for (int y = y0; y < y1; y++) {
+				const int* row = biomeMap.Row(y);
+				uint16_t* out = rowSums + static_cast<size_t>(y) * width;
+				int sum = 0;
+				for (int x = 0; x < std::min(r, width); x++) {
+					sum += row[x] == id;
+				}
+				for (int x = 0; x < width; x++) {
+					if (x + r < width) {
+						sum += row[x + r] == id;
+					}
+					if (x - r - 1 >= 0) {
+						sum -= row[x - r - 1] == id;
+					}
+					out[x] = static_cast<uint16_t>(sum);
+				}
+			}
+		});
+
+		//Vertical pass with a per column accumulator, each band primes its window independently
+		utilities::ParallelFor(0, height, [&](int y0, int y1) {
+			utilities::ScratchArena& bandScratch = utilities::GetThreadScratch();
+			utilities::ScratchScope bandScope(bandScratch);
+			uint32_t* acc = bandScratch.AllocateZeroed<uint32_t>(width);
+			for (int y = std::max(0, y0 - r); y < std::min(height, y0 + r); y++) {
+				const uint16_t* row = rowSums + static_cast<size_t>(y) * width;
+				for (int x = 0; x < width; x++) {
+					acc[x] += row[x];
+				}
+			}
+			for (int y = y0; y < y1; y++) {
+				if (y + r < height) {
+					const uint16_t* row = rowSums + static_cast<size_t>(y + r) * width;
+					for (int x = 0; x < width; x++) {
+						acc[x] += row[x];
+					}
+				}
+				if (y - r - 1 >= 0) {
+					const uint16_t* row = rowSums + static_cast<size_t>(y - r - 1) * width;
+					for (int x = 0; x < width; x++) {
+						acc[x] -= row[x];
+					}
+				}
+				//Insertion into the sorted top-K list of the pixel
+				for (int x = 0; x < width; x++) {
+					uint32_t count = acc[x];
+					size_t base = (static_cast<size_t>(y) * width + x) * K;
+					if (count == 0 || count <= topCounts[base + K - 1]) {
+						continue;
+					}
+					int slot = K - 1;
+					while (slot > 0 && topCounts[base + slot - 1] < count) {
+						topCounts[base + slot] = topCounts[base + slot - 1];
+						topIds[base + slot] = topIds[base + slot - 1];
+						slot--;
+					}
+					topCounts[base + slot] = count;
+					topIds[base + slot] = static_cast<unsigned char>(id);
+				}
+			}
+		});
+	}
+
+	//Normalizing kept counts into 8-bit weights summing up to 255
+	biome::BiomeWeights* weights = biomeWeights.Data();
+	const int* map = biomeMap.Data();
+	utilities::ParallelFor(0, height, [&](int y0, int y1) {
+		for (size_t i = static_cast<size_t>(y0) * width; i < static_cast<size_t>(y1) * width; i++) {
+			const uint32_t* counts = topCounts + i * K;
+			uint32_t total = 0;
+			for (int k = 0; k < K; k++) {
+				total += counts[k];
+			}
+			//No biome counted in the window, the pixel keeps its own biome
+			if (total == 0) {
+				for (int k = 0; k < K; k++) {
+					weights[i].ids[k] = 0;
+					weights[i].weights[k] = 0;
+				}
+				weights[i].ids[0] = static_cast<unsigned char>(map[i]);
+				weights[i].weights[0] = 255;
+				continue;
+			}
+			int assigned = 0;
+			for (int k = 0; k < K; k++) {
+				weights[i].ids[k] = topIds[i * K + k];
+				weights[i].weights[k] = static_cast<unsigned char>(counts[k] * 255 / total);
+				assigned += weights[i].weights[k];
+			}
+			//Rounding leftover goes to the dominant biome
+			weights[i].weights[0] += static_cast<unsigned char>(255 - assigned);
+		}
+	});
+
+	isBlended = true;
+	LOG_INFO("Biome weights succesfully blended with radius: " << blendRadius);
 	return true;
 }
 
@@ -176,7 +331,7 @@ int BiomeGenerator::DetermineLevel(BiomeParameter p, float value)
 		break;
 	}
 	default:
-		std::cout << "[ERROR] Wrong biome option!" << std::endl;
+		LOG_ERROR("Wrong biome option!");
 		return -1;
 		break;
 	}
@@ -185,16 +340,16 @@ int BiomeGenerator::DetermineLevel(BiomeParameter p, float value)
 			return i - 1;
 		}
 	}
-	std::cout << "[ERROR] Level not found for value: " << value << std::endl;
+	LOG_ERROR("Level not found for value: " << value);
 	return -2;
 }
 
-bool BiomeGenerator::GenerateComponentNoises()
+bool BiomeGenerator::GenerateComponentNoises(float originx, float originy)
 {
-	if (!temperatureNoise.GenerateFractalNoise(0.0f, 0.0f)) {
+	if (!temperatureNoise.GenerateFractalNoise(originx, originy)) {
 		return false;
 	}
-	if (!humidityNoise.GenerateFractalNoise(0.0f, 0.0f)) {
+	if (!humidityNoise.GenerateFractalNoise(originx, originy)) {
 		return false;
 	}
 
@@ -205,7 +360,7 @@ bool BiomeGenerator::GenerateComponentNoises()
 bool BiomeGenerator::SetRanges(std::vector<std::vector<float>>& ranges)
 {
 	if (ranges.size() != 5) {
-		std::cout << "[ERROR] Ranges initialization array empty!" << std::endl;
+		LOG_ERROR("Ranges initialization array empty!");
 		return false;
 	}
 
@@ -243,7 +398,7 @@ bool BiomeGenerator::SetRange(BiomeParameter c, std::vector<float> range)
 		break;
 	}
 	default:
-		std::cout << "[ERROR] Wrong biome option!" << std::endl;
+		LOG_ERROR("Wrong biome option!");
 		return false;
 		break;
 	}
@@ -253,7 +408,7 @@ bool BiomeGenerator::SetRange(BiomeParameter c, std::vector<float> range)
 bool BiomeGenerator::SetBiomes(std::vector<biome::Biome>& b)
 {
 	if (b.empty()) {
-		std::cout << "[ERROR] Biomes initialization array empty!" << std::endl;
+		LOG_ERROR("Biomes initialization array empty!");
 		return false;
 	}
 
@@ -266,16 +421,16 @@ bool BiomeGenerator::SetBiomes(std::vector<biome::Biome>& b)
 
 int BiomeGenerator::GetBiomeAt(int x, int y)
 {
-	if (!biomeMap || width == 0 || height == 0) {
-		std::cout << "[ERROR] BiomeMap has not been initialized!\n";
+	if (biomeMap.IsEmpty() || width == 0 || height == 0) {
+		LOG_ERROR("BiomeMap has not been initialized!");
 		return -1;
 	}
 	if( x < 0 || x >= width || y < 0 || y >= height) {
-		std::cout << "[ERROR] Coordinates out of bounds!" << std::endl;
+		LOG_ERROR("Coordinates out of bounds!");
 		return -1;
 	}
 	
-	return biomeMap[y * width + x];
+	return biomeMap(x, y);
 }
 
 noise::SimplexNoiseClass& BiomeGenerator::GetNoiseByParameter(BiomeParameter p)
@@ -288,7 +443,7 @@ noise::SimplexNoiseClass& BiomeGenerator::GetNoiseByParameter(BiomeParameter p)
 		return temperatureNoise;
 		break;
 	default:
-		std::cout << "[ERROR] Wrong biome option!" << std::endl;
+		LOG_ERROR("Wrong biome option!");
 		return temperatureNoise;
 		break;
 	}
@@ -324,7 +479,7 @@ std::vector<float>& BiomeGenerator::GetLevelsByParameter(BiomeParameter p)
 	}
 	default:
 	{
-		std::cout << "[ERROR] Wrong biome option!" << std::endl;
+		LOG_ERROR("Wrong biome option!");
 		break;
 	}
 	}
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Biome.h"
+#include "Grid.h"
 
 enum class BiomeParameter {
 	CONTINENTALNESS,
@@ -16,9 +17,10 @@ enum class BiomeParameter {
 class BiomeGenerator
 {
 private:
-	int* biomeMap;
-	int height, width;
-	bool isGenerated = false;
+	utilities::Grid<int> biomeMap;
+	utilities::Grid<biome::BiomeWeights> biomeWeights;
+	int height, width, blendRadius = 0;
+	bool isGenerated = false, isBlended = false;
 
 	std::unordered_map<int, biome::Biome> biomes;
 	std::vector<std::vector<float>> biomesLevels;
@@ -32,18 +34,27 @@ public:
 	bool Initialize(int _height, int _width);
 	bool Resize(int _height, int _width);
 	bool IsGenerated() const { return isGenerated; };
+	int GetWidth() const { return width; };
+	int GetHeight() const { return height; };
 	void Regenerate() { isGenerated = false; };
 	bool Biomify(noise::SimplexNoiseClass& continenatlness, noise::SimplexNoiseClass& mountainousness, noise::SimplexNoiseClass& weirdness);
 	int DetermineBiome(const int& temperature, const int& humidity, const int& continentalness, const int& mountainousness, const int& weirdness);
 	int DetermineLevel(BiomeParameter p, float value);
-	bool GenerateComponentNoises();
+	bool GenerateComponentNoises(float originx = 0.0f, float originy = 0.0f);
+	bool BlendBiomes();
 
 	bool SetRanges(std::vector<std::vector<float>>& ranges);
 	bool SetRange(BiomeParameter p, std::vector<float> range);
 	bool SetBiomes(std::vector<biome::Biome>& b);
 
 	biome::Biome& GetBiome(int id) { return biomes[id]; };
-	int* GetBiomeMap() const { return biomeMap; };
+	const std::unordered_map<int, biome::Biome>& GetBiomes() const { return biomes; };
+	bool HasBiome(int id) const { return biomes.find(id) != biomes.end(); };
+	const int* GetBiomeMap() const { return biomeMap.Data(); };
+	bool IsBlended() const { return isBlended; };
+	const biome::BiomeWeights* GetBiomeWeights() const { return isBlended ? biomeWeights.Data() : nullptr; };
+	int& GetBlendRadiusRef() { return blendRadius; };
+	size_t GetByteSize() const { return biomeMap.GetByteSize() + biomeWeights.GetByteSize() + temperatureNoise.GetByteSize() + humidityNoise.GetByteSize(); };
 	int GetBiomeAt(int x, int y);
 	noise::NoiseConfigParameters& GetTemperatureNoiseConfig() { return temperatureNoise.GetConfigRef(); };
 	noise::NoiseConfigParameters& GetHumidityNoiseConfig() { return humidityNoise.GetConfigRef(); };
@@ -1,44 +1,16 @@
 #include "Erosion.h"
 
+#include <new>
 #include <math.h>
 #include <random>
-#include <queue>
 #include <iostream>
+#include <algorithm>
 
-namespace erosion {
-	//Primitive listNode to use and test erosion
-	//TODO: Implement a more efficient data structure
-	struct ListNode
-	{
-		Droplet* d;
-		ListNode* next;
-
-		ListNode(vec2 position, float velocity, float water, float capacity) : d(new Droplet(position, velocity, water, capacity)), next(nullptr) {}
-
-		~ListNode() {
-			delete d;
-		}
-
-		ListNode* deleteNode(ListNode* prev) {
-			ListNode* next = this->next;
-			if (prev != nullptr) {
-				prev->next = next;
-			}
-			delete this;
-			return next;
-		}
-
-		void deleteAll() {
-			ListNode* current = this;
-			while (current != nullptr) {
-				ListNode* nextNode = current->next;
-				delete current;
-				current = nextNode;
-			}
-		}
-	};
+#include "Trace.h"
+#include "Log.h"
 
-	Erosion::Erosion(int width, int height) : width(width), height(height), map(nullptr)
+namespace erosion {
+	Erosion::Erosion(int width, int height) : width(width), height(height)
 	{
 	}
 
@@ -73,18 +45,20 @@ namespace erosion {
 		this->height = height;
 	}
 
-	//Set the heightsMap to be eroded
-	//@param _map - pointer to the map to be eroded
-	void Erosion::SetMap(float* _map)
+	//Set the heightsMap to be eroded, the erosion works on its own copy so the source stays intact
+	//The storage is reused between calls as long as the size does not grow
+	//@param source - view of the map to be eroded, has to match the size of the erosion
+	//@return - false if the sizes differ
+	bool Erosion::SetMap(utilities::GridView<const float> source)
 	{
 		if(!changeMap) {
-			return;
+			return true;
 		}
-
-		delete[] map;
-		this->map = new float[width * height];
-
-		std::copy(_map, _map + (width * height), this->map);
+		if (source.GetWidth() != width || source.GetHeight() != height || !map.Resize(width, height)) {
+			LOG_ERROR("Map of size: " << source.GetHeight() << "x" << source.GetWidth() << " doesnt match the erosion size");
+			return false;
+		}
+		return map.View().CopyFrom(source);
 	}
 
 	//Get the reference to the configuration of the erosion
@@ -112,12 +86,19 @@ namespace erosion {
 	//@param Track - optional pointer to the array of vertices to store the path of the droplet (pass std::nullopt to disable)
 	void Erosion::Erode(std::optional<float*> Track)
 	{
-		ListNode* dropletsHead = nullptr;
-		ListNode* dropletPrev = nullptr;
-		ListNode* dropletCurrent = nullptr;
+		TRACE_ZONE("Erode");
+		if (map.IsEmpty()) {
+			LOG_ERROR("Map to erode is not set");
+			return;
+		}
+
+		//Droplets of the whole simulation live in the scratch arena of the thread and are released at once
+		utilities::ScratchArena& scratch = utilities::GetThreadScratch();
+		utilities::ScratchScope scope(scratch);
+		Droplet* droplets = scratch.Allocate<Droplet>(dropletCount);
+		int alive = 0;
 
-		std::random_device rd;
-		std::mt19937 gen(rd());
+		std::mt19937 gen(config.seed != 0 ? config.seed : std::random_device{}());
 		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
 				
 		vec2 gradient;
@@ -126,99 +107,79 @@ namespace erosion {
 		int fellOff = 0;
 		int step = 0;
 
-		//Placeholder node
-		dropletsHead = new ListNode({ 0.0f, 0.0f }, 0.0f, 0.0f, 0.0f);
-		dropletCurrent = dropletsHead;
-
 		//Creatint a new droplets on a random cell on the map
 		//Initialize the droplet with initial values cofigured by the user
 		for (int i = 0; i < dropletCount; i++) {
-			dropletCurrent->next = new ListNode({ dist(gen) * width, dist(gen) * height }, config.initialVelocity, config.initialWater, config.initialCapacity);
-			dropletCurrent = dropletCurrent->next;
+			Droplet* droplet = new (&droplets[alive++]) Droplet({ dist(gen) * width, dist(gen) * height }, config.initialVelocity, config.initialWater, config.initialCapacity);
 
 			//If tracking enabled, save the droplets initial positions
 			if(Track.has_value() && Track.value())
-				TrackDroplets(Track.value(), dropletCurrent->d->GetPosition(), step++);
+				TrackDroplets(Track.value(), droplet->GetPosition(), step++);
 		}
 
-		dropletCurrent = dropletsHead->next;
-		dropletPrev = dropletsHead;
-
 		for (int i = 0; i < config.dropletLifetime; i++) {
-			if (!dropletsHead->next) {
+			if (alive == 0) {
 				break;
 			}
+			TRACE_ZONE("Erosion step");
 
-			dropletCurrent = dropletsHead->next;
-			dropletPrev = dropletsHead;
-
-			while (dropletCurrent) {
-				if (log) {
-					std::cout << "------------------------------------\n";
-				}
+			//Droplets staying on the map are compacted in place, so they keep their order
+			int kept = 0;
+			for (int j = 0; j < alive; j++) {
+				Droplet* droplet = &droplets[j];
 
 				//Calculate the gradient of current cell and adjust the direction of the droplet and its position
-				gradient = GetGradient(dropletCurrent->d->GetPosition());
-				oldPosition = dropletCurrent->d->GetPosition();
-				dropletCurrent->d->AdjustDirection(gradient, config.inertia);
+				gradient = GetGradient(droplet->GetPosition());
+				oldPosition = droplet->GetPosition();
+				droplet->AdjustDirection(gradient, config.inertia, gen);
 				
 				//If tracking enabled, save the droplets path
 				if (Track.has_value() && Track.value())
-					TrackDroplets(Track.value(), dropletCurrent->d->GetPosition(), step++);
+					TrackDroplets(Track.value(), droplet->GetPosition(), step++);
 
 				//Check if the droplet is still on the map
-				if (IsOnMap(dropletCurrent->d->GetPosition())) {
+				if (IsOnMap(droplet->GetPosition())) {
 					//Calculate the difference in elevation between the old and new position of the droplet
-					float deltaElevation = GetElevationDifference(oldPosition, dropletCurrent->d->GetPosition());
+					float deltaElevation = GetElevationDifference(oldPosition, droplet->GetPosition());
 					
-					if (log) {
-						std::cout << "[LOG] Elevation difference: " << deltaElevation << std::endl;
-					}
+					LOG_DEBUG("Elevation difference: " << deltaElevation);
 
 					//If the droplet is moving uphill, it will drop some sediment on the old cell 
 					//in order to fill the gap whit the droplet passed, otherwise it will erode the terrain
 					//based on the calculated values or drop surplus sediment if it surpasses the capacity of the droplet
 					if (deltaElevation >= 0.0f) {
-						if(log){
-							std::cout << "[LOG] Droplet is moving uphill\n";
-						}
-						DistributeSediment(oldPosition, dropletCurrent->d->DropSediment(deltaElevation));
+						LOG_DEBUG("Droplet is moving uphill");
+						DistributeSediment(oldPosition, droplet->DropSediment(deltaElevation));
 					}
 					else {
-						if (log){
-								std::cout << "[LOG] Droplet is moving downhill\n";
-						}
+						LOG_DEBUG("Droplet is moving downhill");
 						//Calculate new capacity of the current droplet, if its carried sediment surpasses the new capacity
 						//function will return positive number which means that we need to drop some sediment on the old position
 						//based on the deposition rate. If the function returns negative number, it means we can erode points in the range
 						//of erosion radius and gather possible to collect sediment ammount and add it to the droplet.
-						float sedimentToCollect = dropletCurrent->d->AdjustCapacity(config.minSlope, config.erosionRate, config.depositionRate, deltaElevation);
+						float sedimentToCollect = droplet->AdjustCapacity(config.minSlope, config.erosionRate, config.depositionRate, deltaElevation);
 						
 						if (sedimentToCollect > 0.0f) {
 							DistributeSediment(oldPosition, sedimentToCollect);
 						}
 						else {
 							sedimentToCollect = -sedimentToCollect;
-							dropletCurrent->d->AdjustSediment(ErodeRadius(oldPosition, dropletCurrent->d->GetPosition(), sedimentToCollect));
+							droplet->AdjustSediment(ErodeRadius(oldPosition, droplet->GetPosition(), sedimentToCollect, scratch));
 						}
 
 					}
-					dropletCurrent->d->AdjustVelocity(deltaElevation, config.gravity);
-					dropletCurrent->d->Evaporate(config.evaporationRate);
-					dropletPrev = dropletCurrent;
-					dropletCurrent = dropletCurrent->next;
+					droplet->AdjustVelocity(deltaElevation, config.gravity);
+					droplet->Evaporate(config.evaporationRate);
+					droplets[kept++] = *droplet;
 				}
 				else {
-					//If the droplet fell off the map, delete it from the list
-					dropletCurrent = dropletCurrent->deleteNode(dropletPrev);
+					//If the droplet fell off the map, it is dropped from the array
 					fellOff++;
 				}
 			}
+			alive = kept;
 		}
-		std::cout << "[LOG] Droplets out of the map: " << fellOff << std::endl;
-
-		if (dropletsHead)
-			dropletsHead->deleteAll();
+		LOG_INFO("Droplets out of the map: " << fellOff);
 	}
 
 	vec2 Erosion::GetGradient(vec2 pos)
@@ -237,19 +198,17 @@ namespace erosion {
 		//Formula used: g(pos) = ( (P(x+1, y) - P(x, y)) * (1 - v) + (P(x+1, y+1) - P(x, y+1)) * v )
 		//						 ( (P(x, y+1) - P(x, y)) * (1 - u) + (P(x+1, y+1) - P(x+1, y)) * u )
 		if (x < width - 1 && y < height - 1) {
-			gradient.x = (map[y * width + x + 1] - map[y * width + x]) * (1 - v) +
-						 ((map[(y + 1) * width + x + 1] - map[(y + 1) * width + x]) * v);
-			gradient.y = (map[(y + 1) * width + x] - map[y * width + x]) * (1 - u) +
-						 ((map[(y + 1) * width + x + 1] - map[y * width + x + 1]) * u);
+			gradient.x = (map(x + 1, y) - map(x, y)) * (1 - v) +
+						 ((map(x + 1, y + 1) - map(x, y + 1)) * v);
+			gradient.y = (map(x, y + 1) - map(x, y)) * (1 - u) +
+						 ((map(x + 1, y + 1) - map(x + 1, y)) * u);
 		}
 		else {
 			gradient.x = 1.0f;
 			gradient.y = 1.0f;
 		}
 
-		if (log) {
-			std::cout << "[LOG] Gradient: " << gradient.x << " " << gradient.y << std::endl;
-		}
+		LOG_DEBUG("Gradient: " << gradient.x << " " << gradient.y);
 		return gradient;
 	}
 
@@ -269,10 +228,10 @@ namespace erosion {
 			return 0.0f;
 		}
 
-		float diff = ((map[y * width + x] * (1 - v) * (1 - u)) + //P(x, y) * (1 - v) * (1 - u) northWest point of the cell
-					 (map[y * width + x + 1] * v * (1 - u))   + //P(x+1, y) * v * (1 - u) northEast point of the cell
-					 (map[(y + 1) * width + x] * (1 - v) * u) + //P(x, y+1) * (1 - v) * u southWest point of the cell
-					 (map[(y + 1) * width + x + 1] * v * u));   //P(x+1, y+1) * v * u southEast point of the cell
+		float diff = ((map(x, y) * (1 - v) * (1 - u)) + //P(x, y) * (1 - v) * (1 - u) northWest point of the cell
+					 (map(x + 1, y) * v * (1 - u))   + //P(x+1, y) * v * (1 - u) northEast point of the cell
+					 (map(x, y + 1) * (1 - v) * u) + //P(x, y+1) * (1 - v) * u southWest point of the cell
+					 (map(x + 1, y + 1) * v * u));   //P(x+1, y+1) * v * u southEast point of the cell
 		return diff;
 	}
 
@@ -287,9 +246,7 @@ namespace erosion {
 		float old = GetInterpolatedGridHeight(posOld);
 		float newP = GetInterpolatedGridHeight(posNew);
 
-		if (log) {
-			std::cout << "[LOG] Old: " << old << " New: " << newP << std::endl;
-		}
+		LOG_DEBUG("Old: " << old << " New: " << newP);
 
 		return newP - old;
 	}
@@ -305,18 +262,18 @@ namespace erosion {
 		//Distribute the sediment dropped by the droplet to the four corners of the cell
 		//Its not distributed in the radius of erosion in order to fill a small 1-cell gap
 		//There is no need to blur the map via radius
-		map[y * width + x] += (1 - v) * (1 - u) * sedimentDropped; //P(x, y) * (1 - v) * (1 - u) northWest point of the cell
+		map(x, y) += (1 - v) * (1 - u) * sedimentDropped; //P(x, y) * (1 - v) * (1 - u) northWest point of the cell
 		if (x < width - 1) {
-			map[y * width + x + 1] += v * (1 - u) * sedimentDropped;   //P(x+1, y) * v * (1 - u) northEast point of the cell
+			map(x + 1, y) += v * (1 - u) * sedimentDropped;   //P(x+1, y) * v * (1 - u) northEast point of the cell
 		}
 		if (y < height - 1) {
-			map[(y + 1) * width + x] += (1 - v) * u * sedimentDropped; //P(x, y+1) * (1 - v) * u southWest point of the cell
+			map(x, y + 1) += (1 - v) * u * sedimentDropped; //P(x, y+1) * (1 - v) * u southWest point of the cell
 			if (x < width - 1)
-				map[(y + 1) * width + x + 1] += v * u * sedimentDropped;   //P(x+1, y+1) * v * u southEast point of the cell
+				map(x + 1, y + 1) += v * u * sedimentDropped;   //P(x+1, y+1) * v * u southEast point of the cell
 		}
 	}
 
-	float Erosion::ErodeRadius(vec2 oldPos, vec2 newPos, float ammountEroded) {
+	float Erosion::ErodeRadius(vec2 oldPos, vec2 newPos, float ammountEroded, utilities::ScratchArena& scratch) {
 		//Erode the terrain in a circular radius around the droplet
 		//Its done due to the fact that no thermal erosion or sediment sliding is simulated in this project
 		//In order to perform mentioned above action we need to calculate weights of each point within the radius
@@ -325,7 +282,12 @@ namespace erosion {
 		float deltay;
 		float weightSum = 0.0f;
 		float weight;
-		std::queue<vec2i_f> weights;
+
+		//Points within the radius, the square around the droplet bounds their number
+		utilities::ScratchScope scope(scratch);
+		const int side = 2 * std::max(config.erosionRadius, 0);
+		vec2i_f* weights = scratch.Allocate<vec2i_f>(static_cast<size_t>(side) * side);
+		int weightCount = 0;
 
 		for (int y = static_cast<int>(oldPos.y) - config.erosionRadius; y < static_cast<int>(oldPos.y) + config.erosionRadius; y++) {
 			for (int x = static_cast<int>(oldPos.x) - config.erosionRadius; x < static_cast<int>(oldPos.x) + config.erosionRadius; x++) {
@@ -336,19 +298,16 @@ namespace erosion {
 					float distance = sqrtf(deltax * deltax + deltay * deltay);
 
 					//Check if the distance is within the erosion radius and if the point is higher than new position
-					if (distance < config.erosionRadius && map[y * width + x] > map[static_cast<int>(newPos.y) * width + static_cast<int>(newPos.x)]) {
+					if (distance < config.erosionRadius && map(x, y) > map(static_cast<int>(newPos.x), static_cast<int>(newPos.y))) {
 						weight = 1.0f - (distance / config.erosionRadius);
 						weightSum += weight;
-						weights.push({ y * width + x, weight });
+						weights[weightCount++] = { y * static_cast<int>(map.GetPitch()) + x, weight };
 					}
 				}
 			}
 		}
 
-		if (log) {
-			std::cout << "---------------Eroding-Radius---------------\n"
-						 "Number of points in the radius: " << weights.size() << std::endl;
-		}
+		LOG_DEBUG("Eroding radius, number of points in the radius: " << weightCount);
 
 		float totalErosion = 0.0f;
 		float possibleErosion;
@@ -358,24 +317,20 @@ namespace erosion {
 		//Based on blur parameter, value of the new point is interpolated between the old value and the eroded value
 		//Blur value 0.0 means that the new value is the eroded value, 
 		//blur value 1.0 means that the new value is the old value
-		while (!weights.empty())
+		float* cells = map.Data();
+		for (int i = 0; i < weightCount; i++)
 		{
-			possibleErosion = ammountEroded * (weights.front().value / weightSum);
-			possibleErosion = map[weights.front().index] >= possibleErosion ? possibleErosion : map[weights.front().index];
-			newMapValue = map[weights.front().index] - possibleErosion;
-			map[weights.front().index] *= config.blur;
-			map[weights.front().index] += (1-config.blur) * newMapValue;
+			const vec2i_f& point = weights[i];
+			possibleErosion = ammountEroded * (point.value / weightSum);
+			possibleErosion = cells[point.index] >= possibleErosion ? possibleErosion : cells[point.index];
+			newMapValue = cells[point.index] - possibleErosion;
+			cells[point.index] *= config.blur;
+			cells[point.index] += (1-config.blur) * newMapValue;
 			totalErosion += (1-config.blur) * possibleErosion;
-			weights.pop();
 
-			if (log) {
-				std::cout << "[LOG] Eroded: " << possibleErosion << std::endl;
-			}
+			LOG_DEBUG("Eroded: " << possibleErosion);
 		}
 
-		if (log) {
-			std::cout << "--------------------------------------------\n";
-		}
 		return totalErosion;
 	}
 
@@ -393,14 +348,11 @@ namespace erosion {
 	{
 	}
 
-	Droplet::~Droplet()
-	{
-	}
-
 	//Adjust the direction of the droplet based on the gradient of the current cell
 	//@param gradient - gradient of the current cell
 	//@param inertia - inertia parameter
-	void Droplet::AdjustDirection(vec2 gradient, float inertia)
+	//@param generator - random generator of the erosion, used when the droplet stands still
+	void Droplet::AdjustDirection(vec2 gradient, float inertia, std::mt19937& generator)
 	{
 		//Calculate the direction of the droplet using the formula: 
 		//direction(new) = direction(old) * inertia + gradient * (1 - inertia)
@@ -414,12 +366,10 @@ namespace erosion {
 		//If the direction is zero which means the droplet wouldnt move, move it in a random direction
 		if (dx == 0 && dy == 0)
 		{
-			std::random_device rd;
-			std::mt19937 gen(rd());
 			std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
 
-			dx = dist(gen);
-			dy = dist(gen);
+			dx = dist(generator);
+			dy = dist(generator);
 		}
 
 		//Normalize the direction to get a unit vector
@@ -450,9 +400,7 @@ namespace erosion {
 	//take gravity into cosideration when calculating the new velocity
 	void Droplet::AdjustVelocity(float elevationDifference, float gravity) {
 		this->velocity = sqrtf((this->velocity * this->velocity) + (elevationDifference * gravity));
-		if (log) {
-			std::cout << "[LOG] Velocity: " << this->velocity << std::endl;
-		}
+		LOG_DEBUG("Velocity: " << this->velocity);
 	}
 
 	//Update the amount of water the droplet carries by evaporating a percentage of it
@@ -460,9 +408,7 @@ namespace erosion {
 	//@param evaporationRate - rate at which the droplet Evaporates
 	void Droplet::Evaporate(float evaporationRate) {
 		this->water *= (1 - evaporationRate);
-		if (log) {
-			std::cout << "[LOG] Water: " << this->water << std::endl;
-		}
+		LOG_DEBUG("Water: " << this->water);
 	}
 
 	//Droplet adjusts its capacity based on parameters: water, velocity, minSlope and elevationDifference
@@ -477,9 +423,7 @@ namespace erosion {
 	{
 		this->capacity = std::max(-elevationDifference, minSlope) * this->velocity * this->water;
 
-		if (log) {
-			std::cout << "[LOG] Capacity: " << this->capacity << std::endl;
-		}
+		LOG_DEBUG("Capacity: " << this->capacity);
 
 		if (this->sediment > this->capacity) {
 			return this->DropSurplusSediment(depositionRate);
@@ -500,10 +444,8 @@ namespace erosion {
 		//Firstly it will return maximum ammount it can collect and then function in Erosion class will check if 
 		//Gathering that ammount of sediment is possible without going below 0 on some P(x,y)
 		float SedimentToGather = std::min((this->capacity - this->sediment) * erosionRate, -elevationDifference);
-		if (log) {
-			std::cout << "[LOG] Sediment: " << this->sediment << std::endl;
-			std::cout << "[LOG] Sediment to gather: " << SedimentToGather << std::endl;
-		}
+		LOG_DEBUG("Sediment: " << this->sediment);
+		LOG_DEBUG("Sediment to gather: " << SedimentToGather);
 
 		return SedimentToGather;
 	}
@@ -525,9 +467,7 @@ namespace erosion {
 		float dropAmount = std::min(elevationDifference, this->sediment);
 		this->sediment -= dropAmount;
 
-		if (log) {
-			std::cout << "[LOG] Dropped: " << dropAmount << std::endl;
-		}
+		LOG_DEBUG("Dropped: " << dropAmount);
 
 		return dropAmount;
 	}
@@ -541,9 +481,7 @@ namespace erosion {
 		float surplusToDrop = (this->sediment - this->capacity) * depositionRate;
 		this->sediment -= surplusToDrop;
 
-		if (log) {
-			std::cout << "[LOG] Surplus to drop: " << surplusToDrop << std::endl;
-		}
+		LOG_DEBUG("Surplus to drop: " << surplusToDrop);
 
 		return surplusToDrop;
 	}
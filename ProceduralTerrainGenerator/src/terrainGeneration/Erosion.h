@@ -1,6 +1,10 @@
 #pragma once
 
 #include <optional>
+#include <random>
+
+#include "Grid.h"
+#include "ScratchArena.h"
 
 
 //Implementation of the algorith described here: http://www.firespark.de/resources/downloads/implementation%20of%20a%20methode%20for%20hydraulic%20erosion.pdf
@@ -8,9 +12,6 @@
 //The algorithm is implemented in the Erosion class using the Droplet class to simulate the droplets
 
 namespace erosion {
-	//Temporary variable for enabling or disabling logging for debugging purposes
-	static const bool log = false;
-
 	//Configuration parameters for the erosion
 	//@param erosionRate: The rate at which the droplet erodes the terrain
 	//@param depositionRate: The rate at which the droplet deposits sediment
@@ -24,6 +25,7 @@ namespace erosion {
 	//@param initialWater: The initial amount of water in the droplet
 	//@param initialVelocity: The initial velocity of the droplet
 	//@param initialCapacity: The initial capacity of the droplet
+	//@param seed: Seed of the droplet placement, 0 picks a new random seed on every erosion
 	struct ErosionConfig {
 		//Erosion parameters
 		float erosionRate = 0.6f;
@@ -42,6 +44,8 @@ namespace erosion {
 		float initialWater = 1.0f;
 		float initialVelocity = 1.0f;
 		float initialCapacity = 1.0f;
+
+		unsigned int seed = 0;
 	};
 
 	struct vec2 {
@@ -66,14 +70,14 @@ namespace erosion {
 		float GetElevationDifference(vec2 posOld, vec2 posNew);
 		float GetInterpolatedGridHeight(vec2 pos);
 		void DistributeSediment(vec2 pos, float sedimentDropped);
-		float ErodeRadius(vec2 oldPos, vec2 newPos, float ammountEroded);
+		float ErodeRadius(vec2 oldPos, vec2 newPos, float ammountEroded, utilities::ScratchArena& scratch);
 		bool IsOnMap(vec2 pos);
 		void TrackDroplets(float* vertices, vec2 pos, int step);
 
 		//Configuration functions
 		void SetConfig(ErosionConfig config);
 		void Resize(int width, int height);
-		void SetMap(float* map);
+		bool SetMap(utilities::GridView<const float> source);
 		void SetDropletCount(int dropletCount);
 
 		//Getters
@@ -81,12 +85,14 @@ namespace erosion {
 		int& GetDropletCountRef() { return dropletCount; }
 		int GetWidth() { return width; }
 		int GetHeight() { return height; }
-		float* GetMap() { return map; }
+		float* GetMap() { return map.Data(); }
+		utilities::GridView<const float> GetView() const { return map.View(); }
+		size_t GetByteSize() const { return map.GetByteSize(); }
 		void DontChangeMap() { changeMap = false; }
 		void ChangeMap() { changeMap = true; }
 
 	private:
-		float* map;
+		utilities::Grid<float> map;
 
 		int width, height;
 		int dropletCount = 20000;
@@ -100,7 +106,6 @@ namespace erosion {
 	{
 	public:
 		Droplet(vec2 position, float velocity, float water, float capacity);
-		~Droplet();
 
 		//Getters
 		vec2 GetPosition() { return position; }
@@ -113,7 +118,7 @@ namespace erosion {
 		//Setters and calculation functions
 		void SetPosition(vec2 position) { this->position = position; }
 		void SetDirection(vec2 direction) { this->direction = direction; }
-		void AdjustDirection(vec2 gradient, float inertia);
+		void AdjustDirection(vec2 gradient, float inertia, std::mt19937& generator);
 		void AdjustPosition();
 		void AdjustVelocity(float elevationDifference, float gravity);
 		void AdjustSediment(float sedimentCollected);
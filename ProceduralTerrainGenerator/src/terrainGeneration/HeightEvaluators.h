@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#include "CurveLut.h"
+
+//Height evaluation policies used by TerrainGenerator::EvaluateMap.
+//Policy is a type constructible from EvaluationContext with a method
+//	void EvaluateRow(ComponentRows& rows, float* out) const
+//which combines one row of component noises into elevation. The whole map loop is instantiated per policy,
+//so the method is chosen once per generation. New policies are added with TerrainGenerator::RegisterEvaluator.
+
+namespace evaluation {
+	//Parameters of the built-in policies editable from the UI
+	//@param ridgeStrength: Share of the mountainousness replaced by the ridged weirdness in RidgedCombine
+	//@param terraceCount: Number of terraces in TerracedCombine
+	//@param terraceSharpness: Exponent of the terrace profile, 1 gives linear ramps, higher values flatter steps
+	struct EvaluationParameters {
+		float ridgeStrength = 0.6f;
+		int terraceCount = 8;
+		float terraceSharpness = 4.0f;
+	};
+
+	//Read only state of the generator available to the policies
+	struct EvaluationContext {
+		const utilities::CurveLut& continentalnessLut;
+		const utilities::CurveLut& mountainousnessLut;
+		const utilities::CurveLut& weirdnessLut;
+		const EvaluationParameters& parameters;
+		int width, height;
+	};
+
+	//One row of component noises in range [-1, 1], policies are allowed to overwrite the values
+	struct ComponentRows {
+		float* continentalness;
+		float* mountainousness;
+		float* weirdness;
+		int count;
+	};
+
+	//Product of the components remapped to [0, 1], weirdness lowers the terrain
+	struct LinearCombine {
+		explicit LinearCombine(const EvaluationContext&) {}
+
+		void EvaluateRow(ComponentRows& rows, float* out) const
+		{
+			for (int x = 0; x < rows.count; x++) {
+				out[x] = ((rows.continentalness[x] + 1.0f) / 2.0f) * ((rows.mountainousness[x] + 1.0f) / 2.0f) * (1.0f - (rows.weirdness[x] + 1.0f) / 2.0f);
+			}
+		}
+	};
+
+	//Product of the components passed through the baked splines
+	struct SplineCombine {
+		const EvaluationContext& context;
+		explicit SplineCombine(const EvaluationContext& _context) : context(_context) {}
+
+		void EvaluateRow(ComponentRows& rows, float* out) const
+		{
+			context.continentalnessLut.EvaluateRow(rows.continentalness, rows.continentalness, rows.count);
+			context.mountainousnessLut.EvaluateRow(rows.mountainousness, rows.mountainousness, rows.count);
+			context.weirdnessLut.EvaluateRow(rows.weirdness, rows.weirdness, rows.count);
+			for (int x = 0; x < rows.count; x++) {
+				out[x] = rows.continentalness[x] * rows.mountainousness[x] * rows.weirdness[x];
+			}
+		}
+	};
+
+	//Continentalness spline multiplied by mountainousness mixed with sharp ridges folded from the weirdness noise
+	struct RidgedCombine {
+		const EvaluationContext& context;
+		explicit RidgedCombine(const EvaluationContext& _context) : context(_context) {}
+
+		void EvaluateRow(ComponentRows& rows, float* out) const
+		{
+			const float strength = context.parameters.ridgeStrength;
+			context.continentalnessLut.EvaluateRow(rows.continentalness, rows.continentalness, rows.count);
+			context.mountainousnessLut.EvaluateRow(rows.mountainousness, rows.mountainousness, rows.count);
+			for (int x = 0; x < rows.count; x++) {
+				float ridge = 1.0f - std::abs(rows.weirdness[x]);
+				ridge *= ridge;
+				float mountains = rows.mountainousness[x] * ((1.0f - strength) + strength * ridge);
+				out[x] = rows.continentalness[x] * mountains;
+			}
+		}
+	};
+
+	//Spline combined elevation quantized into terraces with smooth ramps between the steps
+	struct TerracedCombine {
+		SplineCombine spline;
+		float steps, sharpness;
+		explicit TerracedCombine(const EvaluationContext& context) : spline(context),
+			steps(static_cast<float>(std::max(1, context.parameters.terraceCount))), sharpness(std::max(1.0f, context.parameters.terraceSharpness)) {}
+
+		void EvaluateRow(ComponentRows& rows, float* out) const
+		{
+			spline.EvaluateRow(rows, out);
+			for (int x = 0; x < rows.count; x++) {
+				float t = out[x] * steps;
+				float step = std::floor(t);
+				out[x] = (step + std::pow(t - step, sharpness)) / steps;
+			}
+		}
+	};
+}
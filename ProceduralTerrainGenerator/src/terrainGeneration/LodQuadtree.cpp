@@ -0,0 +1,253 @@
+#include "LodQuadtree.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+
+#include "Parallel.h"
+#include "Log.h"
+
+namespace lod {
+	LodQuadtree::LodQuadtree() : width(0), height(0), gridResolution(32), levelCount(0), heightScale(1.0f), map(nullptr)
+	{
+	}
+
+	LodQuadtree::~LodQuadtree()
+	{
+	}
+
+	//Builds the quadtree and computes height ranges and geometric errors of all nodes
+	//@param heightMap - height map of size width * height, has to outlive the quadtree
+	//@param _width, _height - size of the height map
+	//@param _heightScale - scaling factor for generating height values
+	//@param _gridResolution - number of quads along a side of the shared grid mesh, has to be a power of two
+	bool LodQuadtree::Build(const float* heightMap, int _width, int _height, float _heightScale, int _gridResolution)
+	{
+		if (!heightMap || _width < 2 || _height < 2) {
+			LOG_ERROR("LOD quadtree couldnt be built, height map not initialized");
+			return false;
+		}
+		if (_gridResolution < 2 || (_gridResolution & (_gridResolution - 1)) != 0) {
+			LOG_ERROR("LOD grid resolution has to be a power of two");
+			return false;
+		}
+
+		map = heightMap;
+		width = _width;
+		height = _height;
+		heightScale = _heightScale;
+		gridResolution = _gridResolution;
+
+		//Root is the smallest power of two multiple of the leaf size covering all of the cells
+		int rootSize = gridResolution;
+		levelCount = 1;
+		while (rootSize < std::max(width, height) - 1) {
+			rootSize *= 2;
+			levelCount++;
+		}
+
+		nodes.clear();
+		levels.assign(levelCount, {});
+		CreateNode(0, 0, rootSize, 0);
+
+		//Bottom-up, children are always finished before their parents
+		for (int level = levelCount - 1; level >= 0; level--) {
+			const std::vector<int>& levelNodes = levels[level];
+			utilities::ParallelFor(0, static_cast<int>(levelNodes.size()), [&](int begin, int end) {
+				for (int i = begin; i < end; i++) {
+					ComputeNode(nodes[levelNodes[i]]);
+				}
+			}, 4);
+		}
+		levelErrors.assign(levelCount, 0.0f);
+		for (const LodNode& node : nodes) {
+			levelErrors[node.level] = std::max(levelErrors[node.level], node.geometricError);
+		}
+		LOG_INFO("LOD quadtree built: " << nodes.size() << " nodes, " << levelCount << " levels");
+		return true;
+	}
+
+	int LodQuadtree::CreateNode(int x, int z, int size, int level)
+	{
+		if (x >= width - 1 || z >= height - 1) {
+			return -1;
+		}
+		int index = static_cast<int>(nodes.size());
+		nodes.push_back({ x, z, size, level, 0.0f, 0.0f, 0.0f, { -1, -1, -1, -1 } });
+		levels[level].push_back(index);
+
+		if (size > gridResolution) {
+			int half = size / 2;
+			int children[4] = {
+				CreateNode(x, z, half, level + 1),
+				CreateNode(x + half, z, half, level + 1),
+				CreateNode(x, z + half, half, level + 1),
+				CreateNode(x + half, z + half, half, level + 1)
+			};
+			std::copy(children, children + 4, nodes[index].children);
+		}
+		return index;
+	}
+
+	float LodQuadtree::SampleHeight(int x, int z) const
+	{
+		x = std::clamp(x, 0, width - 1);
+		z = std::clamp(z, 0, height - 1);
+		return map[z * width + x];
+	}
+
+	//Height range of the node and the error of its grid against the heightmap, children have to be computed already
+	void LodQuadtree::ComputeNode(LodNode& node) const
+	{
+		const int x1 = std::min(node.x + node.size, width - 1);
+		const int z1 = std::min(node.z + node.size, height - 1);
+		const int step = node.size / gridResolution;
+
+		float minHeight = std::numeric_limits<float>::max();
+		float maxHeight = std::numeric_limits<float>::lowest();
+		float error = 0.0f;
+
+		for (int i = 0; i < 4; i++) {
+			if (node.children[i] >= 0) {
+				const LodNode& child = nodes[node.children[i]];
+				error = std::max(error, child.geometricError);
+			}
+		}
+
+		const float invStep = 1.0f / step;
+		for (int z = node.z; z <= z1; z++) {
+			const int gz = node.z + (z - node.z) / step * step;
+			const float fz = (z - gz) * invStep;
+			for (int x = node.x; x <= x1; x++) {
+				float h = map[z * width + x];
+				minHeight = std::min(minHeight, h);
+				maxHeight = std::max(maxHeight, h);
+				if (step == 1) {
+					continue;
+				}
+				const int gx = node.x + (x - node.x) / step * step;
+				const float fx = (x - gx) * invStep;
+				float h00 = SampleHeight(gx, gz), h10 = SampleHeight(gx + step, gz);
+				float h01 = SampleHeight(gx, gz + step), h11 = SampleHeight(gx + step, gz + step);
+				float coarse = (h00 * (1.0f - fx) + h10 * fx) * (1.0f - fz) + (h01 * (1.0f - fx) + h11 * fx) * fz;
+				error = std::max(error, std::abs(h - coarse) * heightScale);
+			}
+		}
+
+		node.minHeight = minHeight * heightScale;
+		node.maxHeight = maxHeight * heightScale;
+		node.geometricError = error;
+	}
+
+	//Distance from the camera to the closest point of the node's bounding box in world units
+	float LodQuadtree::NodeDistance(const LodNode& node, const LodSelectionSettings& settings) const
+	{
+		glm::vec3 bmin(node.x, node.minHeight, node.z);
+		glm::vec3 bmax(node.x + node.size, node.maxHeight, node.z + node.size);
+		glm::vec3 delta = glm::max(glm::max(bmin - settings.cameraPosition, settings.cameraPosition - bmax), glm::vec3(0.0f));
+		return glm::length(delta * settings.worldScale);
+	}
+
+	//Ranges of the levels for the camera. Level l is drawn up to ranges[l], where the error of level l - 1 projects to the
+	//allowed pixel error. A node of level l + 1 lies within ranges[l + 1] + diagonal(l) of the camera, so its coarser
+	//neighbours have to start morphing only behind that distance and have to be within ranges[l] to be refined.
+	//Ranges are spread by two diagonals to satisfy both, then no level borders a level coarser than its parent.
+	void LodQuadtree::ComputeRanges(const LodSelectionSettings& settings)
+	{
+		const float heightSpan = (nodes[0].maxHeight - nodes[0].minHeight) * settings.worldScale.y;
+		const float errorToDistance = settings.worldScale.y * settings.projectionScale / std::max(settings.maxPixelError, 1e-3f);
+		ranges.assign(levelCount + 1, 0.0f);
+		morphStarts.assign(levelCount, 0.0f);
+		for (int level = levelCount - 1; level >= 1; level--) {
+			const float size = static_cast<float>(gridResolution << (levelCount - 1 - level));
+			const float diagonal = glm::length(glm::vec3(size * settings.worldScale.x, heightSpan, size * settings.worldScale.z));
+			ranges[level] = std::max(levelErrors[level - 1] * errorToDistance, ranges[level + 1] + 2.0f * diagonal);
+			morphStarts[level] = std::max(ranges[level + 1] + diagonal, ranges[level] - (ranges[level] - ranges[level + 1]) * 0.3f);
+		}
+		ranges[0] = morphStarts[0] = std::numeric_limits<float>::max();
+	}
+
+	//Selects the nodes to draw for the camera
+	//@return - draw list, valid until the next call
+	const std::vector<LodDrawItem>& LodQuadtree::Select(const LodSelectionSettings& settings)
+	{
+		drawList.clear();
+		stats = LodSelectionStats();
+		stats.nodesPerLevel.assign(levelCount, 0);
+		selection = settings;
+		if (!nodes.empty()) {
+			ComputeRanges(settings);
+			SelectNode(0, settings);
+		}
+		stats.triangles = stats.nodesSelected * GetTrianglesPerNode();
+		return drawList;
+	}
+
+	//Nodes reaching into the range of the next level are refined, children outside of it are drawn fully morphed
+	void LodQuadtree::SelectNode(int index, const LodSelectionSettings& settings)
+	{
+		const LodNode& node = nodes[index];
+		stats.nodesVisited++;
+
+		if (settings.frustumCulling) {
+			glm::vec3 bmin(node.x, node.minHeight, node.z);
+			glm::vec3 bmax(node.x + node.size, node.maxHeight, node.z + node.size);
+			if (settings.frustum.TestBox(bmin, bmax) == 0) {
+				stats.nodesCulled++;
+				return;
+			}
+		}
+
+		if (!IsLeaf(node) && NodeDistance(node, settings) < ranges[node.level + 1]) {
+			for (int i = 0; i < 4; i++) {
+				if (node.children[i] >= 0) {
+					SelectNode(node.children[i], settings);
+				}
+			}
+			return;
+		}
+
+		//The morph ends slightly before the range so that height quantization of the texture cant leave a vertex unsnapped
+		const float morphEnd = node.level == 0 ? ranges[0] : ranges[node.level] - (ranges[node.level] - morphStarts[node.level]) * 0.01f;
+		drawList.push_back({ index, static_cast<float>(node.x), static_cast<float>(node.z), static_cast<float>(node.size), morphStarts[node.level], morphEnd, node.level });
+		stats.nodesSelected++;
+		stats.nodesPerLevel[node.level]++;
+	}
+
+	//Logs the result of the last selection, usable without any rendering
+	void LodQuadtree::LogSelection() const
+	{
+		std::ostringstream out;
+		out << "LOD selection: visited " << stats.nodesVisited << ", culled " << stats.nodesCulled
+			<< ", selected " << stats.nodesSelected << ", triangles " << stats.triangles << "\n";
+		for (int level = 0; level < static_cast<int>(stats.nodesPerLevel.size()); level++) {
+			out << "  level " << level << " (node size " << (gridResolution << (levelCount - 1 - level)) << "): " << stats.nodesPerLevel[level] << " nodes";
+			if (level > 0 && level < static_cast<int>(ranges.size())) {
+				out << ", range " << ranges[level] << ", morph from " << morphStarts[level];
+			}
+			out << "\n";
+		}
+		for (const auto& item : drawList) {
+			const LodNode& node = nodes[item.node];
+			out << "  node " << item.node << " level " << item.level << " origin (" << node.x << ", " << node.z << ") size " << node.size
+				<< " height [" << node.minHeight << ", " << node.maxHeight << "] error " << node.geometricError << "\n";
+		}
+		utilities::LogBlock(utilities::LogLevel::INFO, out.str());
+	}
+
+	//Grid mesh shared by all of the nodes, vertices are (x, z) in [0, 1] laid out row by row,
+	//indexed as restart separated strips by IndexBuffer::GetStripGrid(resolution + 1, resolution + 1)
+	//@param resolution - number of quads along a side
+	void LodQuadtree::BuildGridMesh(int resolution, std::vector<float>& vertices)
+	{
+		vertices.clear();
+		vertices.reserve(static_cast<size_t>(resolution + 1) * (resolution + 1) * 2);
+		for (int z = 0; z <= resolution; z++) {
+			for (int x = 0; x <= resolution; x++) {
+				vertices.push_back(static_cast<float>(x) / resolution);
+				vertices.push_back(static_cast<float>(z) / resolution);
+			}
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <iostream>
+
+#include "glm/glm.hpp"
+#include "SpatialIndex.h"
+
+//CPU quadtree level of detail over the heightmap in the spirit of CDLOD.
+//Every node covers a square of the map and is drawn with the same grid mesh of gridResolution x gridResolution quads,
+//so a node of size S samples the heightmap every S / gridResolution cells. Nodes store their height range and
+//geometric error: the maximal vertical distance between the heightmap and the node's coarse grid (including children).
+//Every level is drawn up to a range around the camera, the distance at which the largest error of its parent level
+//projects to the allowed pixel error. Ranges are widened so that two levels next to each other always differ by one at
+//most and the vertices of a node morph to the parent grid (per vertex, by their distance) before its range ends,
+//which keeps the borders between levels free of cracks. Selection outputs a draw list of nodes with their morph ranges.
+//Nothing here touches OpenGL, selection can be run and inspected headless.
+
+namespace lod {
+	struct LodNode {
+		int x, z, size;
+		int level;
+		float minHeight, maxHeight;
+		float geometricError;
+		int children[4];
+	};
+
+	//Camera description in map space used by the selection
+	//@param cameraPosition: Camera position in map space (heights scaled by heightScale)
+	//@param frustum: Frustum planes in map space, see spatial::Frustum::FromMatrix
+	//@param worldScale: Scale of the map -> world transform, distances are measured in world units
+	//@param projectionScale: viewportHeight / (2 * tan(fovY / 2)), converts world size at distance 1 to pixels
+	//@param maxPixelError: Allowed screen-space error in pixels
+	//@param frustumCulling: Nodes outside of the frustum are skipped when enabled
+	struct LodSelectionSettings {
+		glm::vec3 cameraPosition = glm::vec3(0.0f);
+		spatial::Frustum frustum;
+		glm::vec3 worldScale = glm::vec3(1.0f);
+		float projectionScale = 1000.0f;
+		float maxPixelError = 2.0f;
+		bool frustumCulling = true;
+	};
+
+	//Selected node drawn with the shared grid mesh
+	//@param morphStart, morphEnd: Distances from the camera between which the vertices morph to the parent grid
+	struct LodDrawItem {
+		int node;
+		float originX, originZ, size;
+		float morphStart, morphEnd;
+		int level;
+	};
+
+	struct LodSelectionStats {
+		int nodesVisited = 0;
+		int nodesCulled = 0;
+		int nodesSelected = 0;
+		size_t triangles = 0;
+		std::vector<int> nodesPerLevel;
+	};
+
+	class LodQuadtree
+	{
+	public:
+		LodQuadtree();
+		~LodQuadtree();
+
+		bool Build(const float* heightMap, int _width, int _height, float _heightScale, int _gridResolution);
+		const std::vector<LodDrawItem>& Select(const LodSelectionSettings& settings);
+		void LogSelection() const;
+
+		static void BuildGridMesh(int resolution, std::vector<float>& vertices);
+
+		bool IsBuilt() const { return !nodes.empty(); }
+		int GetGridResolution() const { return gridResolution; }
+		int GetLevelCount() const { return levelCount; }
+		const std::vector<LodNode>& GetNodes() const { return nodes; }
+		const std::vector<LodDrawItem>& GetDrawList() const { return drawList; }
+		//Settings of the last selection, the morph has to be computed from the same camera position
+		const LodSelectionSettings& GetSelectionSettings() const { return selection; }
+		const LodSelectionStats& GetStats() const { return stats; }
+		size_t GetTrianglesPerNode() const { return static_cast<size_t>(gridResolution) * gridResolution * 2; }
+
+	private:
+		int width, height, gridResolution, levelCount;
+		float heightScale;
+		const float* map;
+		std::vector<LodNode> nodes;
+		std::vector<std::vector<int>> levels;
+		std::vector<float> levelErrors;
+		//Distance up to which a level is drawn and where its vertices start to morph, the root level is never morphed
+		std::vector<float> ranges, morphStarts;
+		LodSelectionSettings selection;
+		std::vector<LodDrawItem> drawList;
+		LodSelectionStats stats;
+
+		int CreateNode(int x, int z, int size, int level);
+		void ComputeNode(LodNode& node) const;
+		bool IsLeaf(const LodNode& node) const { return node.children[0] < 0 && node.children[1] < 0 && node.children[2] < 0 && node.children[3] < 0; }
+		float SampleHeight(int x, int z) const;
+		float NodeDistance(const LodNode& node, const LodSelectionSettings& settings) const;
+		void ComputeRanges(const LodSelectionSettings& settings);
+		void SelectNode(int index, const LodSelectionSettings& settings);
+	};
+}
@@ -7,27 +7,28 @@
 #include <random>
 
 #include "Simplex/SimplexNoise.h"
+#include "Parallel.h"
+#include "Trace.h"
+#include "Log.h"
 
 #define PI 3.14159265
 
 namespace noise
 {
 	SimplexNoiseClass::SimplexNoiseClass()
-		: config(NoiseConfigParameters()), width(0), height(0),
-		heightMap(nullptr)
+		: config(NoiseConfigParameters()), width(0), height(0)
 	{
 	}
 	SimplexNoiseClass::~SimplexNoiseClass()
 	{
-		delete[] heightMap;
 	}
 
 	//Initialize the size of the map that the noise will be generated into
 	//@param _width - width of the map
 	//@param _height - height of the
 	bool SimplexNoiseClass::Initialize(int _height, int _width) {
-		if (heightMap) {
-			std::cout << "[ERROR] Noise map already initialized\n";
+		if (!heightMap.IsEmpty()) {
+			LOG_ERROR("Noise map already initialized");
 			return false;
 		}
 		return Resize(_height, _width);
@@ -39,21 +40,18 @@ namespace noise
 	bool SimplexNoiseClass::Resize(int _height, int _width)
 	{
 		if (_height <= 0 || _width <= 0) {
-			std::cout << "[ERROR] Noise map couldnt be resized, width and height must be greater than 0\n";
+			LOG_ERROR("Noise map couldnt be resized, width and height must be greater than 0");
 			return false;
 		}
 		if (_width == this->width && _height == this->height) {
-			std::cout << "[LOG] Noise map is already initialized with the same size\n";
+			LOG_INFO("Noise map is already initialized with the same size");
 			return false;
 		}
 
 		width = _width;
 		height = _height;
-		if (heightMap) {
-			delete[] heightMap;
-		}
-		heightMap = new float[width * height];
-		std::cout << "[LOG] Noise object has been succesfully initialized with size: " << height << "x" << width << "\n";
+		heightMap.Resize(width, height);
+		LOG_INFO("Noise object has been succesfully initialized with size: " << height << "x" << width);
 		return true;
 	}
 
@@ -61,19 +59,23 @@ namespace noise
 	//Return a 2D height map of the noise in range for one configuration
 	bool SimplexNoiseClass::GenerateFractalNoise(float originx, float originy)
 	{
-		if (!heightMap) {
-			std::cout << "[ERROR] Noise object not initialized!" << std::endl;
+		TRACE_ZONE("GenerateFractalNoise");
+		if (heightMap.IsEmpty()) {
+			LOG_ERROR("Noise object not initialized!");
 			return false;
 		}
 
-		for (int y = 0; y < height; y++)
-		{
-			for (int x = 0; x < width; x++)
+		utilities::ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+			for (int y = bandBegin; y < bandEnd; y++)
 			{
-				heightMap[y * width + x] = PointNoise(x + originx,y + originy);
+				float* row = heightMap.Row(y);
+				for (int x = 0; x < width; x++)
+				{
+					row[x] = PointNoise(x + originx,y + originy);
+				}
 			}
-		}
-		std::cout << "[LOG] Noise successfully generated" << std::endl;
+		}, 4);
+		LOG_INFO("Noise successfully generated");
 		return true;
 	}
 
@@ -165,16 +167,19 @@ namespace noise
 	//
 	bool SimplexNoiseClass::MakeMapRidged()
 	{
-		if (!this->heightMap)
+		if (heightMap.IsEmpty())
 			return false;
 
 		for (int y = 0; y < height; y++)
 		{
+			float* row = heightMap.Row(y);
 			for (int x = 0; x < width; x++)
 			{
-				heightMap[y * width + x] = Ridge(heightMap[y * width + x], config.RidgeOffset, config.RidgeGain);
+				row[x] = Ridge(row[x], config.RidgeOffset, config.RidgeGain);
 			}
 		}
+
+		return true;
 	}
 
 	//Function generating island noise based on the configuration parameters
@@ -209,14 +214,14 @@ namespace noise
 	}
 	float SimplexNoiseClass::GetVal(int x, int y)
 	{
-		if(!heightMap || height <= 0 || width <= 0) {
-			std::cout << "[ERROR] Noise object not initialized!" << std::endl;
+		if(heightMap.IsEmpty() || height <= 0 || width <= 0) {
+			LOG_ERROR("Noise object not initialized!");
 			return -2.0f;
 		}
 		if(x < 0 || x >= width || y < 0 || y >= height) {
-			std::cout << "[ERROR] Coordinates out of bounds!" << std::endl;
+			LOG_ERROR("Coordinates out of bounds!");
 			return -2.0f;
 		}
-		return heightMap[y * width + x];
+		return heightMap(x, y);
 	}
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "Grid.h"
+
 namespace noise
 {
 	enum class Options {
@@ -74,15 +76,18 @@ namespace noise
 
 		void SetConfig(NoiseConfigParameters config) { this->config = config; }
 
-		float* GetMap() const { return heightMap; }
+		float* GetMap() { return heightMap.Data(); }
+		const float* GetMap() const { return heightMap.Data(); }
+		utilities::GridView<const float> GetView() const { return heightMap.View(); }
 		float GetVal(int x, int y);
 		unsigned int GetWidth()  const { return width; }
 		unsigned int GetHeight() const { return height; }
 		NoiseConfigParameters& GetConfigRef() { return config; }
+		size_t GetByteSize() const { return heightMap.GetByteSize(); }
 
 	private:
 		NoiseConfigParameters config;
-		float* heightMap;
+		utilities::Grid<float> heightMap;
 		unsigned int width, height;
 
 		float Ridge(float h, float offset, float gain);
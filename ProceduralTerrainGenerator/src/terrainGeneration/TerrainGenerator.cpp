@@ -1,15 +1,18 @@
 #include "TerrainGenerator.h"
 
 
-TerrainGenerator::TerrainGenerator() : width(0), height(0), seed(0), resolution(500.0f), heightMap(nullptr),
+TerrainGenerator::TerrainGenerator() : width(0), height(0), seed(0), resolution(500.0f),
 continentalnessNoise(), mountainousnessNoise(), weirdnessNoise(), continentalnessSpline(), mountainousnessSpline(), weirdnessSpline()
 {
+	//Order has to match EvaluationMethod
+	RegisterEvaluator<evaluation::LinearCombine>("Linear");
+	RegisterEvaluator<evaluation::SplineCombine>("Spline");
+	RegisterEvaluator<evaluation::RidgedCombine>("Ridged");
+	RegisterEvaluator<evaluation::TerracedCombine>("Terraced");
 }
 
 TerrainGenerator::~TerrainGenerator()
 {
-	if(heightMap)
-		delete[] heightMap;
 }
 
 bool TerrainGenerator::Initialize(int _width, int _height)
@@ -41,6 +44,8 @@ bool TerrainGenerator::Initialize(int _width, int _height)
 		return false;
 
 	SetSplines(s);
+	//Component maps with the default configuration, after Resize or SetResolution they are regenerated by GenerateNoises
+	GenerateNoises();
 
 	return true;
 }
@@ -48,7 +53,7 @@ bool TerrainGenerator::Initialize(int _width, int _height)
 bool TerrainGenerator::Resize(int _width, int _height)
 {
 	if (_width <= 0 || _height <= 0) {
-		std::cout << "[ERROR] Width and height must be greater than 0\n";
+		LOG_ERROR("Width and height must be greater than 0");
 		return false;
 	}
 	if(width == _width && height == _height)
@@ -57,106 +62,93 @@ bool TerrainGenerator::Resize(int _width, int _height)
 	this->width = _width;
 	this->height = _height;
 
-	if (heightMap) {
-		delete[] heightMap;
-	}
-
-	heightMap = new float[width * height];
+	heightMap.Resize(width, height);
 
 	if(!this->mountainousnessNoise.Resize(width, height) || !this->continentalnessNoise.Resize(width, height) || !this->weirdnessNoise.Resize(width, height)) {
-		std::cout << "[ERROR] Could not resize noises\n";
+		LOG_ERROR("Could not resize noises");
 		return false;
 	}
 
-	GenerateNoises();
-
 	return true;
 }
 
 //Scales the resolution of terrain generation by 
+//Only the configurations change, the component maps are regenerated by the next GenerateNoises
 void TerrainGenerator::SetResolution()
 {
 	continentalnessNoise.GetConfigRef().resolution = resolution;
 	mountainousnessNoise.GetConfigRef().resolution = resolution;
 	weirdnessNoise.GetConfigRef().resolution = resolution;
-
-	GenerateNoises();
 }
 
 bool TerrainGenerator::GenerateTerrain(float originx, float originy)
 {
-	if (!heightMap) {
-		std::cout << "[ERROR] HeightMap not initialized, please set a size of the map!\n";
+	if (heightMap.IsEmpty()) {
+		LOG_ERROR("HeightMap not initialized, please set a size of the map!");
+		return false;
+	}
+
+	if (evaluatorId < 0 || evaluatorId >= static_cast<int>(evaluators.size())) {
+		LOG_ERROR("Evaluation method: " << evaluatorId << " is not registered");
+		return false;
+	}
+	if (!evaluators[evaluatorId].evaluate(*this, originx, originy, false)) {
 		return false;
 	}
+	LOG_INFO("HeightMap of size: " << height << "x" << width << " succesfully evaluated");
+	return true;
+}
 
-	float continentalness = 0.0f;
-	float mountainousness = 0.0f;
-	float weirdness = 0.0f;
-	float elevation = 0.0f;
-
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			continentalness = continentalnessNoise.PointNoise(x + originx, y + originy);
-			mountainousness = mountainousnessNoise.PointNoise(x + originx, y + originy);
-			weirdness = weirdnessNoise.PointNoise(x + originx, y + originy);
-			if (continentalness < -1.0f || mountainousness < -1.0f || weirdness < -1.0f) {
-				std::cout << "[ERROR] Couldnt get value for component noise!\n";
-				return false;
-			}
-
-			switch (evalMethod)
-			{
-			case TerrainGenerator::EvaluationMethod::LINEAR_COMBINE: 
-			{
-				mountainousness = (mountainousness + 1.0f) / 2.0f;
-				continentalness = (continentalness + 1.0f) / 2.0f;
-				weirdness = (weirdness + 1.0f) / 2.0f;
-				elevation = continentalness * mountainousness * (1.0f - weirdness);
-				break;
-			}
-			//TODO: Different algorithms for height evaluation
-			case TerrainGenerator::EvaluationMethod::SPLINE_COMBINE:
-			{
-				continentalness = continentalnessSpline(continentalness);
-				mountainousness = mountainousnessSpline(mountainousness);
-				weirdness = weirdnessSpline(weirdness);
-				elevation = continentalness * mountainousness * weirdness;
-				break;
-			}
-			case TerrainGenerator::EvaluationMethod::C:
-				break;
-			default:
-				break;
-			}
-			heightMap[y * width + x] = elevation;
+//Evaluates the heightmap at the origin from the component noise maps, which GenerateNoises or the stages of the
+//application generated beforehand, instead of sampling the noises a second time
+//Maps whose layout differs from the heightmap (the noises are sized height x width) are sampled as in GenerateTerrain
+bool TerrainGenerator::GenerateTerrainFromNoiseMaps()
+{
+	if (heightMap.IsEmpty()) {
+		LOG_ERROR("HeightMap not initialized, please set a size of the map!");
+		return false;
+	}
+	for (const noise::SimplexNoiseClass* noise : { &continentalnessNoise, &mountainousnessNoise, &weirdnessNoise }) {
+		if (!noise->GetMap() || static_cast<int>(noise->GetWidth()) != width || static_cast<int>(noise->GetHeight()) != height) {
+			return GenerateTerrain(0.0f, 0.0f);
 		}
 	}
-	std::cout << "[LOG] HeightMap of size: " << height << "x" << width << " succesfully evaluated\n";
+	if (evaluatorId < 0 || evaluatorId >= static_cast<int>(evaluators.size())) {
+		LOG_ERROR("Evaluation method: " << evaluatorId << " is not registered");
+		return false;
+	}
+	if (!evaluators[evaluatorId].evaluate(*this, 0.0f, 0.0f, true)) {
+		return false;
+	}
+	LOG_INFO("HeightMap of size: " << height << "x" << width << " succesfully evaluated");
 	return true;
 }
 
-bool TerrainGenerator::GenerateNoises()
+//Generates the component noise maps used by the biome assignment
+//@param originx, originy - map origin, the same as passed to GenerateTerrain so biomes line up with the terrain
+bool TerrainGenerator::GenerateNoises(float originx, float originy)
 {
-	if (!continentalnessNoise.GenerateFractalNoise(0.0f,0.0f) || !mountainousnessNoise.GenerateFractalNoise(0.0f, 0.0f) || !weirdnessNoise.GenerateFractalNoise(0.0f, 0.0f)) {
-		std::cout << "[ERROR] Could not generate noises\n";
+	TRACE_ZONE("GenerateNoises");
+	if (!continentalnessNoise.GenerateFractalNoise(originx, originy) || !mountainousnessNoise.GenerateFractalNoise(originx, originy) || !weirdnessNoise.GenerateFractalNoise(originx, originy)) {
+		LOG_ERROR("Could not generate noises");
 		return false;
 	}
 	return true;
 }
 
-bool TerrainGenerator::SetSplines(std::vector<std::vector<double>> splines)
+bool TerrainGenerator::SetSplines(const std::vector<std::vector<double>>& splines)
 {
 	if (splines.size() <= 5)
 		return false;
 	continentalnessSpline.set_points(splines[0], splines[1], tk::spline::linear);
 	mountainousnessSpline.set_points(splines[2], splines[3], tk::spline::linear);
 	weirdnessSpline.set_points(splines[4], splines[5], tk::spline::linear);
+	BakeSplines();
 
 	return true;
 }
 
-bool TerrainGenerator::SetSpline(WorldGenParameter p, std::vector<std::vector<double>> spline)
+bool TerrainGenerator::SetSpline(WorldGenParameter p, const std::vector<std::vector<double>>& spline)
 {
 	switch (p)
 	{
@@ -173,14 +165,103 @@ bool TerrainGenerator::SetSpline(WorldGenParameter p, std::vector<std::vector<do
 		return false;
 		break;
 	}
+	BakeSpline(p);
+	return true;
+}
+
+//Bakes all of the splines into lookup tables with the current resolution and error bound
+void TerrainGenerator::BakeSplines()
+{
+	BakeSpline(WorldGenParameter::CONTINENTALNESS);
+	BakeSpline(WorldGenParameter::MOUNTAINOUSNESS);
+	BakeSpline(WorldGenParameter::WEIRDNESS);
+}
+
+//Bakes single spline into a lookup table over [-1, 1], resolution is doubled until the error bound is met
+void TerrainGenerator::BakeSpline(WorldGenParameter p)
+{
+	switch (p)
+	{
+	case WorldGenParameter::CONTINENTALNESS:
+		continentalnessLut.BakeWithErrorBound(continentalnessSpline, -1.0f, 1.0f, splineLutResolution, splineLutMaxResolution, splineLutMaxError);
+		break;
+	case WorldGenParameter::MOUNTAINOUSNESS:
+		mountainousnessLut.BakeWithErrorBound(mountainousnessSpline, -1.0f, 1.0f, splineLutResolution, splineLutMaxResolution, splineLutMaxError);
+		break;
+	case WorldGenParameter::WEIRDNESS:
+		weirdnessLut.BakeWithErrorBound(weirdnessSpline, -1.0f, 1.0f, splineLutResolution, splineLutMaxResolution, splineLutMaxError);
+		break;
+	default:
+		break;
+	}
+}
+
+const utilities::CurveLut& TerrainGenerator::GetSplineLut(WorldGenParameter p) const
+{
+	switch (p)
+	{
+	case WorldGenParameter::MOUNTAINOUSNESS:
+		return mountainousnessLut;
+	case WorldGenParameter::WEIRDNESS:
+		return weirdnessLut;
+	default:
+		return continentalnessLut;
+	}
+}
+
+//Bakes the height curve of a biome into a lookup table over the normalized elevation [0, 1]
+//@param biomeId - id of the biome, has to be in range [0, MAX_BIOME_ID]
+//@param curve - control points {X, Y} of the curve
+bool TerrainGenerator::SetBiomeHeightCurve(int biomeId, const std::vector<std::vector<double>>& curve)
+{
+	if (biomeId < 0 || biomeId > MAX_BIOME_ID) {
+		LOG_ERROR("Biome id: " << biomeId << " out of range for height curves");
+		return false;
+	}
+	if (curve.size() != 2 || curve[0].size() != curve[1].size() || curve[0].size() < 2) {
+		LOG_ERROR("Height curve of biome: " << biomeId << " not set correctly");
+		return false;
+	}
+	if (biomeHeightCurves.size() <= static_cast<size_t>(biomeId)) {
+		biomeHeightCurves.resize(biomeId + 1);
+	}
+
+	//tk::spline needs at least 3 points, two points define a straight line
+	if (curve[0].size() == 2) {
+		const double x0 = curve[0][0], y0 = curve[1][0], x1 = curve[0][1], y1 = curve[1][1];
+		biomeHeightCurves[biomeId].Bake([=](double x) { return y0 + (y1 - y0) * (x - x0) / (x1 - x0); }, 0.0f, 1.0f, BIOME_CURVE_RESOLUTION);
+		return true;
+	}
+	tk::spline s;
+	s.set_points(curve[0], curve[1], tk::spline::cspline);
+	biomeHeightCurves[biomeId].Bake(s, 0.0f, 1.0f, BIOME_CURVE_RESOLUTION);
 	return true;
 }
 
+//Applies the height curve of the biome at the given pixel, with blended biomes curves are cross-faded by the blend weights
+//@param elevation - combined elevation of the pixel
+//@param index - index of the pixel in the maps
+float TerrainGenerator::ShapeElevation(float elevation, int index) const
+{
+	const int curveCount = static_cast<int>(biomeHeightCurves.size());
+	if (biomeWeights) {
+		const biome::BiomeWeights& w = biomeWeights[index];
+		float shaped = 0.0f;
+		for (int k = 0; k < biome::MAX_BLENDED_BIOMES && w.weights[k] > 0; k++) {
+			float value = w.ids[k] < curveCount ? biomeHeightCurves[w.ids[k]].Evaluate(elevation) : elevation;
+			shaped += value * w.weights[k];
+		}
+		return shaped * (1.0f / 255.0f);
+	}
+	const int id = biomeMap[index];
+	return id >= 0 && id < curveCount ? biomeHeightCurves[id].Evaluate(elevation) : elevation;
+}
+
 float TerrainGenerator::GetHeightAt(int x, int y)
 {
-	if (!heightMap)
+	if (heightMap.IsEmpty())
 		return -1.0f;
-	return heightMap[y * width + x];
+	return heightMap(x, y);
 }
 
 noise::NoiseConfigParameters& TerrainGenerator::GetSelectedNoiseConfig(WorldGenParameter p){
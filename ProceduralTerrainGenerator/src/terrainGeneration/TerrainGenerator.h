@@ -1,10 +1,20 @@
 #pragma once
 
 #include <vector>
+#include <string>
 #include <utility>
 #include <iostream>
+#include <functional>
 
 #include "Noise.h"
+#include "Biome.h"
+#include "CurveLut.h"
+#include "HeightEvaluators.h"
+#include "Parallel.h"
+#include "Grid.h"
+#include "ScratchArena.h"
+#include "Trace.h"
+#include "Log.h"
 #include "Splines/spline.h"
 
 class TerrainGenerator
@@ -15,14 +25,21 @@ public:
 		MOUNTAINOUSNESS,
 		WEIRDNESS
 	};
-	//TODO: Different mothodes for valvulating height
+	//Ids of the built-in evaluators, registered in this order by the constructor
 	enum class EvaluationMethod {
 		LINEAR_COMBINE,
 		SPLINE_COMBINE,
-		C
+		RIDGED_COMBINE,
+		TERRACED_COMBINE
+	};
+	//Registered evaluation method, evaluate runs the whole map loop instantiated for one policy
+	//Arguments are the origin and whether the components are read from the generated noise maps
+	struct Evaluator {
+		std::string name;
+		std::function<bool(TerrainGenerator&, float, float, bool)> evaluate;
 	};
 private:
-	float* heightMap;
+	utilities::Grid<float> heightMap;
 	int resolution;
 	int seed, width, height;
 
@@ -34,30 +51,147 @@ private:
 	tk::spline mountainousnessSpline;
 	tk::spline weirdnessSpline;
 
-	EvaluationMethod evalMethod = EvaluationMethod::LINEAR_COMBINE;
+	//Splines baked into lookup tables over [-1, 1] used by SPLINE_COMBINE
+	utilities::CurveLut continentalnessLut;
+	utilities::CurveLut mountainousnessLut;
+	utilities::CurveLut weirdnessLut;
+	int splineLutResolution = 64;
+	int splineLutMaxResolution = 4096;
+	float splineLutMaxError = 1e-3f;
+
+	std::vector<Evaluator> evaluators;
+	int evaluatorId = static_cast<int>(EvaluationMethod::LINEAR_COMBINE);
+	evaluation::EvaluationParameters evaluationParameters;
+
+	//Per biome height curves indexed by biome id, applied to the elevation in the combine pass
+	std::vector<utilities::CurveLut> biomeHeightCurves;
+	const int* biomeMap = nullptr;
+	const biome::BiomeWeights* biomeWeights = nullptr;
+
+	float ShapeElevation(float elevation, int index) const;
+	void BakeSpline(WorldGenParameter p);
 public:
+	static constexpr int MAX_BIOME_ID = 255;
+	static constexpr int BIOME_CURVE_RESOLUTION = 64;
+
 	TerrainGenerator();
 	~TerrainGenerator();
 
 	bool Initialize(int _width, int _height);
 	bool Resize(int _width, int _height);
 	bool GenerateTerrain(float originx, float originy);
-	bool GenerateNoises();
+	bool GenerateTerrainFromNoiseMaps();
+	bool GenerateNoises(float originx = 0.0f, float originy = 0.0f);
+
+	template <typename Policy>
+	int RegisterEvaluator(const std::string& name);
+	template <typename Policy>
+	bool EvaluateMap(float originx, float originy, bool fromNoiseMaps = false);
 
 	void SetResolution();
 	void SetContinentalnessNoiseConfig(noise::NoiseConfigParameters config) { continentalnessNoise.SetConfig(config); };
 	void SetMountainousnessNoiseConfig(noise::NoiseConfigParameters config) { mountainousnessNoise.SetConfig(config); };
 	void SetPVNoiseConfig(noise::NoiseConfigParameters config) { weirdnessNoise.SetConfig(config); };
-	bool SetSplines(std::vector<std::vector<double>> splines);
-	bool SetSpline(WorldGenParameter p, std::vector<std::vector<double>>  spline);
+	bool SetSplines(const std::vector<std::vector<double>>& splines);
+	bool SetSpline(WorldGenParameter p, const std::vector<std::vector<double>>& spline);
+	void BakeSplines();
+	bool SetBiomeHeightCurve(int biomeId, const std::vector<std::vector<double>>& curve);
+	void ClearBiomeHeightCurves() { biomeHeightCurves.clear(); };
+	void SetBiomeMap(const int* _biomeMap, const biome::BiomeWeights* _biomeWeights) { biomeMap = _biomeMap; biomeWeights = _biomeWeights; };
 
 	int GetWidth(){ return width; };
 	int GetHeight(){ return height; };
-	float* GetHeightMap() const { return heightMap; }
+	float* GetHeightMap() { return heightMap.Data(); }
+	const float* GetHeightMap() const { return heightMap.Data(); }
+	utilities::GridView<const float> GetHeightView() const { return heightMap.View(); }
+	size_t GetByteSize() const { return heightMap.GetByteSize() + continentalnessNoise.GetByteSize() + mountainousnessNoise.GetByteSize() + weirdnessNoise.GetByteSize(); }
 	float GetHeightAt(int x, int y);
 	int& GetResolitionRef() { return resolution; };
 	noise::NoiseConfigParameters& GetSelectedNoiseConfig(WorldGenParameter p);
 	noise::SimplexNoiseClass& GetSelectedNoise(WorldGenParameter p);
-	EvaluationMethod& GetEvaluationMethod() { return evalMethod; };
+	void SetEvaluationMethod(EvaluationMethod method) { evaluatorId = static_cast<int>(method); };
+	int& GetEvaluatorRef() { return evaluatorId; };
+	const std::vector<Evaluator>& GetEvaluators() const { return evaluators; };
+	evaluation::EvaluationParameters& GetEvaluationParametersRef() { return evaluationParameters; };
 	std::vector<std::vector<double>> GetSplinePoints(WorldGenParameter p);
-};
\ No newline at end of file
+	const utilities::CurveLut& GetSplineLut(WorldGenParameter p) const;
+	int& GetSplineLutResolutionRef() { return splineLutResolution; };
+	float& GetSplineLutMaxErrorRef() { return splineLutMaxError; };
+};
+
+//Adds an evaluation method, the map loop is instantiated for the policy here so no other code has to change
+//@param name - name shown in the UI
+//@return - id of the evaluator
+template <typename Policy>
+int TerrainGenerator::RegisterEvaluator(const std::string& name)
+{
+	evaluators.push_back({ name, [](TerrainGenerator& generator, float originx, float originy, bool fromNoiseMaps) {
+		return generator.EvaluateMap<Policy>(originx, originy, fromNoiseMaps);
+	} });
+	return static_cast<int>(evaluators.size()) - 1;
+}
+
+//Evaluates the whole heightmap row by row with a single policy
+//Component noises are sampled into row buffers, combined by the policy and shaped by the biome curves
+//Bands of rows are evaluated in parallel on the job system, every band carves its row buffers from the scratch arena of its thread
+//@param fromNoiseMaps - rows are copied from the generated component noise maps instead of sampled, the maps have to be
+//generated at the same origin (policies transform the rows in place, so the maps are never handed out directly)
+template <typename Policy>
+bool TerrainGenerator::EvaluateMap(float originx, float originy, bool fromNoiseMaps)
+{
+	TRACE_ZONE("EvaluateMap");
+	const evaluation::EvaluationContext context{ continentalnessLut, mountainousnessLut, weirdnessLut, evaluationParameters, width, height };
+	const Policy policy(context);
+	std::atomic<bool> failed{ false };
+
+	utilities::ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+		utilities::ScratchArena& scratch = utilities::GetThreadScratch();
+		utilities::ScratchScope scope(scratch);
+		float* continentalness = scratch.Allocate<float>(width);
+		float* mountainousness = scratch.Allocate<float>(width);
+		float* weirdness = scratch.Allocate<float>(width);
+
+		for (int y = bandBegin; y < bandEnd && !failed.load(std::memory_order_relaxed); y++) {
+			if (fromNoiseMaps) {
+				std::copy_n(continentalnessNoise.GetView().Row(y), width, continentalness);
+				std::copy_n(mountainousnessNoise.GetView().Row(y), width, mountainousness);
+				std::copy_n(weirdnessNoise.GetView().Row(y), width, weirdness);
+			}
+			else {
+				//One component per loop, PointNoise reseeds the permutation table of the thread whenever the seed differs
+				//from the last call, so interleaving the three noises would reshuffle it for every pixel
+				for (int x = 0; x < width; x++) {
+					continentalness[x] = continentalnessNoise.PointNoise(x + originx, y + originy);
+				}
+				for (int x = 0; x < width; x++) {
+					mountainousness[x] = mountainousnessNoise.PointNoise(x + originx, y + originy);
+				}
+				for (int x = 0; x < width; x++) {
+					weirdness[x] = weirdnessNoise.PointNoise(x + originx, y + originy);
+				}
+			}
+			for (int x = 0; x < width; x++) {
+				if (continentalness[x] < -1.0f || mountainousness[x] < -1.0f || weirdness[x] < -1.0f) {
+					failed = true;
+					return;
+				}
+			}
+
+			float* row = heightMap.Row(y);
+			evaluation::ComponentRows rows{ continentalness, mountainousness, weirdness, width };
+			policy.EvaluateRow(rows, row);
+
+			if (biomeMap) {
+				for (int x = 0; x < width; x++) {
+					row[x] = ShapeElevation(row[x], y * width + x);
+				}
+			}
+		}
+	}, 4);
+
+	if (failed) {
+		LOG_ERROR("Couldnt get value for component noise!");
+		return false;
+	}
+	return true;
+}
@@ -1,32 +1,381 @@
 #include "VegetationGenerator.h"
 
+#include <cmath>
+#include <iostream>
+#include <algorithm>
 
+#include "Parallel.h"
+#include "Log.h"
+#include "PoissonSampling/PoissonGenerator.h"
 
-//bool TerrainGenerator::GenerateVegetation()
-//{
-//	if (!biomeMap) {
-//		std::cout << "[ERROR] BiomeMap or BiomeMapPerChunk not initialized\n";
-//		return false;
-//	}
-//
-//	PoissonGenerator::DefaultPRNG PRNG;
-//	vegetationPoints.resize(width * height);
-//
-//	treeCount = 0;
-//
-//	for (int y = 0; y < height; y++) {
-//		for (int x = 0; x < width; x++) {
-//			const auto Points = PoissonGenerator::generatePoissonPoints(1.0f, PRNG);
-//
-//			for (int i = 0; i < Points.size(); i++)
-//			{
-//				if (GetHeightAt(Points[i].x + x, Points[i].y + y) < seeLevel)
-//					continue;
-//				vegetationPoints[y * width + x].push_back(std::make_pair(Points[i].x + x, Points[i].y + y));
-//				treeCount++;
-//			}
-//		}
-//	}
-//
-//	return true;
-//}
\ No newline at end of file
+namespace vegetation {
+	//Integer hash used for deterministic, order independent random decisions (tile patterns, instance variation)
+	static uint32_t Hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352dU;
+		x ^= x >> 15;
+		x *= 0x846ca68bU;
+		x ^= x >> 16;
+		return x;
+	}
+
+	static uint32_t Hash(int x, int y, int seed)
+	{
+		return Hash(static_cast<uint32_t>(x) * 0x8da6b343U ^ Hash(static_cast<uint32_t>(y) * 0xd8163841U ^ Hash(static_cast<uint32_t>(seed))));
+	}
+
+	static float ToUnitFloat(uint32_t h)
+	{
+		return (h >> 8) * (1.0f / 16777216.0f);
+	}
+
+	//Generates Poisson-disk points in the unit square treated as a torus, so the pattern can be tiled without seams
+	//Bridson's algorithm with a background grid whose cell size divides the unit square exactly
+	//@param minDist - minimal distance between points in tile units
+	//@param prng - pseudo random generator used for point placement
+	static std::vector<PatternPoint> GenerateTileablePattern(float minDist, PoissonGenerator::DefaultPRNG& prng)
+	{
+		const int newPointsCount = 30;
+		const int gridSize = std::max(1, static_cast<int>(std::floor(std::sqrt(2.0f) / minDist)));
+
+		std::vector<int> grid(gridSize * gridSize, -1);
+		std::vector<PatternPoint> points;
+		std::vector<int> active;
+
+		auto cellOf = [&](float v) { return std::min(static_cast<int>(v * gridSize), gridSize - 1); };
+		auto fits = [&](float x, float y) {
+			int cx = cellOf(x), cy = cellOf(y);
+			for (int dy = -2; dy <= 2; dy++) {
+				for (int dx = -2; dx <= 2; dx++) {
+					int idx = grid[((cy + dy + gridSize) % gridSize) * gridSize + (cx + dx + gridSize) % gridSize];
+					if (idx < 0) {
+						continue;
+					}
+					//Toroidal distance
+					float ddx = std::fabs(points[idx].x - x), ddy = std::fabs(points[idx].y - y);
+					ddx = std::min(ddx, 1.0f - ddx);
+					ddy = std::min(ddy, 1.0f - ddy);
+					if (ddx * ddx + ddy * ddy < minDist * minDist) {
+						return false;
+					}
+				}
+			}
+			return true;
+		};
+		auto insert = [&](float x, float y) {
+			grid[cellOf(y) * gridSize + cellOf(x)] = static_cast<int>(points.size());
+			active.push_back(static_cast<int>(points.size()));
+			points.push_back({ x, y, prng.randomFloat() });
+		};
+
+		insert(prng.randomFloat(), prng.randomFloat());
+
+		while (!active.empty()) {
+			int activeIdx = static_cast<int>(prng.randomInt(static_cast<uint32_t>(active.size())));
+			activeIdx = std::min(activeIdx, static_cast<int>(active.size()) - 1);
+			const PatternPoint p = points[active[activeIdx]];
+			bool placed = false;
+
+			for (int i = 0; i < newPointsCount; i++) {
+				float radius = minDist * (1.0f + prng.randomFloat());
+				float angle = 6.28318530718f * prng.randomFloat();
+				float x = p.x + radius * std::cos(angle);
+				float y = p.y + radius * std::sin(angle);
+				x -= std::floor(x);
+				y -= std::floor(y);
+
+				if (fits(x, y)) {
+					insert(x, y);
+					placed = true;
+					break;
+				}
+			}
+			if (!placed) {
+				active[activeIdx] = active.back();
+				active.pop_back();
+			}
+		}
+		return points;
+	}
+
+	VegetationGenerator::VegetationGenerator() : width(0), height(0), chunksX(0), chunksY(0), instanceCount(0), isGenerated(false), config()
+	{
+	}
+
+	VegetationGenerator::~VegetationGenerator()
+	{
+	}
+
+	//Initializes the size of the map vegetation will be scattered on and precomputes the patterns
+	//@param _width - width of the map
+	//@param _height - height of the map
+	bool VegetationGenerator::Initialize(int _width, int _height)
+	{
+		if (!Resize(_width, _height)) {
+			return false;
+		}
+		GeneratePatterns();
+		return true;
+	}
+
+	//Resizes the map and its chunk grid, previously generated instances are discarded
+	//@param _width - width of the map
+	//@param _height - height of the map
+	bool VegetationGenerator::Resize(int _width, int _height)
+	{
+		if (_width <= 1 || _height <= 1) {
+			LOG_ERROR("Vegetation map couldnt be resized, width and height must be greater than 1");
+			return false;
+		}
+
+		width = _width;
+		height = _height;
+		config.chunkSize = std::max(1, config.chunkSize);
+		chunksX = (width + config.chunkSize - 1) / config.chunkSize;
+		chunksY = (height + config.chunkSize - 1) / config.chunkSize;
+
+		chunks.assign(chunksX * chunksY, VegetationChunk());
+		for (int y = 0; y < chunksY; y++) {
+			for (int x = 0; x < chunksX; x++) {
+				chunks[y * chunksX + x].x = x;
+				chunks[y * chunksX + x].y = y;
+			}
+		}
+		instanceCount = 0;
+		isGenerated = false;
+		return true;
+	}
+
+	//Precomputes config.patternCount tileable Poisson-disk patterns, deterministic for given seed
+	void VegetationGenerator::GeneratePatterns()
+	{
+		config.patternCount = std::max(1, config.patternCount);
+		config.tileSize = std::max(1.0f, config.tileSize);
+		float minDist = std::clamp(config.minDistance / config.tileSize, 0.005f, 0.5f);
+
+		patterns.resize(config.patternCount);
+		patternBorders.assign(config.patternCount, {});
+		patternMinDistance = minDist;
+		for (int i = 0; i < config.patternCount; i++) {
+			PoissonGenerator::DefaultPRNG prng(Hash(static_cast<uint32_t>(config.seed) + i) | 1u);
+			patterns[i] = GenerateTileablePattern(minDist, prng);
+			for (const PatternPoint& point : patterns[i]) {
+				if (point.x < minDist || point.x > 1.0f - minDist || point.y < minDist || point.y > 1.0f - minDist) {
+					patternBorders[i].push_back(point);
+				}
+			}
+		}
+		isGenerated = false;
+	}
+
+	//Sets new configuration, patterns and chunk grid are rebuilt
+	//@param config - VegetationConfig struct containing all the parameters of the scattering
+	void VegetationGenerator::SetConfig(VegetationConfig config)
+	{
+		this->config = config;
+		if (width > 1 && height > 1) {
+			Resize(width, height);
+		}
+		GeneratePatterns();
+	}
+
+	//Memory held by the chunk instances and the precomputed patterns
+	size_t VegetationGenerator::GetByteSize() const
+	{
+		size_t size = chunks.capacity() * sizeof(VegetationChunk);
+		for (const auto& chunk : chunks) {
+			size += chunk.instances.capacity() * sizeof(VegetationInstance);
+		}
+		for (const auto& pattern : patterns) {
+			size += pattern.capacity() * sizeof(PatternPoint);
+		}
+		for (const auto& border : patternBorders) {
+			size += border.capacity() * sizeof(PatternPoint);
+		}
+		return size;
+	}
+
+	//Scatters vegetation instances over the whole map, chunks are processed in parallel
+	//@param heightMap - normalized heightmap of the same size as the generator
+	//@param biomeGen - generated biome map, its blended weights are used if available
+	bool VegetationGenerator::Generate(const float* heightMap, BiomeGenerator& biomeGen)
+	{
+		if (!heightMap) {
+			LOG_ERROR("HeightMap not initialized");
+			return false;
+		}
+		if (!biomeGen.IsGenerated() || biomeGen.GetWidth() != width || biomeGen.GetHeight() != height) {
+			LOG_ERROR("BiomeMap not generated or has invalid size");
+			return false;
+		}
+		if (patterns.empty()) {
+			GeneratePatterns();
+		}
+
+		//Vegetation density of every biome, gathered up front so workers dont touch the biome container
+		float biomeDensity[256];
+		for (int id = 0; id < 256; id++) {
+			biomeDensity[id] = biomeGen.HasBiome(id) ? std::clamp(biomeGen.GetBiome(id).GetVegetationLevel(), 0.0f, 1.0f) : 0.0f;
+		}
+
+		const int* biomeMap = biomeGen.GetBiomeMap();
+		const biome::BiomeWeights* biomeWeights = biomeGen.GetBiomeWeights();
+
+		utilities::ParallelFor(0, static_cast<int>(chunks.size()), [&](int c0, int c1) {
+			for (int c = c0; c < c1; c++) {
+				ScatterChunk(chunks[c], heightMap, biomeMap, biomeWeights, biomeDensity);
+			}
+		}, 1);
+
+		instanceCount = 0;
+		for (auto& chunk : chunks) {
+			instanceCount += chunk.instances.size();
+		}
+		isGenerated = true;
+		LOG_INFO("Vegetation scattered, instances: " << instanceCount);
+		return true;
+	}
+
+	//Fills a single chunk with instances taken from the patterns of tiles overlapping it
+	//@param chunk - chunk to be filled
+	//@param heightMap - normalized heightmap
+	//@param biomeMap - map of biome ids
+	//@param biomeWeights - optional blended biome weights, nullptr if blending is disabled
+	//@param biomeDensity - table of vegetation density indexed by biome id
+	void VegetationGenerator::ScatterChunk(VegetationChunk& chunk, const float* heightMap, const int* biomeMap, const biome::BiomeWeights* biomeWeights, const float* biomeDensity)
+	{
+		//Instances are kept inside [0, width - 1) so bilinear height sampling stays on the map
+		const float x0 = static_cast<float>(chunk.x * config.chunkSize);
+		const float y0 = static_cast<float>(chunk.y * config.chunkSize);
+		const float x1 = std::min(x0 + config.chunkSize, width - 1.0f);
+		const float y1 = std::min(y0 + config.chunkSize, height - 1.0f);
+
+		const int tx0 = static_cast<int>(std::floor(x0 / config.tileSize));
+		const int ty0 = static_cast<int>(std::floor(y0 / config.tileSize));
+		const int tx1 = static_cast<int>(std::ceil(x1 / config.tileSize));
+		const int ty1 = static_cast<int>(std::ceil(y1 / config.tileSize));
+
+		chunk.instances.clear();
+
+		for (int ty = ty0; ty < ty1; ty++) {
+			for (int tx = tx0; tx < tx1; tx++) {
+				const uint32_t tileHash = Hash(tx, ty, config.seed);
+				const int patternId = GetTilePattern(tx, ty);
+				const std::vector<PatternPoint>& pattern = patterns[patternId];
+				//Per tile rotation of the thresholds, decorrelates tiles sharing the same pattern
+				const float thresholdShift = ToUnitFloat(Hash(tileHash));
+
+				for (size_t i = 0; i < pattern.size(); i++) {
+					const float px = (tx + pattern[i].x) * config.tileSize;
+					const float py = (ty + pattern[i].y) * config.tileSize;
+					if (px < x0 || px >= x1 || py < y0 || py >= y1) {
+						continue;
+					}
+					if (ConflictsWithNeighbours(tx, ty, patternId, pattern[i])) {
+						continue;
+					}
+
+					const int ix = static_cast<int>(px);
+					const int iy = static_cast<int>(py);
+					const int idx = iy * width + ix;
+
+					float density = 0.0f;
+					if (biomeWeights) {
+						for (int k = 0; k < biome::MAX_BLENDED_BIOMES; k++) {
+							density += biomeDensity[biomeWeights[idx].ids[k]] * (biomeWeights[idx].weights[k] / 255.0f);
+						}
+					}
+					else if (biomeMap[idx] >= 0 && biomeMap[idx] < 256) {
+						density = biomeDensity[biomeMap[idx]];
+					}
+
+					const float h = SampleHeight(heightMap, px, py);
+					if (h < config.minHeight || h > config.maxHeight) {
+						continue;
+					}
+					if (config.heightFalloff > 0.0f) {
+						density *= std::min(1.0f, (config.maxHeight - h) / config.heightFalloff);
+					}
+					if (config.maxSlope > 0.0f) {
+						density *= std::max(0.0f, 1.0f - Slope(heightMap, ix, iy) / config.maxSlope);
+					}
+
+					float threshold = pattern[i].threshold + thresholdShift;
+					threshold -= std::floor(threshold);
+					if (threshold >= density) {
+						continue;
+					}
+
+					const uint32_t instanceHash = Hash(tileHash ^ static_cast<uint32_t>(i));
+					VegetationInstance instance;
+					instance.x = px;
+					instance.y = h * config.heightScale;
+					instance.z = py;
+					instance.scale = config.minScale + (config.maxScale - config.minScale) * ToUnitFloat(instanceHash);
+					instance.rotation = 6.28318530718f * ToUnitFloat(Hash(instanceHash));
+					instance.biomeId = biomeMap[idx];
+					chunk.instances.push_back(instance);
+				}
+			}
+		}
+	}
+
+	//@return - index of the pattern used by the tile
+	int VegetationGenerator::GetTilePattern(int tileX, int tileY) const
+	{
+		return static_cast<int>(Hash(tileX, tileY, config.seed) % patterns.size());
+	}
+
+	//Checks a pattern point against the neighbours preceding its tile in raster order (the row above and the tile on the left)
+	//Neighbours with the same pattern continue it seamlessly, points of the others are compared across the shared edge
+	//Conflicts are resolved in favour of the preceding tile independently of its own conflicts, so every chunk decides alone
+	//@param tileX, tileY - tile of the point
+	//@param pattern - pattern of the tile
+	//@param point - point in tile units
+	//@return - true if the point is closer than the minimal distance to a point of such a neighbour
+	bool VegetationGenerator::ConflictsWithNeighbours(int tileX, int tileY, int pattern, const PatternPoint& point) const
+	{
+		const float d = patternMinDistance;
+		if (point.x >= d && point.y >= d) {
+			return false;
+		}
+		static const int neighbours[4][2] = { {-1, -1}, {0, -1}, {1, -1}, {-1, 0} };
+		for (const auto& offset : neighbours) {
+			const int neighbourPattern = GetTilePattern(tileX + offset[0], tileY + offset[1]);
+			if (neighbourPattern == pattern) {
+				continue;
+			}
+			for (const PatternPoint& other : patternBorders[neighbourPattern]) {
+				const float dx = other.x + offset[0] - point.x;
+				const float dy = other.y + offset[1] - point.y;
+				if (dx * dx + dy * dy < d * d) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	//Bilinear interpolation of the heightmap, position has to be inside [0, width - 1) x [0, height - 1)
+	float VegetationGenerator::SampleHeight(const float* heightMap, float x, float y) const
+	{
+		const int ix = static_cast<int>(x);
+		const int iy = static_cast<int>(y);
+		const float v = x - ix;
+		const float u = y - iy;
+		const float* row0 = heightMap + iy * width + ix;
+		const float* row1 = row0 + width;
+		return (row0[0] * (1 - v) + row0[1] * v) * (1 - u) + (row1[0] * (1 - v) + row1[1] * v) * u;
+	}
+
+	//Slope of the terrain in the cell, central differences of the scaled heightmap, one sided at the borders
+	float VegetationGenerator::Slope(const float* heightMap, int x, int y) const
+	{
+		const int xl = std::max(x - 1, 0), xr = std::min(x + 1, width - 1);
+		const int yd = std::max(y - 1, 0), yu = std::min(y + 1, height - 1);
+		const float dx = (heightMap[y * width + xr] - heightMap[y * width + xl]) / (xr - xl);
+		const float dz = (heightMap[yu * width + x] - heightMap[yd * width + x]) / (yu - yd);
+		return std::sqrt(dx * dx + dz * dz) * config.heightScale;
+	}
+}
@@ -1,5 +1,108 @@
 #pragma once
-class VegetationGenerator
-{
-};
 
+#include <vector>
+#include <cstdint>
+
+#include "BiomeGenerator.h"
+
+//Vegetation scattering based on a small set of precomputed, tileable Poisson-disk patterns.
+//Map is divided into tiles, each tile picks one of the patterns by hashing its coordinates with the seed,
+//and every pattern point carries a random threshold which is compared with the local density
+//(biome vegetation level, slope and height). Result is deterministic per seed and independent of thread count.
+//Patterns are toroidal, so a tile continues seamlessly into neighbours with the same pattern. Across the edge of
+//neighbours with different patterns a point closer than minDistance to a point of the neighbour preceding its tile
+//in raster order is dropped, which keeps the minimal distance over the whole map.
+
+namespace vegetation {
+	//Configuration parameters for the vegetation scattering
+	//@param seed: Seed used for patterns generation and tile pattern selection
+	//@param patternCount: Number of precomputed Poisson-disk patterns
+	//@param tileSize: Size of a pattern tile in map cells
+	//@param minDistance: Minimal distance between instances in map cells
+	//@param chunkSize: Size of an output chunk in map cells
+	//@param heightScale: Scale applied to the heightmap values when computing slope and instance height
+	//@param minHeight, maxHeight: Normalized height range in which vegetation can grow
+	//@param heightFalloff: Width of the band near maxHeight in which density fades out
+	//@param maxSlope: Slope (rise over one cell) above which no vegetation grows
+	//@param minScale, maxScale: Range of random instance scale
+	struct VegetationConfig {
+		int seed = 1337;
+		int patternCount = 4;
+		float tileSize = 16.0f;
+		float minDistance = 1.5f;
+		int chunkSize = 64;
+
+		float heightScale = 256.0f;
+		float minHeight = 0.05f;
+		float maxHeight = 0.8f;
+		float heightFalloff = 0.1f;
+		float maxSlope = 1.0f;
+
+		float minScale = 0.8f;
+		float maxScale = 1.2f;
+	};
+
+	//Single vegetation instance, position is given in map cells, y being the scaled height
+	struct VegetationInstance {
+		float x, y, z;
+		float scale;
+		float rotation;
+		int biomeId;
+	};
+
+	//Flat array of instances placed inside one chunk of the map
+	struct VegetationChunk {
+		int x, y;
+		std::vector<VegetationInstance> instances;
+	};
+
+	//Point of a precomputed pattern, position in [0, 1) tile space and density threshold in [0, 1)
+	struct PatternPoint {
+		float x, y;
+		float threshold;
+	};
+
+	class VegetationGenerator
+	{
+	public:
+		VegetationGenerator();
+		~VegetationGenerator();
+
+		bool Initialize(int _width, int _height);
+		bool Resize(int _width, int _height);
+		void GeneratePatterns();
+		bool Generate(const float* heightMap, BiomeGenerator& biomeGen);
+
+		void SetConfig(VegetationConfig config);
+
+		VegetationConfig& GetConfigRef() { return config; }
+		const std::vector<VegetationChunk>& GetChunks() const { return chunks; }
+		const VegetationChunk& GetChunk(int chunkX, int chunkY) const { return chunks[chunkY * chunksX + chunkX]; }
+		int GetWidth() const { return width; }
+		int GetHeight() const { return height; }
+		int GetChunksX() const { return chunksX; }
+		int GetChunksY() const { return chunksY; }
+		size_t GetInstanceCount() const { return instanceCount; }
+		bool IsGenerated() const { return isGenerated; }
+		size_t GetByteSize() const;
+
+	private:
+		int width, height;
+		int chunksX, chunksY;
+		size_t instanceCount;
+		bool isGenerated;
+
+		VegetationConfig config;
+		std::vector<std::vector<PatternPoint>> patterns;
+		//Points of every pattern closer than the minimal distance to an edge of the tile, in tile units
+		std::vector<std::vector<PatternPoint>> patternBorders;
+		float patternMinDistance = 0.0f;
+		std::vector<VegetationChunk> chunks;
+
+		void ScatterChunk(VegetationChunk& chunk, const float* heightMap, const int* biomeMap, const biome::BiomeWeights* biomeWeights, const float* biomeDensity);
+		int GetTilePattern(int tileX, int tileY) const;
+		bool ConflictsWithNeighbours(int tileX, int tileY, int pattern, const PatternPoint& point) const;
+		float SampleHeight(const float* heightMap, float x, float y) const;
+		float Slope(const float* heightMap, int x, int y) const;
+	};
+}
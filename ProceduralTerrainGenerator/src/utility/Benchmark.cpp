@@ -0,0 +1,240 @@
+#include "Benchmark.h"
+#include "Log.h"
+
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace utilities
+{
+	namespace {
+		//Discards the log of the kernels while alive, the log sink is swapped instead of the buffer of std::cout
+		//since the log writer thread may be printing at any time
+		class LogSilencer
+		{
+		public:
+			explicit LogSilencer(bool _enabled) : enabled(_enabled), previous(_enabled ? GetLogSink() : nullptr)
+			{
+				if (enabled) SetLogSink(nullptr);
+			}
+			~LogSilencer() { if (enabled) SetLogSink(previous); }
+		private:
+			bool enabled;
+			std::ostream* previous;
+		};
+
+		std::string CompilerName()
+		{
+#if defined(_MSC_VER)
+			return "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+			return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+			return std::string("gcc ") + __VERSION__;
+#else
+			return "unknown";
+#endif
+		}
+
+#ifndef _WIN32
+		//Reads a "Key:   value kB" line of /proc/self/status
+		size_t ReadProcStatus(const char* key)
+		{
+			std::ifstream status("/proc/self/status");
+			std::string line;
+			const size_t keyLength = std::char_traits<char>::length(key);
+			while (std::getline(status, line)) {
+				if (line.compare(0, keyLength, key) == 0) {
+					return std::stoull(line.substr(keyLength)) * 1024;
+				}
+			}
+			return 0;
+		}
+#endif
+	}
+
+	BenchmarkSuite::BenchmarkSuite(const std::string& _name, const BenchmarkSettings& _settings) : name(_name), settings(_settings)
+	{
+	}
+
+	//Measures a benchmark and stores its result
+	//@param benchmarkName - name of the benchmark, "group/case" by convention
+	//@param unit - name of the processed items
+	//@param itemsPerIteration - number of items processed by one call of the body
+	//@param body - measured code
+	//@param reset - optional untimed code run before every iteration, f.e. restoring the input of an in-place kernel
+	//@return - false if the benchmark was skipped by the filter
+	bool BenchmarkSuite::Run(const std::string& benchmarkName, const std::string& unit, double itemsPerIteration, const std::function<void()>& body,
+		const std::function<void()>& reset)
+	{
+		if (!settings.filter.empty() && benchmarkName.find(settings.filter) == std::string::npos) {
+			return false;
+		}
+
+		BenchmarkResult result;
+		result.name = benchmarkName;
+		result.unit = unit;
+		result.itemsPerIteration = itemsPerIteration;
+		{
+			LogSilencer silencer(settings.quiet);
+			for (int i = 0; i < settings.warmupIterations; i++) {
+				if (reset) reset();
+				body();
+			}
+
+			double total = 0.0;
+			while (static_cast<int>(result.times.size()) < settings.maxIterations &&
+				(static_cast<int>(result.times.size()) < settings.minIterations || total < settings.minTime)) {
+				if (reset) reset();
+				auto start = std::chrono::high_resolution_clock::now();
+				body();
+				std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+				result.times.push_back(duration.count());
+				total += duration.count();
+			}
+		}
+
+		std::vector<double> sorted = result.times;
+		std::sort(sorted.begin(), sorted.end());
+		result.min = sorted.front();
+		result.max = sorted.back();
+		result.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+		result.p50 = Percentile(sorted, 50.0);
+		result.p90 = Percentile(sorted, 90.0);
+		result.p99 = Percentile(sorted, 99.0);
+		result.throughput = result.p50 > 0.0 ? itemsPerIteration / (result.p50 / 1000.0) : 0.0;
+
+		std::cout << "[LOG] " << std::left << std::setw(48) << benchmarkName << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << result.p50 << " ms  " << std::setprecision(2) << std::setw(10) << result.throughput / 1e6 << " M" << unit << "/s\n";
+		std::cout.unsetf(std::ios::floatfield);
+
+		results.push_back(std::move(result));
+		return true;
+	}
+
+	//Nearest rank percentile of sorted values
+	double BenchmarkSuite::Percentile(const std::vector<double>& sorted, double percentile)
+	{
+		if (sorted.empty()) {
+			return 0.0;
+		}
+		size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+		return sorted[std::clamp(rank, static_cast<size_t>(1), sorted.size()) - 1];
+	}
+
+	void BenchmarkSuite::PrintTable(std::ostream& out) const
+	{
+		out << "\n" << name << "\n" << std::left << std::setw(48) << "benchmark" << std::right
+			<< std::setw(8) << "iters" << std::setw(11) << "min ms" << std::setw(11) << "p50 ms" << std::setw(11) << "p90 ms"
+			<< std::setw(11) << "p99 ms" << std::setw(16) << "throughput/s" << "\n";
+		for (const auto& r : results) {
+			out << std::left << std::setw(48) << r.name << std::right << std::setw(8) << r.times.size() << std::fixed << std::setprecision(3)
+				<< std::setw(11) << r.min << std::setw(11) << r.p50 << std::setw(11) << r.p90 << std::setw(11) << r.p99
+				<< std::setprecision(2) << std::setw(12) << r.throughput / 1e6 << " M " << r.unit << "\n";
+		}
+		out.unsetf(std::ios::floatfield);
+	}
+
+	std::string BenchmarkSuite::EscapeJson(const std::string& s)
+	{
+		std::string escaped;
+		for (char c : s) {
+			switch (c) {
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char code[8];
+					std::snprintf(code, sizeof(code), "\\u%04x", c);
+					escaped += code;
+				}
+				else {
+					escaped += c;
+				}
+			}
+		}
+		return escaped;
+	}
+
+	//Writes the results with the machine description, meant to be compared between versions
+	bool BenchmarkSuite::WriteJson(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			std::cout << "[ERROR] Could not open benchmark report: " << path << "\n";
+			return false;
+		}
+
+		std::time_t now = std::time(nullptr);
+		char date[32];
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+		file << std::setprecision(9);
+		file << "{\n";
+		file << "  \"suite\": \"" << EscapeJson(name) << "\",\n";
+		file << "  \"date\": \"" << date << "\",\n";
+		file << "  \"compiler\": \"" << EscapeJson(CompilerName()) << "\",\n";
+#ifdef NDEBUG
+		file << "  \"build\": \"release\",\n";
+#else
+		file << "  \"build\": \"debug\",\n";
+#endif
+		file << "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+		file << "  \"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); i++) {
+			const BenchmarkResult& r = results[i];
+			file << "    {\"name\": \"" << EscapeJson(r.name) << "\", \"unit\": \"" << EscapeJson(r.unit) << "\", \"itemsPerIteration\": " << r.itemsPerIteration
+				<< ", \"iterations\": " << r.times.size() << ", \"minMs\": " << r.min << ", \"meanMs\": " << r.mean << ", \"p50Ms\": " << r.p50
+				<< ", \"p90Ms\": " << r.p90 << ", \"p99Ms\": " << r.p99 << ", \"maxMs\": " << r.max << ", \"throughputPerSecond\": " << r.throughput << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		file << "  ]\n}\n";
+		return file.good();
+	}
+
+	size_t GetCurrentResidentMemory()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+#else
+		return ReadProcStatus("VmRSS:");
+#endif
+	}
+
+	size_t GetPeakResidentMemory()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+		return ReadProcStatus("VmHWM:");
+#endif
+	}
+
+	bool ResetPeakResidentMemory()
+	{
+#ifdef _WIN32
+		return false;
+#else
+		//Writing 5 to clear_refs resets the VmHWM counter of the process
+		std::ofstream clearRefs("/proc/self/clear_refs");
+		return clearRefs.is_open() && (clearRefs << "5").flush().good();
+#endif
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <vector>
+#include <ostream>
+#include <functional>
+
+//Small benchmark harness used by the benchmark executables, nothing here depends on OpenGL.
+//Every benchmark is warmed up and then repeated until both the minimal iteration count and the minimal time are reached,
+//the wall time of every iteration is kept so the report contains percentiles and not just a single number.
+
+namespace utilities
+{
+	//Timing statistics of one benchmark, times are in milliseconds
+	//@param itemsPerIteration: Number of processed items (samples, droplets, indices) in one iteration
+	//@param unit: Name of the item used in the report, f.e. "samples"
+	//@param throughput: Items per second at the median time
+	struct BenchmarkResult {
+		std::string name;
+		std::string unit;
+		double itemsPerIteration = 0.0;
+		std::vector<double> times;
+		double min = 0.0, mean = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+		double throughput = 0.0;
+	};
+
+	//Benchmark settings
+	//@param filter: Only benchmarks with the filter in their name are run, empty runs all of them
+	//@param warmupIterations: Untimed iterations before the measurement
+	//@param minIterations, maxIterations: Bounds of the number of timed iterations
+	//@param minTime: Timed iterations are repeated until their total time reaches minTime milliseconds
+	//@param quiet: Log of the benchmarked code is discarded
+	struct BenchmarkSettings {
+		std::string filter;
+		int warmupIterations = 1;
+		int minIterations = 5;
+		int maxIterations = 1000;
+		double minTime = 200.0;
+		bool quiet = true;
+	};
+
+	class BenchmarkSuite
+	{
+	public:
+		BenchmarkSuite(const std::string& _name, const BenchmarkSettings& _settings);
+
+		bool Run(const std::string& benchmarkName, const std::string& unit, double itemsPerIteration, const std::function<void()>& body,
+			const std::function<void()>& reset = nullptr);
+
+		void PrintTable(std::ostream& out) const;
+		bool WriteJson(const std::string& path) const;
+
+		const std::vector<BenchmarkResult>& GetResults() const { return results; }
+
+		static double Percentile(const std::vector<double>& sorted, double percentile);
+		static std::string EscapeJson(const std::string& s);
+	private:
+		std::string name;
+		BenchmarkSettings settings;
+		std::vector<BenchmarkResult> results;
+	};
+
+	//Resident memory of the process in bytes, 0 if the platform does not report it
+	size_t GetCurrentResidentMemory();
+	size_t GetPeakResidentMemory();
+	//Restarts the peak resident memory from the current value (Linux only)
+	//@return - false if the peak could not be reset and GetPeakResidentMemory keeps the peak of the whole process
+	bool ResetPeakResidentMemory();
+}
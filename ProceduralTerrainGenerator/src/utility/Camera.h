@@ -57,6 +57,7 @@ public:
 	void SetFov(float value) { fov = value; }
 	void SetScreenSize(unsigned int width, unsigned int height);
 
+	unsigned int GetScreenHeight() const { return screenHeight; }
 	float GetYaw() const{ return yaw; }
 	float GetPitch() const{ return pitch; }
 	float& GetSpeedRef() { return initSpeed; }
@@ -0,0 +1,106 @@
+#include "CompactVertex.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "utilities.h"
+#include "Parallel.h"
+#include "ScratchArena.h"
+#include "Log.h"
+
+namespace utilities
+{
+	template <typename Vertex, typename NormalType>
+	static HeightQuantization MapToCompactVerticesImpl(const float* map, const unsigned char* colorIndices, int width, int height, float heightScale, Vertex* vertices)
+	{
+		HeightQuantization q;
+		if (!map || !vertices || width <= 0 || height <= 0) {
+			LOG_ERROR("Compact vertices couldnt be generated, map not initialized");
+			return q;
+		}
+
+		const size_t count = static_cast<size_t>(width) * height;
+		float minHeight = std::numeric_limits<float>::max(), maxHeight = std::numeric_limits<float>::lowest();
+		for (size_t i = 0; i < count; i++) {
+			minHeight = std::min(minHeight, map[i]);
+			maxHeight = std::max(maxHeight, map[i]);
+		}
+		q.heightMin = minHeight * heightScale;
+		q.heightRange = std::max((maxHeight - minHeight) * heightScale, 1e-6f);
+
+		const float invRange = 1.0f / std::max(maxHeight - minHeight, 1e-6f);
+		const float normalMax = static_cast<float>(std::numeric_limits<NormalType>::max());
+		//Normals are calculated a row at a time into the scratch arena of the band and encoded right away,
+		//so no float normal map of the whole mesh is allocated
+		ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+			ScratchArena& scratch = GetThreadScratch();
+			ScratchScope scope(scratch);
+			float* normals = scratch.Allocate<float>(static_cast<size_t>(width) * 3);
+			for (int z = bandBegin; z < bandEnd; z++) {
+				CalculateNormalRow(map, width, height, z, heightScale, normals, 3, 0);
+				const size_t rowStart = static_cast<size_t>(z) * width;
+				for (int x = 0; x < width; x++) {
+					const size_t i = rowStart + x;
+					float hNorm = std::clamp((map[i] - minHeight) * invRange, 0.0f, 1.0f);
+					glm::vec2 e = OctEncode(glm::vec3(normals[x * 3], normals[x * 3 + 1], normals[x * 3 + 2]));
+					Vertex& v = vertices[i];
+					v.height = static_cast<uint16_t>(hNorm * 65535.0f + 0.5f);
+					v.normal[0] = static_cast<NormalType>(std::round(std::clamp(e.x, -1.0f, 1.0f) * normalMax));
+					v.normal[1] = static_cast<NormalType>(std::round(std::clamp(e.y, -1.0f, 1.0f) * normalMax));
+					v.colorIndex = colorIndices ? colorIndices[i] : static_cast<uint8_t>(hNorm * 255.0f + 0.5f);
+					v.padding = 0;
+				}
+			}
+		}, 32);
+		return q;
+	}
+
+	//Converts the height map into compact vertices laid out row by row, x and z are implicit
+	//@param map - height map of size width * height
+	//@param colorIndices - optional palette index per vertex, if nullptr index is the quantized normalized height
+	//@param width - width of the height map
+	//@param height - height of the height map
+	//@param heightScale - scaling factor for generating height values
+	//@param vertices - output array of width * height vertices
+	//@return - range needed to dequantize the heights
+	HeightQuantization MapToCompactVertices(const float* map, const unsigned char* colorIndices, int width, int height, float heightScale, CompactVertex8* vertices)
+	{
+		return MapToCompactVerticesImpl<CompactVertex8, int8_t>(map, colorIndices, width, height, heightScale, vertices);
+	}
+
+	HeightQuantization MapToCompactVertices(const float* map, const unsigned char* colorIndices, int width, int height, float heightScale, CompactVertex16* vertices)
+	{
+		return MapToCompactVerticesImpl<CompactVertex16, int16_t>(map, colorIndices, width, height, heightScale, vertices);
+	}
+
+	//Layout matching the compact vertex structures: height, normal, colour index, padding
+	VertexBufferLayout GetCompactVertexLayout(NormalPrecision precision)
+	{
+		VertexBufferLayout layout;
+		layout.Push<unsigned short>(1);
+		if (precision == NormalPrecision::OCT8) {
+			layout.Push<signed char>(2);
+		}
+		else {
+			layout.Push<short>(2);
+		}
+		layout.Push<unsigned char>(2);
+		return layout;
+	}
+
+	unsigned int GetCompactVertexSize(NormalPrecision precision)
+	{
+		return precision == NormalPrecision::OCT8 ? sizeof(CompactVertex8) : sizeof(CompactVertex16);
+	}
+
+	//Topographical gradient sampled into 256 palette entries indexed by the quantized height
+	std::vector<glm::vec3> GetTopoPalette()
+	{
+		std::vector<glm::vec3> palette(256);
+		for (int i = 0; i < 256; i++) {
+			palette[i] = getTopoColor(i / 255.0f);
+		}
+		return palette;
+	}
+}
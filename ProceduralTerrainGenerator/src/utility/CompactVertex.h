@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "VertexBufferLayout.h"
+#include "NormalMap.h"
+
+//Compact terrain vertex formats. Only the height is stored as a 16-bit normalized value, x and z are
+//derived from gl_VertexID in the vertex shader. Normals are octahedral encoded into two signed normalized
+//values and the colour is an 8-bit index into a palette (topographical gradient or biome colours).
+//Float vertex of MapToVertices takes 36 bytes, the compact formats take 6 (OCT8) or 8 (OCT16) bytes.
+
+namespace utilities
+{
+	enum class NormalPrecision {
+		OCT8,
+		OCT16
+	};
+
+	struct CompactVertex8 {
+		uint16_t height;
+		int8_t normal[2];
+		uint8_t colorIndex;
+		uint8_t padding;
+	};
+
+	struct CompactVertex16 {
+		uint16_t height;
+		int16_t normal[2];
+		uint8_t colorIndex;
+		uint8_t padding;
+	};
+
+	//Range used to dequantize the height in the shader: height = heightMin + value * heightRange
+	struct HeightQuantization {
+		float heightMin = 0.0f;
+		float heightRange = 1.0f;
+	};
+
+	HeightQuantization MapToCompactVertices(const float* map, const unsigned char* colorIndices, int width, int height, float heightScale, CompactVertex8* vertices);
+	HeightQuantization MapToCompactVertices(const float* map, const unsigned char* colorIndices, int width, int height, float heightScale, CompactVertex16* vertices);
+	VertexBufferLayout GetCompactVertexLayout(NormalPrecision precision);
+	unsigned int GetCompactVertexSize(NormalPrecision precision);
+	std::vector<glm::vec3> GetTopoPalette();
+}
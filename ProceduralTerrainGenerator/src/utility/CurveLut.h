@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace utilities
+{
+	//Uniformly sampled lookup table of a 1D curve over [xmin, xmax], evaluated by linear interpolation.
+	//Outside of the range the first and last segments are extrapolated, empty table is an identity.
+	class CurveLut
+	{
+	public:
+		CurveLut() : xmin(0.0f), xmax(1.0f), invStep(0.0f) {}
+
+		//Samples the curve at resolution + 1 evenly spaced points
+		//@param curve - callable object taking double and returning the value of the curve (f.e. tk::spline)
+		//@param _xmin, _xmax - sampled range
+		//@param resolution - number of segments of the table
+		template <typename Curve>
+		void Bake(const Curve& curve, float _xmin, float _xmax, int resolution)
+		{
+			resolution = std::max(1, resolution);
+			xmin = _xmin;
+			xmax = _xmax;
+			invStep = resolution / (xmax - xmin);
+			values.resize(resolution + 1);
+			for (int i = 0; i <= resolution; i++) {
+				double x = xmin + (xmax - xmin) * (static_cast<double>(i) / resolution);
+				values[i] = static_cast<float>(curve(x));
+			}
+			maxError = MeasureError(curve);
+		}
+
+		//Bakes the curve starting at minResolution and doubling the resolution until the interpolation error
+		//is below maxAllowedError or maxResolution is reached
+		//@return - measured maximal error of the table
+		template <typename Curve>
+		float BakeWithErrorBound(const Curve& curve, float _xmin, float _xmax, int minResolution, int maxResolution, float maxAllowedError)
+		{
+			int resolution = std::max(1, minResolution);
+			Bake(curve, _xmin, _xmax, resolution);
+			while (maxError > maxAllowedError && resolution * 2 <= maxResolution) {
+				resolution *= 2;
+				Bake(curve, _xmin, _xmax, resolution);
+			}
+			return maxError;
+		}
+
+		void Clear() { values.clear(); maxError = 0.0f; }
+		bool IsBaked() const { return !values.empty(); }
+		int GetResolution() const { return static_cast<int>(values.size()) - 1; }
+		float GetMaxError() const { return maxError; }
+
+		float Evaluate(float x) const
+		{
+			if (values.empty()) {
+				return x;
+			}
+			const int last = static_cast<int>(values.size()) - 2;
+			float t = (x - xmin) * invStep;
+			int i = std::clamp(static_cast<int>(t), 0, last);
+			float f = t - i;
+			return values[i] + (values[i + 1] - values[i]) * f;
+		}
+
+		//Evaluates the table for a whole row of values, the loop has no branches so the compiler can vectorize it
+		//@param in - input values
+		//@param out - output values, can be the same array as in
+		//@param count - number of values
+		void EvaluateRow(const float* in, float* out, int count) const
+		{
+			if (values.empty()) {
+				std::copy(in, in + count, out);
+				return;
+			}
+			const float* v = values.data();
+			const float last = static_cast<float>(values.size() - 2);
+			for (int i = 0; i < count; i++) {
+				float t = (in[i] - xmin) * invStep;
+				float cell = std::min(std::max(std::floor(t), 0.0f), last);
+				int index = static_cast<int>(cell);
+				float f = t - cell;
+				out[i] = v[index] + (v[index + 1] - v[index]) * f;
+			}
+		}
+
+	private:
+		std::vector<float> values;
+		float xmin, xmax, invStep;
+		float maxError = 0.0f;
+
+		//Compares the table with the curve at 4 points inside of every segment
+		template <typename Curve>
+		float MeasureError(const Curve& curve) const
+		{
+			float error = 0.0f;
+			const int resolution = GetResolution();
+			for (int i = 0; i < resolution; i++) {
+				for (int k = 1; k < 5; k++) {
+					double x = xmin + (xmax - xmin) * ((i + k / 5.0) / resolution);
+					error = std::max(error, static_cast<float>(std::abs(curve(x) - Evaluate(static_cast<float>(x)))));
+				}
+			}
+			return error;
+		}
+	};
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <new>
+#include <memory>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+//Owning 2D container of the generation maps and the non-owning views passed between the stages.
+//Storage starts on a 64 byte boundary and rows are tightly packed, since the maps are handed to OpenGL and the exporters
+//as they are. For the usual power of two widths every row starts aligned as well. Views carry a pitch, so sub-rectangles
+//of a map can be passed without copying.
+
+namespace utilities
+{
+	//Alignment of the grid storage in bytes, a cache line and the width of the widest SIMD registers
+	constexpr size_t GRID_ALIGNMENT = 64;
+
+	//Non-owning view of a 2D array, consecutive rows are pitch elements apart
+	//Sub-rectangle views keep the pitch of their parent, so they are not contiguous
+	template<typename T>
+	class GridView
+	{
+	public:
+		GridView() : data(nullptr), width(0), height(0), pitch(0) {}
+		GridView(T* _data, int _width, int _height) : GridView(_data, _width, _height, static_cast<size_t>(std::max(0, _width))) {}
+		GridView(T* _data, int _width, int _height, size_t _pitch) : data(_data), width(_width), height(_height), pitch(_pitch) {}
+
+		//Views of mutable elements convert to read-only views
+		template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+		GridView(const GridView<U>& other) : data(other.Data()), width(other.GetWidth()), height(other.GetHeight()), pitch(other.GetPitch()) {}
+
+		T* Data() const { return data; }
+		T* Row(int y) const { return data + y * pitch; }
+		T& operator()(int x, int y) const { return data[y * pitch + x]; }
+
+		int GetWidth() const { return width; }
+		int GetHeight() const { return height; }
+		size_t GetPitch() const { return pitch; }
+		size_t GetSize() const { return static_cast<size_t>(width) * height; }
+		bool IsEmpty() const { return !data || width <= 0 || height <= 0; }
+		bool IsContiguous() const { return pitch == static_cast<size_t>(width); }
+
+		//Returns the part of the rectangle [x, x + w) x [y, y + h) lying inside of the view
+		GridView SubView(int x, int y, int w, int h) const
+		{
+			const int x0 = std::clamp(x, 0, width), y0 = std::clamp(y, 0, height);
+			const int x1 = std::clamp(x + w, x0, width), y1 = std::clamp(y + h, y0, height);
+			return GridView(data + y0 * pitch + x0, x1 - x0, y1 - y0, pitch);
+		}
+
+		void Fill(const T& value) const
+		{
+			for (int y = 0; y < height; y++) {
+				std::fill(Row(y), Row(y) + width, value);
+			}
+		}
+
+		//Copies the elements of a view with the same dimensions, a contiguous pair is copied in one go
+		//@return - false if the dimensions differ
+		bool CopyFrom(GridView<const std::remove_const_t<T>> source) const
+		{
+			if (source.GetWidth() != width || source.GetHeight() != height) {
+				return false;
+			}
+			if (IsEmpty()) {
+				return true;
+			}
+			if (IsContiguous() && source.IsContiguous()) {
+				std::memcpy(data, source.Data(), GetSize() * sizeof(T));
+				return true;
+			}
+			for (int y = 0; y < height; y++) {
+				std::memcpy(Row(y), source.Row(y), width * sizeof(T));
+			}
+			return true;
+		}
+
+	private:
+		T* data;
+		int width, height;
+		size_t pitch;
+	};
+
+	//Move-only owning 2D array with aligned storage
+	//Elements are default initialized, so maps of plain numbers start with undefined values like the new[] buffers did
+	template<typename T>
+	class Grid
+	{
+		static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "Grid stores plain data only");
+	public:
+		Grid() : data(nullptr), width(0), height(0), pitch(0), capacity(0) {}
+		Grid(int _width, int _height) : Grid() { Resize(_width, _height); }
+		~Grid() { Release(); }
+
+		Grid(const Grid&) = delete;
+		Grid& operator=(const Grid&) = delete;
+
+		Grid(Grid&& other) noexcept : data(std::exchange(other.data, nullptr)), width(std::exchange(other.width, 0)), height(std::exchange(other.height, 0)),
+			pitch(std::exchange(other.pitch, 0)), capacity(std::exchange(other.capacity, 0)) {}
+
+		Grid& operator=(Grid&& other) noexcept
+		{
+			if (this != &other) {
+				Release();
+				data = std::exchange(other.data, nullptr);
+				width = std::exchange(other.width, 0);
+				height = std::exchange(other.height, 0);
+				pitch = std::exchange(other.pitch, 0);
+				capacity = std::exchange(other.capacity, 0);
+			}
+			return *this;
+		}
+
+		//Changes the dimensions, the storage is reused if it is large enough so the content is undefined afterwards
+		//@return - false for non-positive dimensions
+		bool Resize(int _width, int _height)
+		{
+			if (_width <= 0 || _height <= 0) {
+				return false;
+			}
+			const size_t newPitch = static_cast<size_t>(_width);
+			const size_t required = newPitch * _height;
+			if (required > capacity) {
+				Release();
+				data = static_cast<T*>(::operator new(required * sizeof(T), std::align_val_t(GRID_ALIGNMENT)));
+				std::uninitialized_default_construct_n(data, required);
+				capacity = required;
+			}
+			width = _width;
+			height = _height;
+			pitch = newPitch;
+			return true;
+		}
+
+		void Release()
+		{
+			if (data) {
+				::operator delete(data, std::align_val_t(GRID_ALIGNMENT));
+			}
+			data = nullptr;
+			width = height = 0;
+			pitch = capacity = 0;
+		}
+
+		T* Data() { return data; }
+		const T* Data() const { return data; }
+		T* Row(int y) { return data + y * pitch; }
+		const T* Row(int y) const { return data + y * pitch; }
+		T& operator()(int x, int y) { return data[y * pitch + x]; }
+		const T& operator()(int x, int y) const { return data[y * pitch + x]; }
+
+		GridView<T> View() { return GridView<T>(data, width, height, pitch); }
+		GridView<const T> View() const { return GridView<const T>(data, width, height, pitch); }
+		GridView<T> SubView(int x, int y, int w, int h) { return View().SubView(x, y, w, h); }
+		GridView<const T> SubView(int x, int y, int w, int h) const { return View().SubView(x, y, w, h); }
+
+		int GetWidth() const { return width; }
+		int GetHeight() const { return height; }
+		size_t GetPitch() const { return pitch; }
+		size_t GetSize() const { return static_cast<size_t>(width) * height; }
+		bool IsEmpty() const { return !data; }
+		//Bytes of the allocated storage, which can be more than the current dimensions need after shrinking
+		size_t GetByteSize() const { return capacity * sizeof(T); }
+		bool IsContiguous() const { return pitch == static_cast<size_t>(width); }
+
+	private:
+		T* data;
+		int width, height;
+		size_t pitch, capacity;
+	};
+}
@@ -0,0 +1,92 @@
+#include "HeightPyramid.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "Parallel.h"
+#include "Trace.h"
+#include "Log.h"
+
+namespace utilities
+{
+	//Quantizes the map and builds all of the mip levels, rows of every level are processed in parallel
+	//@param map - heightmap of width * height values
+	//@param reduction - average or max of the covered texels for the lower levels
+	bool HeightPyramid::Build(const float* map, int width, int height, MipReduction _reduction)
+	{
+		TRACE_ZONE("HeightPyramid::Build");
+		if (!map || width <= 0 || height <= 0) {
+			LOG_ERROR("Invalid heightmap for the height pyramid");
+			return false;
+		}
+		reduction = _reduction;
+
+		auto range = std::minmax_element(map, map + static_cast<size_t>(width) * height);
+		heightMin = *range.first;
+		heightRange = std::max(*range.second - *range.first, 1e-6f);
+
+		int levelCount = 1;
+		while ((std::max(width, height) >> levelCount) > 0) {
+			levelCount++;
+		}
+		levels.resize(levelCount);
+
+		HeightPyramidLevel& base = levels[0];
+		base.width = width;
+		base.height = height;
+		base.texels.resize(static_cast<size_t>(width) * height);
+		const float scale = 65535.0f / heightRange;
+		ParallelFor(0, height, [&](int rowBegin, int rowEnd) {
+			for (int y = rowBegin; y < rowEnd; y++) {
+				for (int x = 0; x < width; x++) {
+					size_t i = static_cast<size_t>(y) * width + x;
+					base.texels[i] = static_cast<unsigned short>(std::clamp((map[i] - heightMin) * scale + 0.5f, 0.0f, 65535.0f));
+				}
+			}
+		});
+
+		for (int level = 1; level < levelCount; level++) {
+			Reduce(levels[level - 1], levels[level]);
+		}
+		return true;
+	}
+
+	//Computes the next level, texel (x, y) covers source texels [2x, 2x + 2) x [2y, 2y + 2),
+	//the last row and column also cover the odd remainder of the source
+	void HeightPyramid::Reduce(const HeightPyramidLevel& source, HeightPyramidLevel& target) const
+	{
+		target.width = std::max(source.width / 2, 1);
+		target.height = std::max(source.height / 2, 1);
+		target.texels.resize(static_cast<size_t>(target.width) * target.height);
+		ParallelFor(0, target.height, [&](int rowBegin, int rowEnd) {
+			for (int y = rowBegin; y < rowEnd; y++) {
+				int y0 = y * 2;
+				int y1 = y == target.height - 1 ? source.height : std::min(y0 + 2, source.height);
+				for (int x = 0; x < target.width; x++) {
+					int x0 = x * 2;
+					int x1 = x == target.width - 1 ? source.width : std::min(x0 + 2, source.width);
+					unsigned int maxValue = 0, sum = 0;
+					for (int sy = y0; sy < y1; sy++) {
+						const unsigned short* row = source.texels.data() + static_cast<size_t>(sy) * source.width;
+						for (int sx = x0; sx < x1; sx++) {
+							maxValue = std::max<unsigned int>(maxValue, row[sx]);
+							sum += row[sx];
+						}
+					}
+					unsigned int count = static_cast<unsigned int>((y1 - y0) * (x1 - x0));
+					target.texels[static_cast<size_t>(y) * target.width + x] = static_cast<unsigned short>(reduction == MipReduction::MAX ? maxValue : (sum + count / 2) / count);
+				}
+			}
+		});
+	}
+
+	size_t HeightPyramid::GetByteSize() const
+	{
+		size_t size = 0;
+		for (const auto& level : levels) {
+			size += level.texels.size() * sizeof(unsigned short);
+		}
+		return size;
+	}
+}
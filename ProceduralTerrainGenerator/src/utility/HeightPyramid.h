@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+//Heightmap quantized to 16 bit unsigned normalized values with a stored range and its mip pyramid built on the CPU.
+//Level 0 has the map size, every next level halves it (rounded down, at least 1) like OpenGL mip levels.
+//Odd rows and columns are folded into the last texel of the next level, so a max pyramid never loses a peak.
+//Levels are uploaded as a GL_R16 texture and stay available for CPU side culling and LOD decisions.
+
+namespace utilities
+{
+	enum class MipReduction {
+		AVERAGE,
+		MAX
+	};
+
+	struct HeightPyramidLevel {
+		int width = 0, height = 0;
+		std::vector<unsigned short> texels;
+	};
+
+	class HeightPyramid
+	{
+	public:
+		bool Build(const float* map, int width, int height, MipReduction reduction);
+
+		//Height in the original units of texel (x, y) of the level
+		float Sample(int level, int x, int y) const
+		{
+			const HeightPyramidLevel& l = levels[level];
+			return heightMin + l.texels[static_cast<size_t>(y) * l.width + x] * (heightRange / 65535.0f);
+		}
+
+		int GetLevelCount() const { return static_cast<int>(levels.size()); }
+		const HeightPyramidLevel& GetLevel(int level) const { return levels[level]; }
+		float GetHeightMin() const { return heightMin; }
+		float GetHeightRange() const { return heightRange; }
+		MipReduction GetReduction() const { return reduction; }
+		size_t GetByteSize() const;
+
+	private:
+		std::vector<HeightPyramidLevel> levels;
+		float heightMin = 0.0f, heightRange = 1.0f;
+		MipReduction reduction = MipReduction::AVERAGE;
+
+		void Reduce(const HeightPyramidLevel& source, HeightPyramidLevel& target) const;
+	};
+}
@@ -0,0 +1,327 @@
+#include "JobSystem.h"
+
+#include <string>
+#include <algorithm>
+
+#include "Trace.h"
+
+namespace utilities
+{
+	namespace {
+		thread_local int currentWorker = -1;
+
+		unsigned long long Elapsed(std::chrono::steady_clock::time_point start)
+		{
+			return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		}
+	}
+
+	int GetCurrentWorkerIndex()
+	{
+		return currentWorker;
+	}
+
+	JobSystem& JobSystem::Get()
+	{
+		static JobSystem instance;
+		return instance;
+	}
+
+	JobSystem::JobSystem()
+	{
+		SetWorkerLimit(0);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		Stop();
+	}
+
+	//Restarts the pool with a new number of threads, has to be called while no jobs are running
+	//@param count - number of threads working on the jobs including the waiting caller, 0 leaves one hardware thread to the caller
+	void JobSystem::SetWorkerLimit(int count)
+	{
+		workerLimit = std::max(0, count);
+		const int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+		const int threads = workerLimit > 0 ? workerLimit : hardwareThreads;
+		Stop();
+		Start(threads - 1);
+	}
+
+	void JobSystem::Start(int count)
+	{
+		stopping = false;
+		workers.clear();
+		for (int i = 0; i < count; i++) {
+			workers.push_back(std::make_unique<Worker>());
+		}
+		for (int i = 0; i < count; i++) {
+			workers[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+		}
+		statsStart = std::chrono::steady_clock::now();
+	}
+
+	void JobSystem::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		finished.notify_all();
+		for (auto& worker : workers) {
+			if (worker->thread.joinable()) {
+				worker->thread.join();
+			}
+		}
+		workers.clear();
+	}
+
+	//Adds a job, it is scheduled once all of the dependencies are finished
+	//@param work - function executed by one of the threads
+	//@param dependencies - jobs which have to finish before this one starts
+	//@param token - the work is skipped if the token is cancelled before the job starts
+	//@return - handle used for waiting and as a dependency of other jobs
+	JobHandle JobSystem::Submit(std::function<void()> work, const std::vector<JobHandle>& dependencies, const CancellationToken& token)
+	{
+		auto job = std::make_shared<Job>();
+		job->work = std::move(work);
+		job->token = token;
+
+		for (const JobHandle& dependency : dependencies) {
+			if (!dependency) {
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(dependency->dependentsMutex);
+			if (!dependency->IsDone()) {
+				job->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+				dependency->dependents.push_back(job);
+			}
+		}
+		if (job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			Schedule(job);
+		}
+		return job;
+	}
+
+	//Pushes a ready job to the deque of the current worker, jobs from other threads are spread over the workers
+	void JobSystem::Schedule(const JobHandle& job)
+	{
+		if (workers.empty()) {
+			Execute(job, -1);
+			return;
+		}
+		const int index = currentWorker >= 0 ? currentWorker : static_cast<int>(nextQueue.fetch_add(1, std::memory_order_relaxed) % workers.size());
+		{
+			std::lock_guard<std::mutex> lock(workers[index]->mutex);
+			workers[index]->jobs.push_back(job);
+		}
+		queuedJobs.fetch_add(1, std::memory_order_release);
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+		//A waiting thread joins the work as well
+		if (waiters.load(std::memory_order_seq_cst) > 0) {
+			finished.notify_one();
+		}
+	}
+
+	//Takes the newest job of the own deque or the oldest job of another deque
+	JobHandle JobSystem::Pop(int index)
+	{
+		if (index >= 0) {
+			Worker& own = *workers[index];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.jobs.empty()) {
+				JobHandle job = std::move(own.jobs.back());
+				own.jobs.pop_back();
+				return job;
+			}
+		}
+		const int count = static_cast<int>(workers.size());
+		const int start = index >= 0 ? index + 1 : static_cast<int>(nextQueue.load(std::memory_order_relaxed));
+		for (int i = 0; i < count; i++) {
+			const int victim = (start + i) % count;
+			if (victim == index) {
+				continue;
+			}
+			Worker& other = *workers[victim];
+			std::lock_guard<std::mutex> lock(other.mutex);
+			if (!other.jobs.empty()) {
+				JobHandle job = std::move(other.jobs.front());
+				other.jobs.pop_front();
+				if (index >= 0) {
+					workers[index]->jobsStolen.fetch_add(1, std::memory_order_relaxed);
+				}
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	bool JobSystem::RunOne(int index)
+	{
+		JobHandle job = Pop(index);
+		if (!job) {
+			return false;
+		}
+		queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		Execute(job, index);
+		return true;
+	}
+
+	void JobSystem::Execute(const JobHandle& job, int index)
+	{
+		if (!job->token.IsCancelled()) {
+			TRACE_ZONE("Job");
+			auto start = std::chrono::steady_clock::now();
+			job->work();
+			if (index >= 0) {
+				workers[index]->busyTime.fetch_add(Elapsed(start), std::memory_order_relaxed);
+			}
+		}
+		if (index >= 0) {
+			workers[index]->jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+		}
+		job->work = nullptr;
+		Finish(job);
+	}
+
+	//Marks the job done and schedules the dependents whose last dependency it was
+	void JobSystem::Finish(const JobHandle& job)
+	{
+		std::vector<JobHandle> dependents;
+		{
+			std::lock_guard<std::mutex> lock(job->dependentsMutex);
+			//Sequentially consistent with the waiter count, either Wait sees the job done or the count is seen below
+			job->done.store(true, std::memory_order_seq_cst);
+			dependents.swap(job->dependents);
+		}
+		for (const JobHandle& dependent : dependents) {
+			if (dependent->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				Schedule(dependent);
+			}
+		}
+		if (waiters.load(std::memory_order_seq_cst) > 0) {
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+			}
+			finished.notify_all();
+		}
+	}
+
+	void JobSystem::WorkerLoop(int index)
+	{
+		currentWorker = index;
+		SetTraceThreadName("Worker " + std::to_string(index));
+		while (!stopping.load(std::memory_order_acquire)) {
+			if (RunOne(index)) {
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this]() { return stopping.load() || queuedJobs.load(std::memory_order_acquire) > 0; });
+		}
+		currentWorker = -1;
+	}
+
+	//Blocks until the job is done, executing other jobs meanwhile
+	void JobSystem::Wait(const JobHandle& job)
+	{
+		while (job && !job->IsDone()) {
+			if (RunOne(currentWorker)) {
+				continue;
+			}
+			waiters.fetch_add(1, std::memory_order_seq_cst);
+			{
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				finished.wait_for(lock, std::chrono::microseconds(200), [&]() { return job->done.load(std::memory_order_seq_cst) || queuedJobs.load(std::memory_order_acquire) > 0; });
+			}
+			waiters.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	void JobSystem::WaitAll(const std::vector<JobHandle>& jobs)
+	{
+		for (const JobHandle& job : jobs) {
+			Wait(job);
+		}
+	}
+
+	//Splits [begin, end) into contiguous chunks of at least grainSize indices and calls body(chunkBegin, chunkEnd) for each of them
+	//There are a few chunks per thread so idle workers can steal the remaining ones, the caller works on the last chunk
+	void JobSystem::ParallelFor(int begin, int end, const std::function<void(int, int)>& body, int grainSize, const CancellationToken& token)
+	{
+		const int count = end - begin;
+		if (count <= 0 || token.IsCancelled()) {
+			return;
+		}
+		const int threads = static_cast<int>(workers.size()) + 1;
+		const int chunkCount = std::clamp(count / std::max(1, grainSize), 1, threads * 4);
+		if (chunkCount == 1) {
+			body(begin, end);
+			return;
+		}
+
+		const int chunkSize = count / chunkCount;
+		const int remainder = count % chunkCount;
+		std::vector<JobHandle> jobs;
+		jobs.reserve(chunkCount - 1);
+		int chunkBegin = begin;
+		for (int i = 0; i < chunkCount - 1; i++) {
+			const int chunkEnd = chunkBegin + chunkSize + (i < remainder ? 1 : 0);
+			jobs.push_back(Submit([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }, {}, token));
+			chunkBegin = chunkEnd;
+		}
+		if (!token.IsCancelled()) {
+			body(chunkBegin, end);
+		}
+		WaitAll(jobs);
+	}
+
+	//Splits the rectangle [x0, x1) x [y0, y1) into tiles and calls body(tileX0, tileX1, tileY0, tileY1) for each of them
+	void JobSystem::ParallelFor2D(int x0, int x1, int y0, int y1, const std::function<void(int, int, int, int)>& body, int tileWidth, int tileHeight,
+		const CancellationToken& token)
+	{
+		if (x1 <= x0 || y1 <= y0) {
+			return;
+		}
+		tileWidth = std::max(1, tileWidth);
+		tileHeight = std::max(1, tileHeight);
+		const int tilesX = (x1 - x0 + tileWidth - 1) / tileWidth;
+		const int tilesY = (y1 - y0 + tileHeight - 1) / tileHeight;
+		ParallelFor(0, tilesX * tilesY, [&](int tileBegin, int tileEnd) {
+			for (int tile = tileBegin; tile < tileEnd; tile++) {
+				if (token.IsCancelled()) {
+					return;
+				}
+				const int tx = x0 + (tile % tilesX) * tileWidth;
+				const int ty = y0 + (tile / tilesX) * tileHeight;
+				body(tx, std::min(tx + tileWidth, x1), ty, std::min(ty + tileHeight, y1));
+			}
+		}, 1, token);
+	}
+
+	std::vector<WorkerStats> JobSystem::GetWorkerStats() const
+	{
+		const unsigned long long total = Elapsed(statsStart);
+		std::vector<WorkerStats> stats(workers.size());
+		for (size_t i = 0; i < workers.size(); i++) {
+			stats[i].jobsExecuted = workers[i]->jobsExecuted.load(std::memory_order_relaxed);
+			stats[i].jobsStolen = workers[i]->jobsStolen.load(std::memory_order_relaxed);
+			stats[i].busyTime = workers[i]->busyTime.load(std::memory_order_relaxed);
+			stats[i].totalTime = total;
+		}
+		return stats;
+	}
+
+	void JobSystem::ResetWorkerStats()
+	{
+		for (auto& worker : workers) {
+			worker->jobsExecuted = 0;
+			worker->jobsStolen = 0;
+			worker->busyTime = 0;
+		}
+		statsStart = std::chrono::steady_clock::now();
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+//Process wide work-stealing job system shared by all of the generation stages.
+//Every worker owns a deque, it pops its own jobs from the back and steals from the front of the other deques when idle.
+//Jobs can depend on other jobs and carry a cancellation token. Threads waiting for a job execute other jobs meanwhile,
+//so jobs may submit and wait for nested work (f.e. a parallel loop inside of a tile job) without deadlocking.
+//By default one hardware thread is left to the calling (UI) thread, which only joins the work while waiting.
+
+namespace utilities
+{
+	//Shared flag checked by jobs and parallel loops, cancelled jobs are skipped but still complete so waiters return
+	class CancellationToken
+	{
+	public:
+		CancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+		void Cancel() { cancelled->store(true, std::memory_order_relaxed); }
+		bool IsCancelled() const { return cancelled->load(std::memory_order_relaxed); }
+	private:
+		std::shared_ptr<std::atomic<bool>> cancelled;
+	};
+
+	struct Job;
+	using JobHandle = std::shared_ptr<Job>;
+
+	struct Job {
+		std::function<void()> work;
+		CancellationToken token;
+		//Number of unfinished dependencies plus one for the job itself being not yet scheduled
+		std::atomic<int> pendingDependencies{ 1 };
+		std::atomic<bool> done{ false };
+		std::mutex dependentsMutex;
+		std::vector<JobHandle> dependents;
+
+		bool IsDone() const { return done.load(std::memory_order_acquire); }
+	};
+
+	//Counters of one worker, times are in nanoseconds
+	//@param busyTime: Time spent executing jobs
+	//@param jobsStolen: Jobs taken from the deque of another worker
+	struct WorkerStats {
+		unsigned long long jobsExecuted = 0;
+		unsigned long long jobsStolen = 0;
+		unsigned long long busyTime = 0;
+		unsigned long long totalTime = 0;
+
+		float GetUtilization() const { return totalTime > 0 ? static_cast<float>(busyTime) / totalTime : 0.0f; }
+	};
+
+	class JobSystem
+	{
+	public:
+		static JobSystem& Get();
+
+		~JobSystem();
+
+		void SetWorkerLimit(int count);
+		int GetWorkerLimit() const { return workerLimit; }
+		int GetWorkerCount() const { return static_cast<int>(workers.size()); }
+
+		JobHandle Submit(std::function<void()> work, const std::vector<JobHandle>& dependencies = {}, const CancellationToken& token = CancellationToken());
+		void Wait(const JobHandle& job);
+		void WaitAll(const std::vector<JobHandle>& jobs);
+
+		void ParallelFor(int begin, int end, const std::function<void(int, int)>& body, int grainSize = 16, const CancellationToken& token = CancellationToken());
+		void ParallelFor2D(int x0, int x1, int y0, int y1, const std::function<void(int, int, int, int)>& body, int tileWidth = 64, int tileHeight = 64,
+			const CancellationToken& token = CancellationToken());
+
+		std::vector<WorkerStats> GetWorkerStats() const;
+		void ResetWorkerStats();
+
+	private:
+		struct Worker {
+			std::thread thread;
+			std::mutex mutex;
+			std::deque<JobHandle> jobs;
+			std::atomic<unsigned long long> jobsExecuted{ 0 }, jobsStolen{ 0 }, busyTime{ 0 };
+		};
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		int workerLimit = 0;
+		std::atomic<bool> stopping{ false };
+		std::atomic<int> queuedJobs{ 0 };
+		std::mutex sleepMutex;
+		//Idle workers sleep on wake, threads inside of Wait sleep on finished, so completed jobs wake only the waiters
+		std::condition_variable wake, finished;
+		std::atomic<int> waiters{ 0 };
+		std::chrono::steady_clock::time_point statsStart;
+		std::atomic<unsigned int> nextQueue{ 0 };
+
+		JobSystem();
+		void Start(int count);
+		void Stop();
+		void WorkerLoop(int index);
+		void Schedule(const JobHandle& job);
+		bool RunOne(int index);
+		JobHandle Pop(int index);
+		void Execute(const JobHandle& job, int index);
+		void Finish(const JobHandle& job);
+	};
+
+	//Index of the job system worker running on the current thread, -1 for threads outside of the pool
+	int GetCurrentWorkerIndex();
+}
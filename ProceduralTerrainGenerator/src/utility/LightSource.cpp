@@ -1,6 +1,7 @@
 #include "LightSource.h"
 
 #include "utilities.h"
+#include "Log.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -56,7 +57,7 @@ void LightSource::Initialize() {
 	layout.Push<float>(3);
 
 	m_VAO->AddBuffer(*m_VertexBuffer, layout);
-	std::cout << "[LOG] Light source initialized" << std::endl;
+	LOG_INFO("Light source initialized");
 }
 
 void LightSource::Draw(Renderer& renderer, glm::mat4& view, glm::mat4& projection) {
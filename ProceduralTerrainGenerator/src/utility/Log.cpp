@@ -0,0 +1,291 @@
+#include "Log.h"
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <iostream>
+#include <algorithm>
+#include <condition_variable>
+
+namespace utilities
+{
+	namespace detail {
+		std::atomic<int> logLevel{ static_cast<int>(LogLevel::INFO) };
+	}
+
+	namespace {
+		//Slots of the queue, a power of two so the index is a mask
+		constexpr uint64_t LOG_QUEUE_CAPACITY = 1 << 12;
+		//Longer messages are cut, the slots keep a fixed size so pushing never allocates
+		constexpr size_t LOG_MESSAGE_SIZE = 240;
+
+		const char* GetLevelTag(LogLevel level)
+		{
+			switch (level) {
+			case LogLevel::DEBUG: return "[DEBUG] ";
+			case LogLevel::INFO: return "[LOG] ";
+			case LogLevel::WARNING: return "[WARNING] ";
+			default: return "[ERROR] ";
+			}
+		}
+
+		//Reused for every message of the thread, so formatting allocates only when a message is longer than any before
+		std::ostringstream& GetLogStream()
+		{
+			thread_local std::ostringstream stream;
+			return stream;
+		}
+
+		uint64_t GetLogTime()
+		{
+			static const auto epoch = std::chrono::steady_clock::now();
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count()) + 1;
+		}
+
+		//Bounded multi-producer queue with a single consumer (D. Vyukov's sequence numbered ring)
+		//A slot is free for the push of index i when its sequence is i, and holds the message of index i when it is i + 1
+		struct LogSlot {
+			std::atomic<uint64_t> sequence{ 0 };
+			LogLevel level = LogLevel::INFO;
+			uint64_t suppressed = 0;
+			uint32_t length = 0;
+			char text[LOG_MESSAGE_SIZE];
+		};
+
+		class Logger
+		{
+		public:
+			static Logger& Get()
+			{
+				//Never destroyed, so threads still logging while statics are torn down do not touch a dead logger
+				//Messages left in the queue are written by the exit handler
+				static Logger* instance = [] {
+					Logger* logger = new Logger();
+					std::atexit([] { FlushLog(); });
+					return logger;
+				}();
+				return *instance;
+			}
+
+			bool Push(LogLevel level, uint64_t suppressed, std::string_view message)
+			{
+				uint64_t index = pushIndex.load(std::memory_order_relaxed);
+				LogSlot* slot;
+				while (true) {
+					slot = &slots[index & (LOG_QUEUE_CAPACITY - 1)];
+					const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+					if (sequence == index) {
+						if (pushIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) {
+							break;
+						}
+					}
+					else if (sequence < index) {
+						dropped.fetch_add(1, std::memory_order_relaxed);
+						return false;
+					}
+					else {
+						index = pushIndex.load(std::memory_order_relaxed);
+					}
+				}
+				slot->level = level;
+				slot->suppressed = suppressed;
+				slot->length = static_cast<uint32_t>(std::min(message.size(), LOG_MESSAGE_SIZE));
+				std::memcpy(slot->text, message.data(), slot->length);
+				slot->sequence.store(index + 1, std::memory_order_release);
+				return true;
+			}
+
+			void Flush()
+			{
+				const uint64_t target = pushIndex.load(std::memory_order_acquire);
+				std::unique_lock<std::mutex> lock(mutex);
+				flushRequested = true;
+				wake.notify_one();
+				flushed.wait(lock, [&] { return written >= target; });
+			}
+
+			uint64_t GetDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+			void SetSink(std::ostream* _sink)
+			{
+				Flush();
+				std::lock_guard<std::mutex> lock(sinkMutex);
+				sink = _sink;
+			}
+
+			void WriteBlock(LogLevel level, const std::string& text)
+			{
+				Flush();
+				std::lock_guard<std::mutex> lock(sinkMutex);
+				if (!sink) {
+					return;
+				}
+				size_t begin = 0;
+				while (begin < text.size()) {
+					size_t end = text.find('\n', begin);
+					if (end == std::string::npos) {
+						end = text.size();
+					}
+					*sink << GetLevelTag(level) << std::string_view(text).substr(begin, end - begin) << '\n';
+					begin = end + 1;
+				}
+				*sink << std::flush;
+			}
+
+			std::ostream* GetSink()
+			{
+				std::lock_guard<std::mutex> lock(sinkMutex);
+				return sink;
+			}
+
+		private:
+			std::unique_ptr<LogSlot[]> slots = std::make_unique<LogSlot[]>(LOG_QUEUE_CAPACITY);
+			std::atomic<uint64_t> pushIndex{ 0 };
+			std::atomic<uint64_t> dropped{ 0 };
+			uint64_t popIndex = 0;
+
+			std::mutex mutex;
+			std::condition_variable wake, flushed;
+			bool flushRequested = false;
+			uint64_t written = 0;
+			std::thread writer;
+			//Held while a batch is written, so the sink is never replaced in the middle of it
+			std::mutex sinkMutex;
+			std::ostream* sink = &std::cout;
+
+			Logger()
+			{
+				for (uint64_t i = 0; i < LOG_QUEUE_CAPACITY; i++) {
+					slots[i].sequence.store(i, std::memory_order_relaxed);
+				}
+				writer = std::thread([this] { WriterLoop(); });
+				writer.detach();
+			}
+
+			//Takes every published message into one batch, stops at a slot which is claimed but not yet written
+			void Drain(std::string& batch)
+			{
+				while (true) {
+					LogSlot& slot = slots[popIndex & (LOG_QUEUE_CAPACITY - 1)];
+					if (slot.sequence.load(std::memory_order_acquire) != popIndex + 1) {
+						return;
+					}
+					batch += GetLevelTag(slot.level);
+					batch.append(slot.text, slot.length);
+					if (slot.length == LOG_MESSAGE_SIZE) {
+						batch += "...";
+					}
+					if (slot.suppressed > 0) {
+						batch += " (" + std::to_string(slot.suppressed) + " similar messages suppressed)";
+					}
+					batch += '\n';
+					slot.sequence.store(popIndex + LOG_QUEUE_CAPACITY, std::memory_order_release);
+					popIndex++;
+				}
+			}
+
+			void WriterLoop()
+			{
+				std::string batch;
+				while (true) {
+					batch.clear();
+					Drain(batch);
+					if (!batch.empty()) {
+						std::lock_guard<std::mutex> sinkLock(sinkMutex);
+						if (sink) {
+							*sink << batch << std::flush;
+						}
+					}
+
+					std::unique_lock<std::mutex> lock(mutex);
+					written = popIndex;
+					if (flushRequested && written >= pushIndex.load(std::memory_order_acquire)) {
+						flushRequested = false;
+					}
+					flushed.notify_all();
+					//A flush waiting for a message which is still being written polls until it is published
+					if (flushRequested) {
+						lock.unlock();
+						std::this_thread::yield();
+					}
+					else {
+						wake.wait_for(lock, std::chrono::milliseconds(20), [&] { return flushRequested; });
+					}
+				}
+			}
+		};
+	}
+
+	void SetLogLevel(LogLevel level)
+	{
+		detail::logLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+	}
+
+	LogLevel GetLogLevel()
+	{
+		return static_cast<LogLevel>(detail::logLevel.load(std::memory_order_relaxed));
+	}
+
+	void FlushLog()
+	{
+		Logger::Get().Flush();
+	}
+
+	uint64_t GetDroppedLogCount()
+	{
+		return Logger::Get().GetDropped();
+	}
+
+	void SetLogSink(std::ostream* sink)
+	{
+		Logger::Get().SetSink(sink);
+	}
+
+	std::ostream* GetLogSink()
+	{
+		return Logger::Get().GetSink();
+	}
+
+	void LogBlock(LogLevel level, const std::string& text)
+	{
+		if (IsLogEnabled(level)) {
+			Logger::Get().WriteBlock(level, text);
+		}
+	}
+
+	bool LogSite::Admit(uint64_t& suppressed)
+	{
+		const uint64_t now = GetLogTime();
+		uint64_t start = windowStart.load(std::memory_order_relaxed);
+		if (now - start >= 1000 && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+			count.store(0, std::memory_order_relaxed);
+			suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+		}
+		if (count.fetch_add(1, std::memory_order_relaxed) < LOG_SITE_BURST) {
+			return true;
+		}
+		suppressedCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	namespace detail {
+		std::ostringstream& BeginLogMessage()
+		{
+			std::ostringstream& stream = GetLogStream();
+			stream.seekp(0);
+			stream.clear();
+			return stream;
+		}
+
+		void EndLogMessage(LogLevel level, uint64_t suppressed)
+		{
+			std::ostringstream& stream = GetLogStream();
+			const std::string_view text = stream.view();
+			Logger::Get().Push(level, suppressed, text.substr(0, static_cast<size_t>(stream.tellp())));
+		}
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <sstream>
+#include <cstdint>
+
+//Levelled asynchronous logger of the generation code.
+//LOG_ERROR("Map of size: " << w << "x" << h << " doesnt match") formats the message on the calling thread and pushes it into
+//a fixed size lock-free queue, a background thread writes the queue to the console in batches with a single flush.
+//A full queue drops the message instead of waiting, so logging never blocks a worker.
+//Levels below TERRAIN_LOG_LEVEL are removed at compile time (debug messages are compiled only without NDEBUG), the rest
+//are filtered at runtime by SetLogLevel before anything is formatted.
+//Every LOG_* statement is rate limited on its own: after LOG_SITE_BURST messages within a second the statement is muted
+//until the next second, whose first message reports how many were suppressed. An error inside of a per-pixel loop
+//therefore prints a few lines instead of millions.
+//The writer thread owns the output, redirect it with SetLogSink instead of swapping the buffer of std::cout.
+
+namespace utilities
+{
+	enum class LogLevel {
+		DEBUG,
+		INFO,
+		WARNING,
+		ERR,
+		NONE
+	};
+}
+
+#ifndef TERRAIN_LOG_LEVEL
+#ifdef NDEBUG
+#define TERRAIN_LOG_LEVEL 1
+#else
+#define TERRAIN_LOG_LEVEL 0
+#endif
+#endif
+
+namespace utilities
+{
+	//Messages a single statement may log per second
+	constexpr uint32_t LOG_SITE_BURST = 8;
+
+	void SetLogLevel(LogLevel level);
+	LogLevel GetLogLevel();
+	//Blocks until every message logged so far is written
+	void FlushLog();
+	//Messages lost because the queue was full
+	uint64_t GetDroppedLogCount();
+	//Stream the writer thread prints to, std::cout by default, nullptr discards the messages
+	//Messages logged before the call are flushed to the previous sink first
+	void SetLogSink(std::ostream* sink);
+	std::ostream* GetLogSink();
+	//Writes a multi-line report, f.e. a dump of a data structure, after the queued messages with every line tagged by the level
+	//The block bypasses the queue, so it is neither cut nor rate limited and its lines stay together
+	void LogBlock(LogLevel level, const std::string& text);
+
+	namespace detail {
+		extern std::atomic<int> logLevel;
+		std::ostringstream& BeginLogMessage();
+		void EndLogMessage(LogLevel level, uint64_t suppressed);
+	}
+
+	inline bool IsLogEnabled(LogLevel level)
+	{
+		return static_cast<int>(level) >= detail::logLevel.load(std::memory_order_relaxed);
+	}
+
+	//Rate limiter of one LOG_* statement
+	class LogSite
+	{
+	public:
+		//@param suppressed - set to the number of messages muted in the previous window when a new window starts
+		//@return - false if the statement already used up its messages in the current second
+		bool Admit(uint64_t& suppressed);
+
+	private:
+		std::atomic<uint64_t> windowStart{ 0 };
+		std::atomic<uint32_t> count{ 0 };
+		std::atomic<uint64_t> suppressedCount{ 0 };
+	};
+}
+
+#define TERRAIN_LOG(level, message) \
+	do { \
+		if constexpr (static_cast<int>(level) >= TERRAIN_LOG_LEVEL) { \
+			if (utilities::IsLogEnabled(level)) { \
+				static utilities::LogSite logSite; \
+				uint64_t logSuppressed = 0; \
+				if (logSite.Admit(logSuppressed)) { \
+					utilities::detail::BeginLogMessage() << message; \
+					utilities::detail::EndLogMessage(level, logSuppressed); \
+				} \
+			} \
+		} \
+	} while (false)
+
+#define LOG_DEBUG(message) TERRAIN_LOG(utilities::LogLevel::DEBUG, message)
+#define LOG_INFO(message) TERRAIN_LOG(utilities::LogLevel::INFO, message)
+#define LOG_WARNING(message) TERRAIN_LOG(utilities::LogLevel::WARNING, message)
+#define LOG_ERROR(message) TERRAIN_LOG(utilities::LogLevel::ERR, message)
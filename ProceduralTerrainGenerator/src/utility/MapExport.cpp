@@ -0,0 +1,56 @@
+#include "MapExport.h"
+
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <algorithm>
+
+namespace utilities
+{
+	//Writes a binary 16 bit PGM, heights are clamped to [0, 1]
+	bool WriteHeightPgm(const std::string& path, const float* map, int width, int height)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+		file << "P5\n" << width << " " << height << "\n65535\n";
+		std::vector<unsigned char> row(static_cast<size_t>(width) * 2);
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				uint16_t value = static_cast<uint16_t>(std::clamp(map[static_cast<size_t>(y) * width + x], 0.0f, 1.0f) * 65535.0f + 0.5f);
+				row[x * 2] = static_cast<unsigned char>(value >> 8);
+				row[x * 2 + 1] = static_cast<unsigned char>(value & 0xFF);
+			}
+			file.write(reinterpret_cast<const char*>(row.data()), row.size());
+		}
+		return file.good();
+	}
+
+	//Writes the heights as they are, little endian 32 bit floats row by row
+	bool WriteHeightRaw(const std::string& path, const float* map, int width, int height)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(map), static_cast<std::streamsize>(width) * height * sizeof(float));
+		return file.good();
+	}
+
+	//Writes biome ids as an 8 bit PGM, ids are clamped to [0, 255]
+	bool WriteBiomePgm(const std::string& path, const int* biomeMap, int width, int height)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+		file << "P5\n" << width << " " << height << "\n255\n";
+		std::vector<unsigned char> pixels(static_cast<size_t>(width) * height);
+		for (size_t i = 0; i < pixels.size(); i++) {
+			pixels[i] = static_cast<unsigned char>(std::clamp(biomeMap[i], 0, 255));
+		}
+		file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+		return file.good();
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+//Writers of generated maps used by the headless tools, files are written without any image library
+//Binary PGM is read by most image tools and terrain editors, raw files hold the exact values
+
+namespace utilities
+{
+	bool WriteHeightPgm(const std::string& path, const float* map, int width, int height);
+	bool WriteHeightRaw(const std::string& path, const float* map, int width, int height);
+	bool WriteBiomePgm(const std::string& path, const int* biomeMap, int width, int height);
+}
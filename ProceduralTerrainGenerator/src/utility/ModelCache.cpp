@@ -0,0 +1,359 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+
+#include "ModelCache.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include "ObjLoader/tiny_obj_loader.h"
+#include "Log.h"
+
+//Vertex clustering grid resolution of each LOD tier, 0 means the original mesh
+static const int lodGridResolution[ModelCache::LOD_COUNT] = { 0, 16, 6 };
+
+ModelCache::ModelCache()
+{
+}
+
+ModelCache::~ModelCache()
+{
+	utilities::JobSystem::Get().WaitAll(loaders);
+}
+
+//Registers a model to be loaded, every path is loaded only once
+//@param path - path to the OBJ file
+//@return - id of the model used by AddInstance
+int ModelCache::Request(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(modelsMutex);
+	auto it = modelIds.find(path);
+	if (it != modelIds.end()) {
+		return it->second;
+	}
+	int id = static_cast<int>(models.size());
+	models.push_back(std::make_unique<Model>());
+	models.back()->path = path;
+	modelIds[path] = id;
+	return id;
+}
+
+//Starts parsing all queued models on the job system, one job per model
+//Previously started loading is waited for, so every model is parsed exactly once
+void ModelCache::LoadAsync()
+{
+	utilities::JobSystem::Get().WaitAll(loaders);
+	loaders.clear();
+
+	std::vector<Model*> queued;
+	{
+		std::lock_guard<std::mutex> lock(modelsMutex);
+		for (auto& model : models) {
+			if (model->state == ModelState::QUEUED) {
+				queued.push_back(model.get());
+			}
+		}
+	}
+	for (Model* model : queued) {
+		loaders.push_back(utilities::JobSystem::Get().Submit([model]() { ParseModel(*model); }));
+	}
+}
+
+//Background part of the loading: parsing and LOD generation, no OpenGL calls allowed here
+void ModelCache::ParseModel(Model& model)
+{
+	MeshData mesh;
+	if (!LoadObjFile(model.path, mesh)) {
+		model.state = ModelState::FAILED;
+		return;
+	}
+	for (int lod = 1; lod < LOD_COUNT; lod++) {
+		model.lods[lod] = SimplifyMesh(mesh, lodGridResolution[lod]);
+	}
+	//Simplified tiers only move vertices inside of the original extent, so the full mesh bounds every LOD
+	ModelBounds bounds;
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		const glm::vec3& p = mesh.vertices[i].position;
+		bounds.radius = std::max(bounds.radius, std::sqrt(p.x * p.x + p.z * p.z));
+		bounds.minY = i == 0 ? p.y : std::min(bounds.minY, p.y);
+		bounds.maxY = i == 0 ? p.y : std::max(bounds.maxY, p.y);
+	}
+	model.bounds = bounds;
+	model.lods[0] = std::move(mesh);
+	model.state = ModelState::PARSED;
+}
+
+//Creates OpenGL buffers for models parsed since the last call, has to be called from the thread owning the context
+//@return - true if any model was uploaded
+bool ModelCache::UploadPending()
+{
+	bool uploaded = false;
+	std::lock_guard<std::mutex> lock(modelsMutex);
+	for (auto& model : models) {
+		if (model->state != ModelState::PARSED) {
+			continue;
+		}
+
+		VertexBufferLayout vertexLayout;
+		vertexLayout.Push<float>(3);
+		vertexLayout.Push<float>(3);
+		vertexLayout.Push<float>(2);
+		VertexBufferLayout instanceLayout = GetInstanceLayout();
+
+		for (int lod = 0; lod < LOD_COUNT; lod++) {
+			MeshData& mesh = model->lods[lod];
+			GpuMesh& gpu = model->gpu[lod];
+			gpu.vao = std::make_unique<VertexArray>();
+			gpu.vertexBuffer = std::make_unique<VertexBuffer>(mesh.vertices.data(), static_cast<unsigned int>(mesh.vertices.size() * sizeof(ModelVertex)));
+			gpu.indexBuffer = std::make_unique<IndexBuffer>(mesh.indices.data(), static_cast<unsigned int>(mesh.indices.size()));
+			gpu.instanceBuffer = std::make_unique<StreamingVertexBuffer>(static_cast<unsigned int>(sizeof(ModelInstance)), 256);
+			gpu.vao->AddBuffer(*gpu.vertexBuffer, vertexLayout);
+			gpu.vao->AddInstanceBuffer(*gpu.instanceBuffer, instanceLayout, 3);
+			gpu.vao->Unbind();
+
+			//CPU copy is not needed anymore
+			mesh = MeshData();
+		}
+		model->state = ModelState::UPLOADED;
+		uploaded = true;
+		LOG_INFO("Model: " << model->path << " uploaded with " << LOD_COUNT << " LODs");
+	}
+	return uploaded;
+}
+
+//Removes all instances from the buckets, capacity is kept for the next frame
+void ModelCache::ClearInstances()
+{
+	for (auto& model : models) {
+		for (auto& bucket : model->buckets) {
+			bucket.clear();
+		}
+	}
+}
+
+//Puts an instance into the bucket of the LOD selected by its distance from the camera
+//@param modelId - id returned by Request
+//@param instance - instance attributes
+//@param distance - distance from the camera in world units
+void ModelCache::AddInstance(int modelId, const ModelInstance& instance, float distance)
+{
+	if (modelId < 0 || modelId >= static_cast<int>(models.size())) {
+		return;
+	}
+	int lod = 0;
+	while (lod < LOD_COUNT - 1 && distance >= lodDistances[lod]) {
+		lod++;
+	}
+	models[modelId]->buckets[lod].push_back(instance);
+}
+
+//Layout of ModelInstance in the instance buffers, attributes start at location 3
+VertexBufferLayout ModelCache::GetInstanceLayout()
+{
+	VertexBufferLayout instanceLayout;
+	instanceLayout.Push<float>(3);
+	instanceLayout.Push<float>(1);
+	instanceLayout.Push<float>(1);
+	return instanceLayout;
+}
+
+//Writes instance buckets into the streaming instance buffers and issues one instanced draw call per model and LOD
+//@param renderer - renderer used to issue the draw calls
+//@param shader - instancing shader with view, projection and model uniforms already set
+void ModelCache::Draw(Renderer& renderer, Shader& shader)
+{
+	for (auto& model : models) {
+		if (model->state != ModelState::UPLOADED) {
+			continue;
+		}
+		for (int lod = 0; lod < LOD_COUNT; lod++) {
+			std::vector<ModelInstance>& bucket = model->buckets[lod];
+			GpuMesh& gpu = model->gpu[lod];
+			if (bucket.empty() || gpu.indexBuffer->GetCount() == 0) {
+				continue;
+			}
+			unsigned int count = static_cast<unsigned int>(bucket.size());
+			if (gpu.instanceBuffer->Reserve(count)) {
+				gpu.vao->AddInstanceBuffer(*gpu.instanceBuffer, GetInstanceLayout(), 3);
+			}
+			unsigned int baseInstance = gpu.instanceBuffer->Write(bucket.data(), count);
+			renderer.DrawTrianglesInstanced(*gpu.vao, *gpu.indexBuffer, shader, static_cast<int>(count), baseInstance);
+			gpu.instanceBuffer->EndFrame();
+		}
+	}
+}
+
+bool ModelCache::IsReady(int modelId) const
+{
+	return modelId >= 0 && modelId < static_cast<int>(models.size()) && models[modelId]->state == ModelState::UPLOADED;
+}
+
+size_t ModelCache::GetInstanceCount(int modelId, int lod) const
+{
+	if (modelId < 0 || modelId >= static_cast<int>(models.size()) || lod < 0 || lod >= LOD_COUNT) {
+		return 0;
+	}
+	return models[modelId]->buckets[lod].size();
+}
+
+//@return - bounds of the model, empty until it is parsed
+ModelBounds ModelCache::GetBounds(int modelId) const
+{
+	if (modelId < 0 || modelId >= static_cast<int>(models.size())) {
+		return ModelBounds();
+	}
+	const ModelState state = models[modelId]->state;
+	return state == ModelState::PARSED || state == ModelState::UPLOADED ? models[modelId]->bounds : ModelBounds();
+}
+
+size_t ModelCache::GetTriangleCount(int modelId, int lod) const
+{
+	if (!IsReady(modelId) || lod < 0 || lod >= LOD_COUNT) {
+		return 0;
+	}
+	return models[modelId]->gpu[lod].indexBuffer->GetCount() / 3;
+}
+
+//Loads an OBJ file into an interleaved mesh, vertices sharing position, normal and texture coordinate indices are merged
+//Smooth normals are computed if the file does not provide them
+//@param path - path to the OBJ file
+//@param mesh - output mesh
+bool ModelCache::LoadObjFile(const std::string& path, MeshData& mesh)
+{
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str())) {
+		LOG_ERROR("Couldnt load model: " << path << " " << err);
+		return false;
+	}
+
+	std::unordered_map<uint64_t, unsigned int> uniqueVertices;
+	bool hasNormals = !attrib.normals.empty();
+
+	for (const auto& shape : shapes) {
+		for (const auto& index : shape.mesh.indices) {
+			//Indices are packed into 21 bits each, -1 (missing) becomes the all ones value
+			uint64_t key = (static_cast<uint64_t>(index.vertex_index & 0x1FFFFF) << 42) |
+				(static_cast<uint64_t>(index.normal_index & 0x1FFFFF) << 21) |
+				static_cast<uint64_t>(index.texcoord_index & 0x1FFFFF);
+
+			auto it = uniqueVertices.find(key);
+			if (it != uniqueVertices.end()) {
+				mesh.indices.push_back(it->second);
+				continue;
+			}
+
+			ModelVertex vertex{};
+			vertex.position = glm::vec3(attrib.vertices[3 * index.vertex_index],
+				attrib.vertices[3 * index.vertex_index + 1],
+				attrib.vertices[3 * index.vertex_index + 2]);
+			if (index.normal_index >= 0) {
+				vertex.normal = glm::vec3(attrib.normals[3 * index.normal_index],
+					attrib.normals[3 * index.normal_index + 1],
+					attrib.normals[3 * index.normal_index + 2]);
+			}
+			if (index.texcoord_index >= 0) {
+				vertex.texCoord = glm::vec2(attrib.texcoords[2 * index.texcoord_index],
+					attrib.texcoords[2 * index.texcoord_index + 1]);
+			}
+
+			unsigned int newIndex = static_cast<unsigned int>(mesh.vertices.size());
+			uniqueVertices[key] = newIndex;
+			mesh.vertices.push_back(vertex);
+			mesh.indices.push_back(newIndex);
+		}
+	}
+
+	if (!hasNormals) {
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			ModelVertex& a = mesh.vertices[mesh.indices[i]];
+			ModelVertex& b = mesh.vertices[mesh.indices[i + 1]];
+			ModelVertex& c = mesh.vertices[mesh.indices[i + 2]];
+			glm::vec3 faceNormal = glm::cross(b.position - a.position, c.position - a.position);
+			a.normal += faceNormal;
+			b.normal += faceNormal;
+			c.normal += faceNormal;
+		}
+		for (auto& vertex : mesh.vertices) {
+			float length = glm::length(vertex.normal);
+			vertex.normal = length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		}
+	}
+
+	LOG_INFO("Model: " << path << " loaded, vertices: " << mesh.vertices.size() << " triangles: " << mesh.indices.size() / 3);
+	return !mesh.indices.empty();
+}
+
+//Simplifies the mesh by vertex clustering: vertices falling into the same cell of a uniform grid
+//are merged into their average and triangles collapsed by the merge are dropped
+//@param mesh - mesh to be simplified
+//@param gridResolution - number of cells along the longest side of the bounding box
+MeshData ModelCache::SimplifyMesh(const MeshData& mesh, int gridResolution)
+{
+	if (gridResolution <= 0 || mesh.vertices.empty()) {
+		return mesh;
+	}
+
+	glm::vec3 bmin = mesh.vertices[0].position, bmax = mesh.vertices[0].position;
+	for (const auto& vertex : mesh.vertices) {
+		bmin = glm::min(bmin, vertex.position);
+		bmax = glm::max(bmax, vertex.position);
+	}
+	glm::vec3 extent = bmax - bmin;
+	float cellSize = std::max({ extent.x, extent.y, extent.z, 1e-6f }) / gridResolution;
+
+	struct Cluster {
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		glm::vec2 texCoord = glm::vec2(0.0f);
+		int count = 0;
+	};
+
+	std::unordered_map<uint64_t, unsigned int> clusterIds;
+	std::vector<Cluster> clusters;
+	std::vector<unsigned int> remap(mesh.vertices.size());
+
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		glm::ivec3 cell = glm::ivec3((mesh.vertices[i].position - bmin) / cellSize);
+		uint64_t key = (static_cast<uint64_t>(cell.x & 0x1FFFFF) << 42) | (static_cast<uint64_t>(cell.y & 0x1FFFFF) << 21) | static_cast<uint64_t>(cell.z & 0x1FFFFF);
+		auto it = clusterIds.find(key);
+		unsigned int id;
+		if (it == clusterIds.end()) {
+			id = static_cast<unsigned int>(clusters.size());
+			clusterIds[key] = id;
+			clusters.emplace_back();
+		}
+		else {
+			id = it->second;
+		}
+		clusters[id].position += mesh.vertices[i].position;
+		clusters[id].normal += mesh.vertices[i].normal;
+		clusters[id].texCoord += mesh.vertices[i].texCoord;
+		clusters[id].count++;
+		remap[i] = id;
+	}
+
+	MeshData simplified;
+	simplified.vertices.reserve(clusters.size());
+	for (const auto& cluster : clusters) {
+		ModelVertex vertex;
+		vertex.position = cluster.position / static_cast<float>(cluster.count);
+		float length = glm::length(cluster.normal);
+		vertex.normal = length > 0.0f ? cluster.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		vertex.texCoord = cluster.texCoord / static_cast<float>(cluster.count);
+		simplified.vertices.push_back(vertex);
+	}
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+		unsigned int a = remap[mesh.indices[i]], b = remap[mesh.indices[i + 1]], c = remap[mesh.indices[i + 2]];
+		if (a == b || b == c || a == c) {
+			continue;
+		}
+		simplified.indices.push_back(a);
+		simplified.indices.push_back(b);
+		simplified.indices.push_back(c);
+	}
+	return simplified;
+}
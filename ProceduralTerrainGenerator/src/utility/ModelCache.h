@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "glm/glm.hpp"
+#include "VertexBufferLayout.h"
+#include "StreamingVertexBuffer.h"
+#include "JobSystem.h"
+
+//Cache of instanced models (trees, bushes, rocks) loaded from OBJ files.
+//Every file is parsed once on the job system into an interleaved, index-deduplicated mesh and simplified
+//into LOD tiers by vertex clustering. GPU buffers are created on the main thread, instances are sorted into
+//per model, per LOD buckets so every bucket is drawn with a single instanced draw call.
+
+//Interleaved vertex of a cached model
+struct ModelVertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texCoord;
+};
+
+//Per instance attributes uploaded to the instance buffer
+struct ModelInstance {
+	glm::vec3 position;
+	float scale;
+	float rotation;
+};
+
+//Extent of a model around its origin, radius is measured on the XZ plane so it holds for any rotation around Y
+struct ModelBounds {
+	float radius = 0.0f;
+	float minY = 0.0f, maxY = 0.0f;
+};
+
+//CPU side mesh of one level of detail
+struct MeshData {
+	std::vector<ModelVertex> vertices;
+	std::vector<unsigned int> indices;
+};
+
+class ModelCache
+{
+public:
+	static constexpr int LOD_COUNT = 3;
+
+	ModelCache();
+	~ModelCache();
+
+	int Request(const std::string& path);
+	void LoadAsync();
+	bool UploadPending();
+
+	void ClearInstances();
+	void AddInstance(int modelId, const ModelInstance& instance, float distance);
+	void Draw(Renderer& renderer, Shader& shader);
+
+	void SetLodDistances(float lod1, float lod2) { lodDistances = { lod1, lod2 }; }
+	bool IsReady(int modelId) const;
+	size_t GetInstanceCount(int modelId, int lod) const;
+	size_t GetTriangleCount(int modelId, int lod) const;
+	ModelBounds GetBounds(int modelId) const;
+
+	static bool LoadObjFile(const std::string& path, MeshData& mesh);
+	static MeshData SimplifyMesh(const MeshData& mesh, int gridResolution);
+
+private:
+	enum class ModelState {
+		QUEUED,
+		PARSED,
+		UPLOADED,
+		FAILED
+	};
+
+	struct GpuMesh {
+		std::unique_ptr<VertexArray> vao;
+		std::unique_ptr<VertexBuffer> vertexBuffer;
+		std::unique_ptr<IndexBuffer> indexBuffer;
+		std::unique_ptr<StreamingVertexBuffer> instanceBuffer;
+	};
+
+	struct Model {
+		std::string path;
+		std::atomic<ModelState> state{ ModelState::QUEUED };
+		std::array<MeshData, LOD_COUNT> lods;
+		ModelBounds bounds;
+		std::array<GpuMesh, LOD_COUNT> gpu;
+		std::array<std::vector<ModelInstance>, LOD_COUNT> buckets;
+	};
+
+	std::vector<std::unique_ptr<Model>> models;
+	std::unordered_map<std::string, int> modelIds;
+	std::vector<utilities::JobHandle> loaders;
+	std::mutex modelsMutex;
+	std::array<float, LOD_COUNT - 1> lodDistances = { 150.0f, 400.0f };
+
+	static void ParseModel(Model& model);
+	static VertexBufferLayout GetInstanceLayout();
+};
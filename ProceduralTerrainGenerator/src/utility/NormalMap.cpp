@@ -0,0 +1,272 @@
+#include "NormalMap.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NORMAL_MAP_SSE
+#endif
+
+#include "Parallel.h"
+#include "Trace.h"
+
+namespace utilities
+{
+	//Writes normalize(-gx, 1, -gz) into the strided output
+	static inline void StoreNormal(float* out, float gx, float gz)
+	{
+		float invLength = 1.0f / std::sqrt(gx * gx + gz * gz + 1.0f);
+		out[0] = -gx * invLength;
+		out[1] = invLength;
+		out[2] = -gz * invLength;
+	}
+
+	//Interior of a single row: x in [1, width - 1), rows above and below always exist
+	static void NormalRowInterior(const float* up, const float* row, const float* down, int width, float halfScale, float* normals, unsigned int stride)
+	{
+		int x = 1;
+#ifdef NORMAL_MAP_SSE
+		const __m128 scale = _mm_set1_ps(halfScale);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		alignas(16) float nx[4], ny[4], nz[4];
+		for (; x + 4 <= width - 1; x += 4) {
+			__m128 gx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row + x + 1), _mm_loadu_ps(row + x - 1)), scale);
+			__m128 gz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(down + x), _mm_loadu_ps(up + x)), scale);
+			__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gz, gz)), one);
+			__m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+			_mm_store_ps(nx, _mm_xor_ps(_mm_mul_ps(gx, invLength), signMask));
+			_mm_store_ps(ny, invLength);
+			_mm_store_ps(nz, _mm_xor_ps(_mm_mul_ps(gz, invLength), signMask));
+			for (int k = 0; k < 4; k++) {
+				float* out = normals + static_cast<size_t>(x + k) * stride;
+				out[0] = nx[k];
+				out[1] = ny[k];
+				out[2] = nz[k];
+			}
+		}
+#endif
+		for (; x < width - 1; x++) {
+			StoreNormal(normals + static_cast<size_t>(x) * stride, (row[x + 1] - row[x - 1]) * halfScale, (down[x] - up[x]) * halfScale);
+		}
+	}
+
+	//Calculates normals of the whole height map
+	//@param heightMap - contiguous height map of size width * height
+	//@param width - width of the height map
+	//@param height - height of the height map
+	//@param heightScale - scale applied to the heights, horizontal spacing of the points is 1
+	//@param normals - output array, normal of the point i is written at normals[i * stride + offset]
+	//@param stride - number of floats per output element (3 for a standalone normal map)
+	//@param offset - offset of the normal inside of the output element
+	bool CalculateNormalMap(const float* heightMap, int width, int height, float heightScale, float* normals, unsigned int stride, unsigned int offset)
+	{
+		TRACE_ZONE("CalculateNormalMap");
+		if (!heightMap || !normals || width <= 0 || height <= 0 || stride < 3) {
+			return false;
+		}
+		const float halfScale = 0.5f * heightScale;
+		float* base = normals + offset;
+
+		ParallelFor(1, height - 1, [&](int bandBegin, int bandEnd) {
+			for (int z = bandBegin; z < bandEnd; z++) {
+				const float* row = heightMap + static_cast<size_t>(z) * width;
+				NormalRowInterior(row - width, row, row + width, width, halfScale, base + static_cast<size_t>(z) * width * stride, stride);
+			}
+		}, 32);
+
+		CalculateNormalMapBorders(heightMap, width, height, heightScale, normals, stride, offset);
+		return true;
+	}
+
+	//Normal of a point on the border of the map, differences are one-sided on the edges
+	static void StoreBorderNormal(const float* heightMap, int width, int height, float heightScale, int x, int z, float* out)
+	{
+		auto slope = [&](int x0, int z0, int x1, int z1) {
+			int steps = std::max(x1 - x0, z1 - z0);
+			return steps > 0 ? (heightMap[z1 * width + x1] - heightMap[z0 * width + x0]) * heightScale / steps : 0.0f;
+		};
+		float gx = slope(std::max(x - 1, 0), z, std::min(x + 1, width - 1), z);
+		float gz = slope(x, std::max(z - 1, 0), x, std::min(z + 1, height - 1));
+		StoreNormal(out, gx, gz);
+	}
+
+	//Calculates normals of the first and last row and column with one-sided differences on the edges
+	void CalculateNormalMapBorders(const float* heightMap, int width, int height, float heightScale, float* normals, unsigned int stride, unsigned int offset)
+	{
+		auto border = [&](int x, int z) {
+			StoreBorderNormal(heightMap, width, height, heightScale, x, z, normals + (static_cast<size_t>(z) * width + x) * stride + offset);
+		};
+
+		for (int x = 0; x < width; x++) {
+			border(x, 0);
+			if (height > 1) {
+				border(x, height - 1);
+			}
+		}
+		for (int z = 1; z < height - 1; z++) {
+			border(0, z);
+			if (width > 1) {
+				border(width - 1, z);
+			}
+		}
+	}
+
+	//Calculates normals of a single row with the same differences as CalculateNormalMap, so a consumer can convert
+	//the normals band by band without a normal map of the whole height map
+	//@param z - row of the height map
+	//@param normals - output of the row, normal of the point x is written at normals[x * stride + offset]
+	void CalculateNormalRow(const float* heightMap, int width, int height, int z, float heightScale, float* normals, unsigned int stride, unsigned int offset)
+	{
+		if (!heightMap || !normals || z < 0 || z >= height || width <= 0 || stride < 3) {
+			return;
+		}
+		float* base = normals + offset;
+		if (z == 0 || z == height - 1 || width < 3) {
+			for (int x = 0; x < width; x++) {
+				StoreBorderNormal(heightMap, width, height, heightScale, x, z, base + static_cast<size_t>(x) * stride);
+			}
+			return;
+		}
+		const float* row = heightMap + static_cast<size_t>(z) * width;
+		NormalRowInterior(row - width, row, row + width, width, 0.5f * heightScale, base, stride);
+		StoreBorderNormal(heightMap, width, height, heightScale, 0, z, base);
+		StoreBorderNormal(heightMap, width, height, heightScale, width - 1, z, base + static_cast<size_t>(width - 1) * stride);
+	}
+
+	//Octahedral encoding of a unit vector into [-1, 1]^2
+	glm::vec2 OctEncode(glm::vec3 n)
+	{
+		n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+		glm::vec2 e(n.x, n.z);
+		if (n.y < 0.0f) {
+			e = glm::vec2((1.0f - std::abs(n.z)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(n.x)) * (n.z >= 0.0f ? 1.0f : -1.0f));
+		}
+		return e;
+	}
+
+	//Inverse of OctEncode, same as the decoding in the compact terrain vertex shader
+	glm::vec3 OctDecode(glm::vec2 e)
+	{
+		glm::vec3 n(e.x, 1.0f - std::abs(e.x) - std::abs(e.y), e.y);
+		if (n.y < 0.0f) {
+			float x = n.x;
+			n.x = (1.0f - std::abs(n.z)) * (x >= 0.0f ? 1.0f : -1.0f);
+			n.z = (1.0f - std::abs(x)) * (n.z >= 0.0f ? 1.0f : -1.0f);
+		}
+		return glm::normalize(n);
+	}
+
+	//Bounding rectangle of the texels which differ between two maps of the same size
+	TexelRegion FindChangedRegion(const float* before, const float* after, int width, int height)
+	{
+		int x0 = width, y0 = height, x1 = -1, y1 = -1;
+		for (int y = 0; y < height; y++) {
+			const float* a = before + static_cast<size_t>(y) * width;
+			const float* b = after + static_cast<size_t>(y) * width;
+			for (int x = 0; x < width; x++) {
+				if (a[x] != b[x]) {
+					x0 = std::min(x0, x);
+					x1 = std::max(x1, x);
+					y0 = std::min(y0, y);
+					y1 = y;
+				}
+			}
+		}
+		if (x1 < 0) {
+			return TexelRegion();
+		}
+		return TexelRegion{ x0, y0, x1 - x0 + 1, y1 - y0 + 1 };
+	}
+
+	//Encodes normals of the whole height map and marks the whole map dirty
+	//@param slopeScale - scale of the height differences between neighbouring texels (heightScale * width gives
+	//the normals of the tessellated terrain, which measures the slope per texture coordinate unit)
+	bool OctNormalMap::Build(const float* heightMap, int _width, int _height, float _slopeScale)
+	{
+		TRACE_ZONE("OctNormalMap::Build");
+		if (!heightMap || _width <= 0 || _height <= 0) {
+			return false;
+		}
+		width = _width;
+		height = _height;
+		slopeScale = _slopeScale;
+		texels.resize(static_cast<size_t>(width) * height * 2);
+
+		std::vector<float> normals(static_cast<size_t>(width) * height * 3);
+		CalculateNormalMap(heightMap, width, height, slopeScale, normals.data(), 3, 0);
+		ParallelFor(0, height, [&](int rowBegin, int rowEnd) {
+			for (size_t i = static_cast<size_t>(rowBegin) * width; i < static_cast<size_t>(rowEnd) * width; i++) {
+				Encode(i, glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]));
+			}
+		}, 32);
+
+		dirty = TexelRegion{ 0, 0, width, height };
+		return true;
+	}
+
+	//Re-encodes normals after a change of the height map inside of the region, the region grows by one texel
+	//on every side because the neighbours use the changed heights in their differences
+	//@param heightMap - whole height map of the same size as the normal map
+	bool OctNormalMap::Update(const float* heightMap, int x, int y, int regionWidth, int regionHeight)
+	{
+		if (!heightMap || texels.empty()) {
+			return false;
+		}
+		TexelRegion region;
+		region.x = std::max(x - 1, 0);
+		region.y = std::max(y - 1, 0);
+		region.width = std::min(x + regionWidth + 1, width) - region.x;
+		region.height = std::min(y + regionHeight + 1, height) - region.y;
+		if (region.IsEmpty()) {
+			return false;
+		}
+
+		//Same differences as CalculateNormalMap: central inside of the map, one-sided on the borders
+		auto sample = [&](int sx, int sz) { return heightMap[static_cast<size_t>(sz) * width + sx]; };
+		ParallelFor(region.y, region.y + region.height, [&](int rowBegin, int rowEnd) {
+			for (int z = rowBegin; z < rowEnd; z++) {
+				int z0 = std::max(z - 1, 0), z1 = std::min(z + 1, height - 1);
+				for (int px = region.x; px < region.x + region.width; px++) {
+					int x0 = std::max(px - 1, 0), x1 = std::min(px + 1, width - 1);
+					float gx = x1 > x0 ? (sample(x1, z) - sample(x0, z)) * slopeScale / (x1 - x0) : 0.0f;
+					float gz = z1 > z0 ? (sample(px, z1) - sample(px, z0)) * slopeScale / (z1 - z0) : 0.0f;
+					Encode(static_cast<size_t>(z) * width + px, glm::normalize(glm::vec3(-gx, 1.0f, -gz)));
+				}
+			}
+		}, 32);
+
+		MarkDirty(region);
+		return true;
+	}
+
+	//Returns the region changed since the last call and clears it
+	TexelRegion OctNormalMap::TakeDirtyRegion()
+	{
+		TexelRegion region = dirty;
+		dirty = TexelRegion();
+		return region;
+	}
+
+	void OctNormalMap::Encode(size_t index, glm::vec3 normal)
+	{
+		glm::vec2 e = OctEncode(normal);
+		texels[index * 2] = static_cast<int16_t>(std::round(std::clamp(e.x, -1.0f, 1.0f) * 32767.0f));
+		texels[index * 2 + 1] = static_cast<int16_t>(std::round(std::clamp(e.y, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	void OctNormalMap::MarkDirty(const TexelRegion& region)
+	{
+		if (dirty.IsEmpty()) {
+			dirty = region;
+			return;
+		}
+		int x1 = std::max(dirty.x + dirty.width, region.x + region.width);
+		int y1 = std::max(dirty.y + dirty.height, region.y + region.height);
+		dirty.x = std::min(dirty.x, region.x);
+		dirty.y = std::min(dirty.y, region.y);
+		dirty.width = x1 - dirty.x;
+		dirty.height = y1 - dirty.y;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace utilities
+{
+	//Normal generation from a contiguous height map, normal of a point is normalize(-dh/dx, 1, -dh/dz)
+	//with central differences inside of the map and one-sided differences on the borders.
+	//Interior is processed with SSE in parallel row bands, border rows and columns in a separate scalar pass.
+	//Output is strided, so the same kernel fills an interleaved vertex buffer or a compact normal map (stride 3).
+
+	bool CalculateNormalMap(const float* heightMap, int width, int height, float heightScale, float* normals, unsigned int stride, unsigned int offset);
+	void CalculateNormalMapBorders(const float* heightMap, int width, int height, float heightScale, float* normals, unsigned int stride, unsigned int offset);
+	void CalculateNormalRow(const float* heightMap, int width, int height, int z, float heightScale, float* normals, unsigned int stride, unsigned int offset);
+
+	glm::vec2 OctEncode(glm::vec3 n);
+	glm::vec3 OctDecode(glm::vec2 e);
+
+	//Rectangle of texels, empty when width or height is 0
+	struct TexelRegion {
+		int x = 0, y = 0, width = 0, height = 0;
+		bool IsEmpty() const { return width <= 0 || height <= 0; }
+	};
+
+	TexelRegion FindChangedRegion(const float* before, const float* after, int width, int height);
+
+	//Normal map of a height map with normals octahedral encoded into pairs of signed 16-bit values (RG16_SNORM texture).
+	//Changed parts of the height map are re-encoded with Update and collected into a dirty region,
+	//which the texture upload takes, so only the changed texels reach the GPU.
+	class OctNormalMap
+	{
+	public:
+		bool Build(const float* heightMap, int _width, int _height, float _slopeScale);
+		bool Update(const float* heightMap, int x, int y, int regionWidth, int regionHeight);
+		TexelRegion TakeDirtyRegion();
+
+		const int16_t* GetData() const { return texels.data(); }
+		int GetWidth() const { return width; }
+		int GetHeight() const { return height; }
+		float GetSlopeScale() const { return slopeScale; }
+		bool IsBuilt() const { return !texels.empty(); }
+		size_t GetByteSize() const { return texels.capacity() * sizeof(int16_t); }
+
+	private:
+		std::vector<int16_t> texels;
+		int width = 0, height = 0;
+		float slopeScale = 1.0f;
+		TexelRegion dirty;
+
+		void Encode(size_t index, glm::vec3 normal);
+		void MarkDirty(const TexelRegion& region);
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+
+#include "JobSystem.h"
+
+namespace utilities
+{
+	//Limits the number of threads used by the job system, f.e. to share a machine with other jobs
+	//Has to be called while no parallel work is running
+	//@param count - maximal number of threads including the calling one, 0 leaves one hardware thread to the calling thread
+	inline void SetWorkerCount(int count)
+	{
+		JobSystem::Get().SetWorkerLimit(count);
+	}
+
+	//@return - number of threads ParallelFor splits the work into, the workers of the job system and the calling thread
+	inline int GetWorkerCount()
+	{
+		return JobSystem::Get().GetWorkerCount() + 1;
+	}
+
+	//Splits range [begin, end) into contiguous bands and calls body(bandBegin, bandEnd) for every band on the job system
+	//The calling thread works on the bands as well, function returns after all of the bands are done
+	//@param begin - first index of the range
+	//@param end - index one past the last index of the range
+	//@param body - callable object taking (int bandBegin, int bandEnd)
+	//@param minBandSize - minimal number of indices per band, prevents splitting tiny ranges
+	template <typename Func>
+	void ParallelFor(int begin, int end, Func&& body, int minBandSize = 16)
+	{
+		JobSystem::Get().ParallelFor(begin, end, [&body](int bandBegin, int bandEnd) { body(bandBegin, bandEnd); }, std::max(1, minBandSize));
+	}
+}
@@ -0,0 +1,116 @@
+#include "PerfStats.h"
+#include "JobSystem.h"
+#include "ScratchArena.h"
+
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+namespace utilities
+{
+	namespace {
+		std::atomic<unsigned long long> frameUploadBytes{ 0 };
+
+		std::mutex statsMutex;
+		PerfSnapshot stats;
+		//Worker counters at the end of the previous frame, utilization of a frame is the difference
+		std::vector<WorkerStats> lastWorkerStats;
+
+		MemoryUsage& FindMemory(const std::string& subsystem)
+		{
+			auto it = std::find_if(stats.memory.begin(), stats.memory.end(), [&](const MemoryUsage& m) { return m.name == subsystem; });
+			if (it == stats.memory.end()) {
+				stats.memory.push_back({ subsystem, 0 });
+				return stats.memory.back();
+			}
+			return *it;
+		}
+	}
+
+	void PerfHistory::Push(float value)
+	{
+		values[next] = value;
+		next = (next + 1) % PERF_HISTORY_SIZE;
+		count = std::min(count + 1, PERF_HISTORY_SIZE);
+	}
+
+	float PerfHistory::GetAverage() const
+	{
+		if (count == 0) {
+			return 0.0f;
+		}
+		float sum = 0.0f;
+		for (int i = 0; i < count; i++) {
+			sum += values[i];
+		}
+		return sum / count;
+	}
+
+	float PerfHistory::GetMax() const
+	{
+		return count > 0 ? *std::max_element(values, values + count) : 0.0f;
+	}
+
+	void AddUploadBytes(size_t bytes)
+	{
+		frameUploadBytes.fetch_add(bytes, std::memory_order_relaxed);
+	}
+
+	void RecordStageTime(const std::string& stage, float milliseconds)
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		auto it = std::find_if(stats.stages.begin(), stats.stages.end(), [&](const StageTiming& s) { return s.name == stage; });
+		if (it == stats.stages.end()) {
+			stats.stages.push_back({ stage });
+			it = stats.stages.end() - 1;
+		}
+		it->runs++;
+		it->history.Push(milliseconds);
+	}
+
+	void SetMemoryUsage(const std::string& subsystem, size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		FindMemory(subsystem).bytes = bytes;
+	}
+
+	void AddMemoryUsage(const std::string& subsystem, long long bytes)
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		MemoryUsage& usage = FindMemory(subsystem);
+		usage.bytes = bytes < 0 && static_cast<size_t>(-bytes) > usage.bytes ? 0 : usage.bytes + bytes;
+	}
+
+	//Closes the current frame, called once per frame by the main loop
+	//@param frameTime - duration of the frame in seconds
+	void RecordFrame(float frameTime)
+	{
+		std::vector<WorkerStats> workerStats = JobSystem::Get().GetWorkerStats();
+		const unsigned long long uploaded = frameUploadBytes.exchange(0, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(statsMutex);
+		stats.frameTimes.Push(frameTime * 1000.0f);
+		stats.uploadBytes.Push(static_cast<float>(uploaded));
+
+		//Resetting the stats or changing the worker count restarts the counters, such a frame has no utilization
+		float loadSum = 0.0f;
+		if (lastWorkerStats.size() == workerStats.size()) {
+			for (size_t i = 0; i < workerStats.size(); i++) {
+				const WorkerStats& now = workerStats[i], & before = lastWorkerStats[i];
+				if (now.totalTime > before.totalTime && now.busyTime >= before.busyTime) {
+					loadSum += std::min(1.0f, static_cast<float>(now.busyTime - before.busyTime) / (now.totalTime - before.totalTime));
+				}
+			}
+		}
+		stats.workerUtilization.Push(workerStats.empty() ? 0.0f : loadSum / workerStats.size());
+		lastWorkerStats = std::move(workerStats);
+
+		FindMemory("Scratch arenas (peak)").bytes = GetScratchHighWaterMark();
+	}
+
+	PerfSnapshot GetPerfSnapshot()
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		return stats;
+	}
+}
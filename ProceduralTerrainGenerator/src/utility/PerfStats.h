@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+//Registry of the numbers shown by the performance panel of the application.
+//The generation code reports into it: stage times (StageTimer), bytes uploaded to the GPU (AddUploadBytes) and the
+//memory held by every subsystem (SetMemoryUsage). Upload bytes are an atomic counter, so reporting from any thread
+//costs one relaxed add, the other entries are rare enough to take a lock. RecordFrame is called once per frame by the
+//main loop, it closes the frame: the per frame counters are moved into rolling histories and the worker utilization
+//of the job system during the frame is sampled. The panel reads a copy of everything with GetPerfSnapshot.
+
+namespace utilities
+{
+	//Number of samples kept by every history, a few seconds of frames
+	constexpr int PERF_HISTORY_SIZE = 256;
+
+	//Ring of the latest samples, GetOffset is the index of the oldest one as ImPlot expects it
+	struct PerfHistory {
+		float values[PERF_HISTORY_SIZE] = {};
+		int next = 0, count = 0;
+
+		void Push(float value);
+		float GetLatest() const { return count > 0 ? values[(next + PERF_HISTORY_SIZE - 1) % PERF_HISTORY_SIZE] : 0.0f; }
+		float GetAverage() const;
+		float GetMax() const;
+		int GetOffset() const { return count == PERF_HISTORY_SIZE ? next : 0; }
+	};
+
+	//Duration of one generation stage, in milliseconds
+	struct StageTiming {
+		std::string name;
+		unsigned long long runs = 0;
+		PerfHistory history;
+	};
+
+	struct MemoryUsage {
+		std::string name;
+		size_t bytes = 0;
+	};
+
+	struct PerfSnapshot {
+		//Frame times in milliseconds
+		PerfHistory frameTimes;
+		//Bytes uploaded to textures during every frame
+		PerfHistory uploadBytes;
+		//Average utilization of the workers during every frame, 0 - 1
+		PerfHistory workerUtilization;
+		std::vector<StageTiming> stages;
+		std::vector<MemoryUsage> memory;
+	};
+
+	void AddUploadBytes(size_t bytes);
+	void RecordStageTime(const std::string& stage, float milliseconds);
+	void SetMemoryUsage(const std::string& subsystem, size_t bytes);
+	//Applies a change to a gauge tracked incrementally, f.e. the GPU memory of textures allocated and freed one by one
+	void AddMemoryUsage(const std::string& subsystem, long long bytes);
+	void RecordFrame(float frameTime);
+	PerfSnapshot GetPerfSnapshot();
+
+	//Records the time between its construction and the end of the scope as a sample of the stage
+	class StageTimer
+	{
+	public:
+		explicit StageTimer(const char* _stage) : stage(_stage), start(std::chrono::steady_clock::now()) {}
+		~StageTimer() { RecordStageTime(stage, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count()); }
+
+		StageTimer(const StageTimer&) = delete;
+		StageTimer& operator=(const StageTimer&) = delete;
+
+	private:
+		const char* stage;
+		std::chrono::steady_clock::time_point start;
+	};
+}
@@ -0,0 +1,114 @@
+#include "ScratchArena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+namespace utilities
+{
+	namespace {
+		std::atomic<size_t> globalHighWaterMark{ 0 };
+		std::atomic<size_t> retainLimit{ size_t(64) << 20 };
+	}
+
+	ScratchArena::ScratchArena(size_t _blockSize) : blockSize(std::max<size_t>(_blockSize, 4096))
+	{
+	}
+
+	//Carves bytes from the current block, moves to the next kept block or adds a new one if they do not fit
+	//@param bytes - size of the allocation
+	//@param alignment - power of two alignment of the returned address
+	//@return - pointer valid until the arena is rewound before this allocation
+	void* ScratchArena::Allocate(size_t bytes, size_t alignment)
+	{
+		bytes = std::max<size_t>(bytes, 1);
+		while (true) {
+			if (current < blocks.size()) {
+				Block& block = blocks[current];
+				const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+				const uintptr_t aligned = (base + offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+				const size_t begin = static_cast<size_t>(aligned - base);
+				if (begin + bytes <= block.size) {
+					used += begin + bytes - offset;
+					offset = begin + bytes;
+					if (used > highWaterMark) {
+						highWaterMark = used;
+						size_t global = globalHighWaterMark.load(std::memory_order_relaxed);
+						while (used > global && !globalHighWaterMark.compare_exchange_weak(global, used, std::memory_order_relaxed)) {}
+					}
+					return block.data.get() + begin;
+				}
+				//The rest of the block is skipped, it counts as used so the high water mark covers it
+				if (offset > 0 || current + 1 < blocks.size()) {
+					used += block.size - offset;
+					current++;
+					offset = 0;
+					continue;
+				}
+			}
+			//A kept block which is too small is replaced, so a grown arena does not keep undersized blocks around
+			Block block;
+			block.size = std::max(blockSize, bytes + alignment);
+			block.data = std::make_unique_for_overwrite<unsigned char[]>(block.size);
+			capacity += block.size;
+			if (current < blocks.size()) {
+				capacity -= blocks[current].size;
+				blocks[current] = std::move(block);
+			}
+			else {
+				blocks.push_back(std::move(block));
+			}
+			offset = 0;
+		}
+	}
+
+	void ScratchArena::Rewind(const Marker& marker)
+	{
+		current = marker.block;
+		offset = marker.offset;
+		used = marker.used;
+		if (used == 0) {
+			const size_t limit = retainLimit.load(std::memory_order_relaxed);
+			if (capacity > limit) {
+				Trim(limit);
+			}
+		}
+	}
+
+	//Blocks up to the current position hold live allocations and are always kept, the current block only if it is not empty
+	//@param maxRetained - capacity in bytes the arena may keep, the free blocks are released from the last one
+	void ScratchArena::Trim(size_t maxRetained)
+	{
+		const size_t live = offset > 0 ? current + 1 : current;
+		while (blocks.size() > live && capacity > maxRetained) {
+			capacity -= blocks.back().size;
+			blocks.pop_back();
+		}
+	}
+
+	ScratchArena& GetThreadScratch()
+	{
+		thread_local ScratchArena arena;
+		return arena;
+	}
+
+	size_t GetScratchHighWaterMark()
+	{
+		return globalHighWaterMark.load(std::memory_order_relaxed);
+	}
+
+	void ResetScratchHighWaterMark()
+	{
+		globalHighWaterMark.store(0, std::memory_order_relaxed);
+	}
+
+	void SetScratchRetainLimit(size_t bytes)
+	{
+		retainLimit.store(bytes, std::memory_order_relaxed);
+	}
+
+	size_t GetScratchRetainLimit()
+	{
+		return retainLimit.load(std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+
+//Bump allocator for the transient buffers of a generation pass.
+//Every thread owns one arena (GetThreadScratch), allocations are carved from large blocks and released all at once
+//by rewinding to a marker, usually through a ScratchScope. Blocks are kept between passes, so after the first pass
+//a stage allocates nothing from the heap. Whenever an arena is rewound to empty it frees blocks above the retain limit
+//(SetScratchRetainLimit), so one pass on a huge map does not pin its buffers in every worker thread for good. Scopes have to be nested: a job executed while another one waits on the same
+//thread opens its scope above the waiting one and closes it before the waiting job continues.
+//Destructors are never called, only types which do not need them can be allocated.
+
+namespace utilities
+{
+	class ScratchArena
+	{
+	public:
+		//Position in the arena, rewinding to it releases everything allocated afterwards
+		struct Marker {
+			size_t block = 0;
+			size_t offset = 0;
+			size_t used = 0;
+		};
+
+		explicit ScratchArena(size_t _blockSize = 1 << 20);
+
+		ScratchArena(const ScratchArena&) = delete;
+		ScratchArena& operator=(const ScratchArena&) = delete;
+
+		void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+		//Uninitialized storage for count elements
+		template<typename T>
+		T* Allocate(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "Scratch arena never calls destructors");
+			return static_cast<T*>(Allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16));
+		}
+
+		//Storage for count default initialized elements, plain numbers are zeroed
+		template<typename T>
+		T* AllocateZeroed(size_t count)
+		{
+			T* data = Allocate<T>(count);
+			std::uninitialized_value_construct_n(data, count);
+			return data;
+		}
+
+		Marker GetMarker() const { return { current, offset, used }; }
+		void Rewind(const Marker& marker);
+		void Reset() { Rewind(Marker()); }
+		//Frees the unused blocks behind the current position until the capacity fits in maxRetained bytes
+		void Trim(size_t maxRetained = 0);
+
+		//Bytes allocated since the last reset including alignment padding
+		size_t GetUsed() const { return used; }
+		size_t GetHighWaterMark() const { return highWaterMark; }
+		size_t GetCapacity() const { return capacity; }
+		size_t GetBlockCount() const { return blocks.size(); }
+		void ResetHighWaterMark() { highWaterMark = used; }
+
+	private:
+		struct Block {
+			std::unique_ptr<unsigned char[]> data;
+			size_t size = 0;
+		};
+
+		std::vector<Block> blocks;
+		size_t blockSize;
+		size_t current = 0, offset = 0, used = 0, highWaterMark = 0, capacity = 0;
+	};
+
+	//Rewinds the arena to the position it had when the scope was opened
+	class ScratchScope
+	{
+	public:
+		explicit ScratchScope(ScratchArena& _arena) : arena(_arena), marker(_arena.GetMarker()) {}
+		~ScratchScope() { arena.Rewind(marker); }
+
+		ScratchScope(const ScratchScope&) = delete;
+		ScratchScope& operator=(const ScratchScope&) = delete;
+
+		ScratchArena& GetArena() { return arena; }
+
+	private:
+		ScratchArena& arena;
+		ScratchArena::Marker marker;
+	};
+
+	//Arena of the calling thread, created on first use
+	ScratchArena& GetThreadScratch();
+
+	//Largest high water mark reached by any thread arena, used to size the blocks
+	size_t GetScratchHighWaterMark();
+	void ResetScratchHighWaterMark();
+	//Capacity every thread arena keeps once it is empty again, 64 MB by default
+	void SetScratchRetainLimit(size_t bytes);
+	size_t GetScratchRetainLimit();
+}
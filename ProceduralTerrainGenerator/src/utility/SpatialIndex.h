@@ -0,0 +1,298 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+#include "glm/glm.hpp"
+
+//Chunk aligned uniform grid over instance positions (vegetation, objects).
+//Every chunk is split into cellsPerChunk x cellsPerChunk cells and its instances are stored sorted by cell in row-major order,
+//so every query is answered with contiguous ranges of a chunk's instance array. Ranges can be used directly as
+//(baseInstance, instanceCount) pairs of instanced draw calls once a chunk's array is uploaded as an instance buffer.
+//Chunks can be inserted and removed independently when they stream in and out.
+//Positions are points, the frustum query grows the boxes of chunks and cells by the extent of an instance (SetInstanceBounds)
+//so instances whose model reaches into the view from outside of it are kept.
+
+namespace spatial {
+	//Contiguous part of the instance array of chunk (chunkX, chunkY)
+	struct Range {
+		int chunkX, chunkY;
+		uint32_t begin, count;
+	};
+
+	//Circle on the XZ plane used by the radius queries
+	struct RadiusQuery {
+		float x, z;
+		float radius;
+	};
+
+	//Six clipping planes (ax + by + cz + d >= 0 inside) extracted from a view-projection matrix
+	struct Frustum {
+		glm::vec4 planes[6];
+
+		//Gribb-Hartmann plane extraction, planes are defined in the space the matrix transforms from
+		//@param m - combined projection * view (* model) matrix
+		static Frustum FromMatrix(const glm::mat4& m) {
+			Frustum f;
+			glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+			glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+			glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+			glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+			f.planes[0] = row3 + row0;
+			f.planes[1] = row3 - row0;
+			f.planes[2] = row3 + row1;
+			f.planes[3] = row3 - row1;
+			f.planes[4] = row3 + row2;
+			f.planes[5] = row3 - row2;
+			return f;
+		}
+
+		//Classifies an axis aligned box against the frustum
+		//@return - 0 outside, 1 intersecting, 2 fully inside
+		int TestBox(const glm::vec3& bmin, const glm::vec3& bmax) const {
+			int result = 2;
+			for (int i = 0; i < 6; i++) {
+				const glm::vec4& p = planes[i];
+				glm::vec3 positive(p.x >= 0 ? bmax.x : bmin.x, p.y >= 0 ? bmax.y : bmin.y, p.z >= 0 ? bmax.z : bmin.z);
+				glm::vec3 negative(p.x >= 0 ? bmin.x : bmax.x, p.y >= 0 ? bmin.y : bmax.y, p.z >= 0 ? bmin.z : bmax.z);
+				if (glm::dot(glm::vec3(p), positive) + p.w < 0.0f) {
+					return 0;
+				}
+				if (glm::dot(glm::vec3(p), negative) + p.w < 0.0f) {
+					result = 1;
+				}
+			}
+			return result;
+		}
+	};
+
+	//Instance type has to expose float x, y, z members, x and z being the position on the map plane
+	template <typename Instance>
+	class SpatialGrid
+	{
+	public:
+		//@param _chunkSize - size of a chunk in map units, has to match the chunking of the inserted data
+		//@param _cellsPerChunk - number of cells along one side of a chunk
+		SpatialGrid(float _chunkSize = 64.0f, int _cellsPerChunk = 8)
+			: chunkSize(std::max(1.0f, _chunkSize)), cellsPerChunk(std::max(1, _cellsPerChunk))
+		{
+			cellSize = chunkSize / cellsPerChunk;
+		}
+
+		//Inserts (or replaces) a chunk, instances are copied and counting-sorted by cell
+		//@param chunkX, chunkY - chunk coordinates
+		//@param instances - instances of the chunk
+		void InsertChunk(int chunkX, int chunkY, const std::vector<Instance>& instances)
+		{
+			const int cellCount = cellsPerChunk * cellsPerChunk;
+			Entry& entry = chunks[Key(chunkX, chunkY)];
+			entry.chunkX = chunkX;
+			entry.chunkY = chunkY;
+			entry.cellStart.assign(cellCount + 1, 0);
+			entry.cellMinY.assign(cellCount, 0.0f);
+			entry.cellMaxY.assign(cellCount, 0.0f);
+			entry.instances.resize(instances.size());
+
+			std::vector<uint32_t> cells(instances.size());
+			for (size_t i = 0; i < instances.size(); i++) {
+				cells[i] = CellOf(chunkX, chunkY, instances[i].x, instances[i].z);
+				entry.cellStart[cells[i] + 1]++;
+			}
+			for (int c = 0; c < cellCount; c++) {
+				entry.cellStart[c + 1] += entry.cellStart[c];
+			}
+
+			std::vector<uint32_t> cursor(entry.cellStart.begin(), entry.cellStart.end() - 1);
+			std::vector<bool> touched(cellCount, false);
+			entry.minY = 0.0f;
+			entry.maxY = 0.0f;
+			for (size_t i = 0; i < instances.size(); i++) {
+				const uint32_t c = cells[i];
+				entry.instances[cursor[c]++] = instances[i];
+				if (!touched[c]) {
+					entry.cellMinY[c] = entry.cellMaxY[c] = instances[i].y;
+					touched[c] = true;
+				}
+				entry.cellMinY[c] = std::min(entry.cellMinY[c], instances[i].y);
+				entry.cellMaxY[c] = std::max(entry.cellMaxY[c], instances[i].y);
+				if (i == 0) {
+					entry.minY = entry.maxY = instances[i].y;
+				}
+				entry.minY = std::min(entry.minY, instances[i].y);
+				entry.maxY = std::max(entry.maxY, instances[i].y);
+			}
+		}
+
+		//Removes a chunk from the index
+		//@return - true if the chunk was present
+		bool RemoveChunk(int chunkX, int chunkY)
+		{
+			return chunks.erase(Key(chunkX, chunkY)) > 0;
+		}
+
+		void Clear() { chunks.clear(); }
+		//Extent of the model of an instance around its position, f.e. the canopy of a tree, used by QueryFrustum
+		//@param localMin, localMax - corners of the box relative to the instance position, localMin <= 0 <= localMax
+		void SetInstanceBounds(const glm::vec3& localMin, const glm::vec3& localMax) { boundsMin = localMin; boundsMax = localMax; }
+		size_t GetChunkCount() const { return chunks.size(); }
+
+		//Instances of a chunk sorted by cell, ranges returned by the queries index into this array
+		//@return - pointer to the array or nullptr if the chunk is not present
+		const std::vector<Instance>* GetChunkInstances(int chunkX, int chunkY) const
+		{
+			auto it = chunks.find(Key(chunkX, chunkY));
+			return it == chunks.end() ? nullptr : &it->second.instances;
+		}
+
+		//Ranges of all instances whose cells overlap the rectangle, cell granularity (conservative)
+		void QueryRect(float minX, float minZ, float maxX, float maxZ, std::vector<Range>& out) const
+		{
+			const size_t queryBegin = out.size();
+			const int cx0 = FloorDiv(minX, chunkSize), cx1 = FloorDiv(maxX, chunkSize);
+			const int cy0 = FloorDiv(minZ, chunkSize), cy1 = FloorDiv(maxZ, chunkSize);
+			for (int cy = cy0; cy <= cy1; cy++) {
+				for (int cx = cx0; cx <= cx1; cx++) {
+					auto it = chunks.find(Key(cx, cy));
+					if (it == chunks.end()) {
+						continue;
+					}
+					const Entry& entry = it->second;
+					const float ox = cx * chunkSize, oz = cy * chunkSize;
+					const int x0 = std::clamp(FloorDiv(minX - ox, cellSize), 0, cellsPerChunk - 1);
+					const int x1 = std::clamp(FloorDiv(maxX - ox, cellSize), 0, cellsPerChunk - 1);
+					const int y0 = std::clamp(FloorDiv(minZ - oz, cellSize), 0, cellsPerChunk - 1);
+					const int y1 = std::clamp(FloorDiv(maxZ - oz, cellSize), 0, cellsPerChunk - 1);
+					for (int y = y0; y <= y1; y++) {
+						Append(out, queryBegin, entry, y * cellsPerChunk + x0, y * cellsPerChunk + x1 + 1);
+					}
+				}
+			}
+		}
+
+		//Batched radius queries, ranges of query i are out[queryOffsets[i], queryOffsets[i + 1])
+		//Ranges cover cells overlapping the circle, exact distance test is left to the caller
+		void QueryRadius(const RadiusQuery* queries, int count, std::vector<Range>& out, std::vector<uint32_t>& queryOffsets) const
+		{
+			queryOffsets.resize(count + 1);
+			for (int q = 0; q < count; q++) {
+				queryOffsets[q] = static_cast<uint32_t>(out.size());
+				const RadiusQuery& query = queries[q];
+				const float r2 = query.radius * query.radius;
+				const int cx0 = FloorDiv(query.x - query.radius, chunkSize), cx1 = FloorDiv(query.x + query.radius, chunkSize);
+				const int cy0 = FloorDiv(query.z - query.radius, chunkSize), cy1 = FloorDiv(query.z + query.radius, chunkSize);
+				for (int cy = cy0; cy <= cy1; cy++) {
+					for (int cx = cx0; cx <= cx1; cx++) {
+						auto it = chunks.find(Key(cx, cy));
+						if (it == chunks.end()) {
+							continue;
+						}
+						const Entry& entry = it->second;
+						const float ox = cx * chunkSize, oz = cy * chunkSize;
+						for (int y = 0; y < cellsPerChunk; y++) {
+							//Horizontal extent of the circle on this cell row
+							const float z0 = oz + y * cellSize, z1 = z0 + cellSize;
+							const float dz = std::max({ z0 - query.z, 0.0f, query.z - z1 });
+							if (dz * dz > r2) {
+								continue;
+							}
+							const float halfWidth = std::sqrt(r2 - dz * dz);
+							const int x0 = std::max(0, FloorDiv(query.x - halfWidth - ox, cellSize));
+							const int x1 = std::min(cellsPerChunk - 1, FloorDiv(query.x + halfWidth - ox, cellSize));
+							if (x0 <= x1) {
+								Append(out, queryOffsets[q], entry, y * cellsPerChunk + x0, y * cellsPerChunk + x1 + 1);
+							}
+						}
+					}
+				}
+			}
+			queryOffsets[count] = static_cast<uint32_t>(out.size());
+		}
+
+		//Batched frustum queries, ranges of frustum i are out[queryOffsets[i], queryOffsets[i + 1])
+		//Chunks fully inside a frustum are returned as a single range, intersecting chunks are refined per cell
+		void QueryFrustum(const Frustum* frustums, int count, std::vector<Range>& out, std::vector<uint32_t>& queryOffsets) const
+		{
+			queryOffsets.resize(count + 1);
+			for (int q = 0; q < count; q++) {
+				queryOffsets[q] = static_cast<uint32_t>(out.size());
+				for (const auto& it : chunks) {
+					const Entry& entry = it.second;
+					if (entry.instances.empty()) {
+						continue;
+					}
+					const float ox = entry.chunkX * chunkSize, oz = entry.chunkY * chunkSize;
+					const int chunkTest = frustums[q].TestBox(glm::vec3(ox, entry.minY, oz) + boundsMin, glm::vec3(ox + chunkSize, entry.maxY, oz + chunkSize) + boundsMax);
+					if (chunkTest == 0) {
+						continue;
+					}
+					if (chunkTest == 2) {
+						Append(out, queryOffsets[q], entry, 0, cellsPerChunk * cellsPerChunk);
+						continue;
+					}
+					for (int c = 0; c < cellsPerChunk * cellsPerChunk; c++) {
+						if (entry.cellStart[c] == entry.cellStart[c + 1]) {
+							continue;
+						}
+						const float x0 = ox + (c % cellsPerChunk) * cellSize, z0 = oz + (c / cellsPerChunk) * cellSize;
+						if (frustums[q].TestBox(glm::vec3(x0, entry.cellMinY[c], z0) + boundsMin, glm::vec3(x0 + cellSize, entry.cellMaxY[c], z0 + cellSize) + boundsMax) != 0) {
+							Append(out, queryOffsets[q], entry, c, c + 1);
+						}
+					}
+				}
+			}
+			queryOffsets[count] = static_cast<uint32_t>(out.size());
+		}
+
+	private:
+		struct Entry {
+			int chunkX = 0, chunkY = 0;
+			float minY = 0.0f, maxY = 0.0f;
+			std::vector<Instance> instances;
+			std::vector<uint32_t> cellStart;
+			std::vector<float> cellMinY, cellMaxY;
+		};
+
+		float chunkSize, cellSize;
+		int cellsPerChunk;
+		glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+		std::unordered_map<uint64_t, Entry> chunks;
+
+		static uint64_t Key(int chunkX, int chunkY)
+		{
+			return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkY);
+		}
+
+		static int FloorDiv(float v, float size)
+		{
+			return static_cast<int>(std::floor(v / size));
+		}
+
+		uint32_t CellOf(int chunkX, int chunkY, float x, float z) const
+		{
+			const int cx = std::clamp(FloorDiv(x - chunkX * chunkSize, cellSize), 0, cellsPerChunk - 1);
+			const int cy = std::clamp(FloorDiv(z - chunkY * chunkSize, cellSize), 0, cellsPerChunk - 1);
+			return static_cast<uint32_t>(cy * cellsPerChunk + cx);
+		}
+
+		//Appends instances of cells [cellBegin, cellEnd), merging with the previous range of the same query if they are adjacent in memory
+		static void Append(std::vector<Range>& out, size_t queryBegin, const Entry& entry, int cellBegin, int cellEnd)
+		{
+			const uint32_t begin = entry.cellStart[cellBegin];
+			const uint32_t end = entry.cellStart[cellEnd];
+			if (begin == end) {
+				return;
+			}
+			if (out.size() > queryBegin) {
+				Range& last = out.back();
+				if (last.chunkX == entry.chunkX && last.chunkY == entry.chunkY && last.begin + last.count == begin) {
+					last.count += end - begin;
+					return;
+				}
+			}
+			out.push_back({ entry.chunkX, entry.chunkY, begin, end - begin });
+		}
+	};
+}
@@ -0,0 +1,160 @@
+#include "StageGraph.h"
+#include "JobSystem.h"
+#include "PerfStats.h"
+#include "Trace.h"
+#include "Log.h"
+
+#include <chrono>
+
+namespace utilities
+{
+	StageHash& StageHash::AddBytes(const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return *this;
+	}
+
+	int StageGraph::AddStage(const std::string& name, const std::vector<int>& inputs, StageThread thread, std::function<uint64_t()> hash, std::function<bool()> run)
+	{
+		const int id = static_cast<int>(stages.size());
+		for (int input : inputs) {
+			if (input < 0 || input >= id) {
+				LOG_ERROR("Stage '" << name << "' has an input which was not added before it");
+				return -1;
+			}
+		}
+		Stage stage;
+		stage.name = name;
+		stage.inputs = inputs;
+		stage.thread = thread;
+		stage.hash = std::move(hash);
+		stage.run = std::move(run);
+		stage.inputVersions.assign(inputs.size(), 0);
+		stages.push_back(std::move(stage));
+		return id;
+	}
+
+	void StageGraph::SetCondition(int stage, std::function<bool()> condition)
+	{
+		stages[stage].condition = std::move(condition);
+	}
+
+	void StageGraph::Invalidate(int stage)
+	{
+		stages[stage].invalidated = true;
+	}
+
+	int StageGraph::Evaluate()
+	{
+		TRACE_ZONE("StageGraph::Evaluate");
+		evaluationCount++;
+		std::vector<JobHandle> jobs(stages.size());
+		std::vector<JobHandle> pending;
+		int scheduled = 0;
+
+		//Hashes and conditions read the configuration, so they are evaluated here on the calling thread
+		for (int id = 0; id < static_cast<int>(stages.size()); id++) {
+			Stage& stage = stages[id];
+			if (stage.condition && !stage.condition()) {
+				stage.status = StageStatus::DISABLED;
+				continue;
+			}
+
+			const uint64_t hash = stage.hash ? stage.hash() : 0;
+			std::string reason;
+			if (!stage.evaluated) {
+				reason = "First run";
+			}
+			else if (stage.invalidated) {
+				reason = "Invalidated";
+			}
+			else if (hash != stage.lastHash) {
+				reason = "Configuration changed";
+			}
+			else {
+				for (size_t k = 0; k < stage.inputs.size(); k++) {
+					const Stage& input = stages[stage.inputs[k]];
+					//Scheduled inputs are still running, the version is read only from the finished ones
+					if (jobs[stage.inputs[k]] || input.version != stage.inputVersions[k]) {
+						reason = "Input '" + input.name + "' changed";
+						break;
+					}
+				}
+			}
+			if (reason.empty()) {
+				stage.status = stage.failure;
+				continue;
+			}
+
+			stage.pendingHash = hash;
+			stage.reason = std::move(reason);
+			stage.lastRunEvaluation = evaluationCount;
+			scheduled++;
+
+			std::vector<JobHandle> dependencies;
+			for (int input : stage.inputs) {
+				if (jobs[input]) {
+					dependencies.push_back(jobs[input]);
+				}
+			}
+			if (stage.thread == StageThread::MAIN) {
+				JobSystem::Get().WaitAll(dependencies);
+				RunStage(id);
+				continue;
+			}
+			jobs[id] = JobSystem::Get().Submit([this, id]() { RunStage(id); }, dependencies);
+			pending.push_back(jobs[id]);
+		}
+		JobSystem::Get().WaitAll(pending);
+		return scheduled;
+	}
+
+	//Runs one stage once all of its inputs are done, the job dependencies order the accesses to the input stages
+	void StageGraph::RunStage(int id)
+	{
+		Stage& stage = stages[id];
+		for (int input : stage.inputs) {
+			if (stages[input].status == StageStatus::FAILED || stages[input].status == StageStatus::BLOCKED) {
+				stage.status = StageStatus::BLOCKED;
+				stage.reason = "Input '" + stages[input].name + "' failed";
+				CommitRun(stage);
+				return;
+			}
+		}
+
+		bool succeeded;
+		const auto start = std::chrono::steady_clock::now();
+		{
+			TRACE_ZONE(stage.name.c_str());
+			succeeded = stage.run();
+		}
+		stage.lastTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		stage.runs++;
+		RecordStageTime(stage.name, stage.lastTime);
+
+		if (!succeeded) {
+			stage.status = StageStatus::FAILED;
+			CommitRun(stage);
+			LOG_ERROR("Stage '" << stage.name << "' failed");
+			return;
+		}
+		stage.status = StageStatus::RAN;
+		CommitRun(stage);
+		stage.version++;
+	}
+
+	//Remembers what the run saw, a failed run is committed as well so it is repeated only after something changes
+	void StageGraph::CommitRun(Stage& stage)
+	{
+		stage.evaluated = true;
+		stage.invalidated = false;
+		stage.lastHash = stage.pendingHash;
+		for (size_t k = 0; k < stage.inputs.size(); k++) {
+			stage.inputVersions[k] = stages[stage.inputs[k]].version;
+		}
+		stage.failure = stage.status == StageStatus::RAN ? StageStatus::UP_TO_DATE : stage.status;
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+//Dataflow graph of the generation stages (component noises -> combine -> biomes -> colours -> textures).
+//Every stage declares the stages it reads (inputs) and a hash of the configuration it depends on. Evaluate visits the
+//stages in the order they were added, which therefore has to be topological, and recomputes only the stages whose
+//configuration hash changed, which were invalidated or whose inputs produced a new result since their own last run.
+//Stages which have to be recomputed run as jobs of the job system depending on the jobs of their inputs, so independent
+//branches (f.e. the five component noises) run in parallel. Stages touching OpenGL are marked MAIN and run on the
+//calling thread once their inputs are done.
+//A stage may be disabled by a condition, its inputs keep changing meanwhile and it catches up once enabled again.
+//A stage which failed or was blocked by a failed input keeps its status and is retried only once its configuration or
+//inputs change or it is invalidated (f.e. by the Rerun button of the panel), so a persistent failure does not rerun every frame.
+//The state of the last evaluation and the reason of every stage's last run are kept for the UI.
+
+namespace utilities
+{
+	//FNV-1a hash of the configuration a stage depends on, values are added field by field so padding is never hashed
+	class StageHash
+	{
+	public:
+		template <typename T>
+		StageHash& Add(const T& value)
+		{
+			static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only arithmetic and enum values can be hashed directly");
+			return AddBytes(&value, sizeof(T));
+		}
+		template <typename T>
+		StageHash& Add(const std::vector<T>& values)
+		{
+			Add(values.size());
+			for (const T& value : values) {
+				Add(value);
+			}
+			return *this;
+		}
+		StageHash& AddBytes(const void* data, size_t size);
+		uint64_t Get() const { return hash; }
+
+	private:
+		uint64_t hash = 14695981039346656037ull;
+	};
+
+	enum class StageThread {
+		WORKER,
+		MAIN
+	};
+
+	//Outcome of a stage in the last evaluation
+	enum class StageStatus {
+		UP_TO_DATE,
+		RAN,
+		FAILED,
+		//Not run because one of its inputs failed
+		BLOCKED,
+		DISABLED
+	};
+
+	class StageGraph
+	{
+	public:
+		struct Stage {
+			std::string name;
+			std::vector<int> inputs;
+			StageThread thread;
+			std::function<uint64_t()> hash;
+			std::function<bool()> run;
+			std::function<bool()> condition;
+
+			//Versions of the inputs the last run read, the version grows with every successful run
+			std::vector<uint64_t> inputVersions;
+			uint64_t version = 0;
+			//Hash of the last run and the hash of the run in progress
+			uint64_t lastHash = 0, pendingHash = 0;
+			bool evaluated = false, invalidated = false;
+			//FAILED or BLOCKED while the last run did not succeed, UP_TO_DATE otherwise
+			StageStatus failure = StageStatus::UP_TO_DATE;
+
+			StageStatus status = StageStatus::UP_TO_DATE;
+			std::string reason;
+			unsigned long long runs = 0;
+			uint64_t lastRunEvaluation = 0;
+			float lastTime = 0.0f;
+		};
+
+		//Adds a stage, stages have to be added before the first evaluation and after all of their inputs
+		//@param inputs - ids of the stages whose results the stage reads
+		//@param hash - hash of the configuration of the stage, may be empty if the stage depends only on its inputs
+		//@param run - computes the stage, returns false on failure
+		//@return - id of the stage
+		int AddStage(const std::string& name, const std::vector<int>& inputs, StageThread thread, std::function<uint64_t()> hash, std::function<bool()> run);
+		//Stage is skipped while the condition returns false
+		void SetCondition(int stage, std::function<bool()> condition);
+		//Forces the stage to run in the next evaluation, f.e. when its input changed outside of the graph
+		void Invalidate(int stage);
+		//Runs every stage which is out of date
+		//@return - number of stages run
+		int Evaluate();
+
+		bool HasRun(int stage) const { return stages[stage].status == StageStatus::RAN; }
+		const std::vector<Stage>& GetStages() const { return stages; }
+		uint64_t GetEvaluationCount() const { return evaluationCount; }
+
+	private:
+		std::vector<Stage> stages;
+		uint64_t evaluationCount = 0;
+
+		void RunStage(int id);
+		void CommitRun(Stage& stage);
+	};
+}
@@ -0,0 +1,163 @@
+#include "Trace.h"
+#include "Log.h"
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+namespace utilities
+{
+	namespace detail {
+		std::atomic<bool> tracingEnabled{ true };
+	}
+
+	namespace {
+		//Events kept per thread, a power of two so the ring index is a mask
+		constexpr uint64_t TRACE_BUFFER_CAPACITY = 1 << 16;
+
+		//Ring buffer of one thread, events are written by the owner and published by the release store of written
+		struct ThreadBuffer {
+			int id = 0;
+			std::string name;
+			std::unique_ptr<TraceEvent[]> events = std::make_unique<TraceEvent[]>(TRACE_BUFFER_CAPACITY);
+			std::atomic<uint64_t> written{ 0 };
+			std::atomic<uint64_t> cleared{ 0 };
+		};
+
+		//Buffers outlive their threads, so events of finished workers can still be exported
+		std::mutex registryMutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+		const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+		ThreadBuffer& GetThreadBuffer()
+		{
+			thread_local ThreadBuffer* buffer = nullptr;
+			if (!buffer) {
+				auto created = std::make_shared<ThreadBuffer>();
+				std::lock_guard<std::mutex> lock(registryMutex);
+				created->id = static_cast<int>(registry.size()) + 1;
+				created->name = "Thread " + std::to_string(created->id);
+				registry.push_back(created);
+				buffer = created.get();
+			}
+			return *buffer;
+		}
+
+		std::string EscapeName(const char* name)
+		{
+			std::string escaped;
+			for (const char* c = name; *c; c++) {
+				if (*c == '"' || *c == '\\') {
+					escaped += '\\';
+				}
+				escaped += static_cast<unsigned char>(*c) < 0x20 ? ' ' : *c;
+			}
+			return escaped;
+		}
+	}
+
+	void SetTracingEnabled(bool enabled)
+	{
+		detail::tracingEnabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool IsTracingEnabled()
+	{
+		return detail::tracingEnabled.load(std::memory_order_relaxed);
+	}
+
+	void SetTraceThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(registryMutex);
+		buffer.name = name;
+	}
+
+	uint64_t GetTraceTime()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count());
+	}
+
+	void RecordTraceEvent(const char* name, uint64_t start, uint64_t end)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+		const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+		buffer.events[index & (TRACE_BUFFER_CAPACITY - 1)] = { name, start, end - start };
+		buffer.written.store(index + 1, std::memory_order_release);
+	}
+
+	void ClearTrace()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (auto& buffer : registry) {
+			buffer->cleared.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+		}
+	}
+
+	//Writes the events of all threads as complete ("X") events with thread name metadata
+	//Threads may keep recording meanwhile, events overwritten during the copy are detected by rereading the write index and skipped
+	//@param path - path of the JSON file
+	//@return - false if the file couldnt be written
+	bool WriteChromeTrace(const std::string& path)
+	{
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		std::vector<std::string> names;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffers = registry;
+			for (const auto& buffer : buffers) {
+				names.push_back(buffer->name);
+			}
+		}
+
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			LOG_ERROR("Could not open trace file: " << path);
+			return false;
+		}
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+		bool first = true;
+		size_t eventCount = 0;
+		std::vector<TraceEvent> events;
+		for (size_t b = 0; b < buffers.size(); b++) {
+			ThreadBuffer& buffer = *buffers[b];
+			file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer.id
+				<< ", \"args\": {\"name\": \"" << EscapeName(names[b].c_str()) << "\"}}";
+			first = false;
+
+			const uint64_t written = buffer.written.load(std::memory_order_acquire);
+			const uint64_t begin = std::max<uint64_t>(written > TRACE_BUFFER_CAPACITY ? written - TRACE_BUFFER_CAPACITY : 0, buffer.cleared.load(std::memory_order_relaxed));
+			events.clear();
+			for (uint64_t i = begin; i < written; i++) {
+				events.push_back(buffer.events[i & (TRACE_BUFFER_CAPACITY - 1)]);
+			}
+			const uint64_t rewritten = buffer.written.load(std::memory_order_acquire);
+			//The slot of index rewritten may be in the middle of being written as well
+			const uint64_t valid = rewritten + 1 > TRACE_BUFFER_CAPACITY ? rewritten + 1 - TRACE_BUFFER_CAPACITY : 0;
+
+			for (uint64_t i = begin; i < written; i++) {
+				if (i < valid) {
+					continue;
+				}
+				const TraceEvent& e = events[i - begin];
+				file << ",\n{\"name\": \"" << EscapeName(e.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer.id
+					<< ", \"ts\": " << e.start / 1000.0 << ", \"dur\": " << e.duration / 1000.0 << "}";
+				eventCount++;
+			}
+		}
+		file << "\n]}\n";
+		if (!file.good()) {
+			LOG_ERROR("Could not write trace file: " << path);
+			return false;
+		}
+		LOG_INFO("Trace with " << eventCount << " events written to: " << path);
+		return true;
+	}
+}
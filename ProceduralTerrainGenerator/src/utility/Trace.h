@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+//Scoped trace zones of the generation stages, exported in the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+//TRACE_ZONE("name") records the time between its declaration and the end of the scope. Events go to a fixed size ring
+//buffer of the recording thread, written only by that thread and read without locks by the exporter, so recording
+//never blocks. The oldest events are overwritten once a buffer is full.
+//Zone names have to be string literals (or otherwise outlive the export), only the pointer is stored.
+//Defining TERRAIN_NO_TRACING removes the zones at compile time, at runtime recording is toggled by SetTracingEnabled.
+
+#ifndef TERRAIN_NO_TRACING
+#define TERRAIN_TRACING
+#endif
+
+namespace utilities
+{
+	//Completed zone, times are nanoseconds since the start of the trace clock
+	struct TraceEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t duration;
+	};
+
+	void SetTracingEnabled(bool enabled);
+	bool IsTracingEnabled();
+	//Names the calling thread in exported traces, f.e. "Worker 3"
+	void SetTraceThreadName(const std::string& name);
+	uint64_t GetTraceTime();
+	void RecordTraceEvent(const char* name, uint64_t start, uint64_t end);
+	//Drops every event recorded so far
+	void ClearTrace();
+	bool WriteChromeTrace(const std::string& path);
+
+	namespace detail {
+		extern std::atomic<bool> tracingEnabled;
+	}
+
+	class TraceZone
+	{
+	public:
+		explicit TraceZone(const char* _name) : name(detail::tracingEnabled.load(std::memory_order_relaxed) ? _name : nullptr), start(name ? GetTraceTime() : 0) {}
+		~TraceZone() { if (name) RecordTraceEvent(name, start, GetTraceTime()); }
+
+		TraceZone(const TraceZone&) = delete;
+		TraceZone& operator=(const TraceZone&) = delete;
+
+	private:
+		const char* name;
+		uint64_t start;
+	};
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef TERRAIN_TRACING
+#define TRACE_ZONE(name) utilities::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define TRACE_ZONE(name) ((void)0)
+#endif
@@ -1,17 +1,12 @@
-#define TINYOBJLOADER_IMPLEMENTATION
-
 #include "utilities.h"
 
 #include <math.h>
-#include <fstream>
-#include <sstream>
-#include <GL/glew.h>
 
 #include <iostream>
 #include "glm/glm.hpp"
-#include "imgui/imgui.h"
-#include "glm/gtc/matrix_transform.hpp"
-#include "ObjLoader/tiny_obj_loader.h"
+#include "Parallel.h"
+#include "Trace.h"
+#include "Log.h"
 
 namespace utilities
 {
@@ -36,22 +31,24 @@ namespace utilities
 	//@param offset - offset in the vertex array to start with when filling the data
 	void ParseNoiseIntoVertices(float* vertices, float* map, const int& width, const int& height, float scale, const unsigned int stride, unsigned int offset){
 		if (!vertices) {
-			std::cout << "[ERROR] Vertices array not initialized" << std::endl;
+			LOG_ERROR("Vertices array not initialized");
 			return;
 		}
 		if(!map) {
-			std::cout << "[ERROR] Noise map not initialized" << std::endl;
+			LOG_ERROR("Noise map not initialized");
 			return;
 		}
-		for (int y = 0; y < height; y++)
-		{
-			for (int x = 0; x < width; x++)
+		ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+			for (int y = bandBegin; y < bandEnd; y++)
 			{
-				vertices[((y * width) + x) * stride + offset] = -width / 2.0f + x;
-				vertices[((y * width) + x) * stride + offset + 1] = map[y * width + x] * scale;
-				vertices[((y * width) + x) * stride + offset + 2] = -height / 2.0f + y;
+				for (int x = 0; x < width; x++)
+				{
+					vertices[((y * width) + x) * stride + offset] = -width / 2.0f + x;
+					vertices[((y * width) + x) * stride + offset + 1] = map[y * width + x] * scale;
+					vertices[((y * width) + x) * stride + offset + 2] = -height / 2.0f + y;
+				}
 			}
-		}
+		});
 	}
 
 	void GenerateVerticesForResolution(float* vertices, const int& height, const int& width, int resolution, const unsigned int& stride, unsigned int posOffset, unsigned int texOffset){
@@ -88,16 +85,21 @@ namespace utilities
 	}
 
 	//Generates indices for a mesh, by dividing the mesh into strips of triangles
+	//Strips are separated by STRIP_RESTART_INDEX, so the whole mesh is drawn with a single call with primitive restart enabled
 	//Method of indexing vertices in the grid shown below:
 	// 0---2
 	// | / |
 	// 1---3
-	//@param indices - pointer to the array of indices to be filled with index data
+	//@param indices - pointer to the array of indices to be filled with index data, has to hold GetStripIndexCount(width, height) values
 	//@param width - width of the noise map (columns)
 	//@param height - height of the noise map (rows)
 	void MeshIndicesStrips(unsigned int* indices, const int& width, const int& height) {
+		TRACE_ZONE("MeshIndicesStrips");
 		int index = 0;
 		for (int y = 0; y < height - 1; y++) {
+			if (y > 0) {
+				indices[index++] = STRIP_RESTART_INDEX;
+			}
 			for (int x = 0; x < width; x++) {
 				for (int k = 0; k < 2; k++) {
 					indices[index++] = width * (y + k) + x;
@@ -106,60 +108,14 @@ namespace utilities
 		}
 	}
 
-	//Calculates normals for the height map based on the vertices and their positions
-	//This function uses the cross product of the horizontal and vertical vectors of neighbouring vertices to calculate the normal vector
-	//@param vertices - array of vertices to be filled with data
-	//@param stride - number of floats per vertex
-	//@param offSet - offset in the vertex array to start with when filling the normals
-	//@param width - width of the noise map in chunks
-	//@param height - height of the noise map in chunks
-	bool CalculateHeightMapNormals(float* vertices, const unsigned int& stride, unsigned int offSet, const unsigned int& width, const unsigned int& height)
-	{
-		if (!vertices) {
-			return false;
-		}
-		glm::vec3 tmp(0.0f, 0.0f, 0.0f);
-		glm::vec3 vx(0.0f, 0.0f, 0.0f);
-		glm::vec3 vz(0.0f, 0.0f, 0.0f);
-		for (int z = 0; z < height; z++) {
-			for (int x = 0; x < width; x++) {
-				//Vertical vector
-				if (height == 1) {
-					vz = glm::vec3(0.0f, 0.0f, 0.0f);
-				}
-				else if (z == 0) {
-					vz = glm::vec3(0.0f, vertices[((z + 1) * width + x) * stride + 1] - vertices[(z * width + x) * stride + 1], 1.0f);
-				}
-				else if (z == height - 1) {
-					vz = glm::vec3(0.0f, vertices[((z - 1) * width + x) * stride + 1] - vertices[(z * width + x) * stride + 1], 1.0f);
-				}
-				else
-				{
-					vz = glm::vec3(0.0f, vertices[((z + 1) * width + x) * stride + 1] - vertices[((z - 1) * width + x) * stride + 1], 2.0f);
-				}
-				//Horizontal vector
-				if (width == 1) {
-					vx = glm::vec3(0.0f, 0.0f, 0.0f);
-				}
-				else if (x == 0) {
-					vx = glm::vec3(1.0f, vertices[(z * width + x + 1) * stride + 1] - vertices[(z * width + x) * stride + 1], 0.0f);
-				}
-				else if (x == width - 1) {
-					vx = glm::vec3(1.0f, vertices[(z * width + x - 1) * stride + 1] - vertices[(z * width + x) * stride + 1], 0.0f);
-				}
-				else
-				{
-					vx = glm::vec3(2.0f, vertices[(z * width + x + 1) * stride + 1] - vertices[(z * width + x - 1) * stride + 1], 0.0f);
-				}
-				//Cross product to get the normal vector and normalize it
-				tmp = glm::normalize(glm::cross(vz, vx));
-				//Set the normal vector to the vertex
-				vertices[(z * width + x) * stride + offSet] = tmp.x;
-				vertices[(z * width + x) * stride + offSet + 1] = tmp.y;
-				vertices[(z * width + x) * stride + offSet + 2] = tmp.z;
-			}
+	//Number of indices written by MeshIndicesStrips, including the restart indices
+	//@param width - width of the noise map (columns)
+	//@param height - height of the noise map (rows)
+	unsigned int GetStripIndexCount(const int& width, const int& height) {
+		if (width < 2 || height < 2) {
+			return 0;
 		}
-		return true;
+		return static_cast<unsigned int>((height - 1) * (width * 2 + 1) - 1);
 	}
 
 	//Generates a color based on the height value, using a gradient from blue to green to red
@@ -185,82 +141,101 @@ namespace utilities
 	bool PaintVerticesByHeight(float* vertices, const int& width, const int& height, const float& heightScale, const unsigned int& stride, heightMapMode m, unsigned int heightOffSet, unsigned int colorOffset)
 	{
 		if (!vertices) {
-			std::cout << "[ERROR] Vertices array not initialized" << std::endl;
+			LOG_ERROR("Vertices array not initialized");
 			return false;
 		}
 		if (m == heightMapMode::GREYSCALE) {
-			for (int y = 0; y < height; y++) {
-				for (int x = 0; x < width; x++) {
-					float h = vertices[(y * width + x) * stride + heightOffSet];
-					float hNorm = std::clamp((h + 16.0f) / heightScale, 0.0f, 1.0f);
+			ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+				for (int y = bandBegin; y < bandEnd; y++) {
+					for (int x = 0; x < width; x++) {
+						float h = vertices[(y * width + x) * stride + heightOffSet];
+						float hNorm = std::clamp((h + 16.0f) / heightScale, 0.0f, 1.0f);
 
-					vertices[(y * width + x) * stride + colorOffset] = hNorm;
-					vertices[(y * width + x) * stride + colorOffset + 1] = hNorm;
-					vertices[(y * width + x) * stride + colorOffset + 2] = hNorm;
+						vertices[(y * width + x) * stride + colorOffset] = hNorm;
+						vertices[(y * width + x) * stride + colorOffset + 1] = hNorm;
+						vertices[(y * width + x) * stride + colorOffset + 2] = hNorm;
+					}
 				}
-			}
-			std::cout << "[LOG] Greyscale painting applied" << std::endl;
+			});
+			LOG_INFO("Greyscale painting applied");
 		}
 		else if (m == heightMapMode::TOPOGRAPHICAL) {
 			float bandWidth = 0.2f;
-			for (int y = 0; y < height; y++) {
-				for (int x = 0; x < width; x++) {
-					float h = vertices[(y * width + x) * stride + heightOffSet];
-					float hNorm = std::clamp((h + 16.0f) / heightScale, 0.0f, 1.0f);
+			ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+				for (int y = bandBegin; y < bandEnd; y++) {
+					for (int x = 0; x < width; x++) {
+						float h = vertices[(y * width + x) * stride + heightOffSet];
+						float hNorm = std::clamp((h + 16.0f) / heightScale, 0.0f, 1.0f);
 
-					glm::vec3 topoColor = getTopoColor(hNorm);
+						glm::vec3 topoColor = getTopoColor(hNorm);
 
-					vertices[(y * width + x) * stride + colorOffset] = topoColor.r;
-					vertices[(y * width + x) * stride + colorOffset + 1] = topoColor.g;
-					vertices[(y * width + x) * stride + colorOffset + 2] = topoColor.b;
+						vertices[(y * width + x) * stride + colorOffset] = topoColor.r;
+						vertices[(y * width + x) * stride + colorOffset + 1] = topoColor.g;
+						vertices[(y * width + x) * stride + colorOffset + 2] = topoColor.b;
+					}
 				}
-			}
-			std::cout << "[LOG] Topographical painting applied" << std::endl;
+			});
+			LOG_INFO("Topographical painting applied");
 		}
 		else if(m == heightMapMode::MONOCOLOR) {
 			glm::vec3 monoColor = glm::vec3(0.6f, 0.6f, 0.6f);
-			for (int y = 0; y < height; y++) {
-				for (int x = 0; x < width; x++) {
-					vertices[(y * width + x) * stride + colorOffset] = monoColor.r;
-					vertices[(y * width + x) * stride + colorOffset + 1] = monoColor.g;
-					vertices[(y * width + x) * stride + colorOffset + 2] = monoColor.b;
+			ParallelFor(0, height, [&](int bandBegin, int bandEnd) {
+				for (int y = bandBegin; y < bandEnd; y++) {
+					for (int x = 0; x < width; x++) {
+						vertices[(y * width + x) * stride + colorOffset] = monoColor.r;
+						vertices[(y * width + x) * stride + colorOffset + 1] = monoColor.g;
+						vertices[(y * width + x) * stride + colorOffset + 2] = monoColor.b;
+					}
 				}
-			}
-			std::cout << "[LOG] Monocolor painting applied" << std::endl;
+			});
+			LOG_INFO("Monocolor painting applied");
 		}
 		else {
-			std::cout << "[LOG] Painting mode not recognized" << std::endl;
+			LOG_INFO("Painting mode not recognized");
 		}
 		return true;
 	}
 
 
-	//Paints vertices based on their biome, using the biome generator to determine the color
-	//@param vertices - array of vertices to be filled with data
+	//Colours every pixel by its biome, if biome weights were blended colour is a weighted mix of the blended biomes colours
 	//@param biomeGen - biome generator object
-	//@param width - width of the noise
-	//@param height - height of the noise map
-	//@param stride - number of floats per vertex
-	//@param colorOffset - offset in the vertex array to start with when filling the color data
-	std::vector<glm::vec3> GetBiomeColorMap(BiomeGenerator& biomeGen, const int& width, const int& height)
+	//@param width - width of the biome map
+	//@param height - height of the biome map
+	//@param scratch - arena the colours are carved from, they stay valid until the caller's scope rewinds it
+	//@return - width * height colours or nullptr if the biome map is not generated
+	const glm::vec3* GetBiomeColorMap(BiomeGenerator& biomeGen, const int& width, const int& height, ScratchArena& scratch)
 	{
 		if (!biomeGen.IsGenerated()) {
-			std::cout << "[ERROR] Biome map not generated!" << std::endl;
-			return {};
+			LOG_ERROR("Biome map not generated!");
+			return nullptr;
 		}
 
-		std::vector<glm::vec3> colors(width * height);
+		glm::vec3 palette[256];
+		for (int id = 0; id < 256; id++) {
+			palette[id] = biomeGen.HasBiome(id) ? biomeGen.GetBiome(id).GetColor() : glm::vec3(0.0f);
+		}
+		glm::vec3* colors = scratch.Allocate<glm::vec3>(static_cast<size_t>(width) * height);
 
-		for (int y = 0; y < height; y++) {
-			for (int x = 0; x < width; x++) {
-				int id = biomeGen.GetBiomeAt(x, y);
-				if (id < 0) {
-					std::cout << "[ERROR] Biome not found!\n";
-					return {};
+		if (biomeGen.IsBlended()) {
+			const biome::BiomeWeights* weights = biomeGen.GetBiomeWeights();
+			for (int i = 0; i < width * height; i++) {
+				glm::vec3 color(0.0f);
+				for (int k = 0; k < biome::MAX_BLENDED_BIOMES; k++) {
+					color += palette[weights[i].ids[k]] * (weights[i].weights[k] / 255.0f);
 				}
-				glm::vec3 color = biomeGen.GetBiome(id).GetColor();
-				colors[y * width + x] = color;
+				colors[i] = color;
+			}
+			return colors;
+		}
+
+		const int* biomeMap = biomeGen.GetBiomeMap();
+		for (int i = 0; i < width * height; i++) {
+			const int id = biomeMap[i];
+			if (id < 0) {
+				LOG_ERROR("Biome not found!");
+				return nullptr;
 			}
+			colors[i] = id < 256 ? palette[id] : biomeGen.GetBiome(id).GetColor();
 		}
 		return colors;
 	}
@@ -280,11 +255,12 @@ namespace utilities
 	//@param paint - boolean value indicating if painting should be applied
 	void MapToVertices(float* map, float* vertices, unsigned int* indices, int const height, const int width, const unsigned int stride, const float& heightScale, heightMapMode mode, bool normalsCalculation, bool indexGeneration, bool paint)
 	{
+		TRACE_ZONE("MapToVertices");
 		ParseNoiseIntoVertices(vertices, map, width, height, heightScale, stride, 0);
 		if (indexGeneration)
 			MeshIndicesStrips(indices, width, height);
 		if (normalsCalculation) {
-			CalculateHeightMapNormals(vertices, stride, 3, width, height);
+			CalculateNormalMap(map, width, height, heightScale, vertices, stride, 3);
 		}
 		if (paint) {
 			PaintVerticesByHeight(vertices, width, height, heightScale, stride, mode, 1, 6);
@@ -302,176 +278,7 @@ namespace utilities
 	void PerformErosion(erosion::Erosion& erosion, float* vertices, float scalingFactor, std::optional<float*> Track, int stride, heightMapMode mode) {
 		erosion.Erode(Track);
 		ParseNoiseIntoVertices(vertices, erosion.GetMap(), erosion.GetWidth(), erosion.GetHeight(), scalingFactor, stride, 0);
-		CalculateHeightMapNormals(vertices, stride, 3, erosion.GetWidth(), erosion.GetHeight());
+		CalculateNormalMap(erosion.GetMap(), erosion.GetWidth(), erosion.GetHeight(), scalingFactor, vertices, stride, 3);
 		PaintVerticesByHeight(vertices, erosion.GetWidth(), erosion.GetHeight(), scalingFactor, stride, mode, 1, 6);
 	}
-
-	//ImGui interface for modifying noise parameters
-	//@param noise - Perlin noise object
-	//@return - boolean value indicating if the noise parameters were modified
-	bool NoiseImGui(noise::NoiseConfigParameters& noiseConfig)
-	{
-		if (ImGui::CollapsingHeader("Noise Settings", ImGuiTreeNodeFlags_DefaultOpen)) {
-			bool regenerate = false;
-			regenerate |= ImGui::InputInt("Seed", &noiseConfig.seed);
-			regenerate |= ImGui::SliderInt("Octaves", &noiseConfig.octaves, 1, 8);
-			regenerate |= ImGui::SliderFloat("Offset x", &noiseConfig.xoffset, 0.0f, 5.0f);
-			regenerate |= ImGui::SliderFloat("Offset y", &noiseConfig.yoffset, 0.0f, 5.0f);
-			regenerate |= ImGui::SliderInt("Resolution", &noiseConfig.resolution, 100, 1000);
-			regenerate |= ImGui::SliderFloat("Scale", &noiseConfig.scale, 0.01f, 3.0f);
-			regenerate |= ImGui::SliderFloat("Constrast", &noiseConfig.constrast, 0.1f, 2.0f);
-			regenerate |= ImGui::SliderFloat("Redistribution", &noiseConfig.redistribution, 0.1f, 10.0f);
-			regenerate |= ImGui::SliderFloat("Lacunarity", &noiseConfig.lacunarity, 0.1f, 10.0f);
-			regenerate |= ImGui::SliderFloat("Persistance", &noiseConfig.persistance, 0.1f, 1.0f);
-
-			static const char* options[] = { "REFIT_ALL", "FLATTEN_NEGATIVES", "REVERT_NEGATIVES", "NOTHING" };
-			int current_option = static_cast<int>(noiseConfig.option);
-
-			if (ImGui::BeginCombo("Negatives: ", options[current_option]))
-			{
-				for (int n = 0; n < IM_ARRAYSIZE(options); n++)
-				{
-					bool is_selected = (current_option == n);
-					if (ImGui::Selectable(options[n], is_selected)) {
-						current_option = n;
-						noiseConfig.option = static_cast<noise::Options>(n);
-						regenerate = true;
-					}
-					if (is_selected)
-						ImGui::SetItemDefaultFocus();
-				}
-				ImGui::EndCombo();
-			}
-			if (noiseConfig.option == noise::Options::REVERT_NEGATIVES)
-				regenerate |= ImGui::SliderFloat("Revert Gain", &noiseConfig.revertGain, 0.1f, 1.0f);
-
-			// Ridged noise settings
-			regenerate |= ImGui::Checkbox("Ridge", &noiseConfig.Ridge);
-			if (noiseConfig.Ridge)
-			{
-				regenerate |= ImGui::SliderFloat("Ridge Gain", &noiseConfig.RidgeGain, 0.1f, 10.0f);
-				regenerate |= ImGui::SliderFloat("Ridge Offset", &noiseConfig.RidgeOffset, 0.1f, 10.0f);
-			}
-
-			// Island settings
-			regenerate |= ImGui::Checkbox("Island", &noiseConfig.island);
-			if (noiseConfig.island)
-			{
-				static const char* islandTypes[] = { "CONE", "DIAGONAL", "EUKLIDEAN_SQUARED",
-													 "SQUARE_BUMP","HYPERBOLOID", "SQUIRCLE",
-													 "TRIG" };
-				int current_island = static_cast<int>(noiseConfig.islandType);
-
-				if (ImGui::BeginCombo("Island type: ", islandTypes[current_island]))
-				{
-					for (int n = 0; n < IM_ARRAYSIZE(islandTypes); n++)
-					{
-						bool is_selected = (current_island == n);
-						if (ImGui::Selectable(islandTypes[n], is_selected)) {
-							current_island = n;
-							noiseConfig.islandType = static_cast<noise::IslandType>(n);
-							regenerate = true;
-						}
-						if (is_selected)
-							ImGui::SetItemDefaultFocus();
-					}
-					ImGui::EndCombo();
-				}
-				regenerate |= ImGui::SliderFloat("Mix Power", &noiseConfig.mixPower, 0.0f, 1.0f);
-			}
-			return regenerate;
-		}
-	}
-	//ImGui interface for modifying map size
-	//@param height - height of the noise map in chunks
-	//@param width - width of the noise map in chunks
-	bool MapSizeImGui(int& height, int& width)
-	{
-		if (ImGui::CollapsingHeader("Size settings", ImGuiTreeNodeFlags_DefaultOpen)) {
-			ImGui::Text("Resize map");
-			ImGui::InputInt("Height", &height);
-			ImGui::InputInt("Width", &width);
-			if (ImGui::Button("Resize")) {
-				return true;
-			}
-		}
-		return false;
-	}
-	bool DisplayModeImGui(float& modelScale, float& topoStep, float& topoBandWidth, float& heightScale, heightMapMode& m, bool& wireFrame, bool& map2d, bool& infGen)
-	{
-		if (ImGui::CollapsingHeader("Display settings:", ImGuiTreeNodeFlags_DefaultOpen)) {
-			ImGui::Text("Model scale:");
-			ImGui::SliderFloat("Model scale", &modelScale, 0.1f, 5.0f);
-			ImGui::Text("Isopleth:");
-			ImGui::SliderFloat("Step", &topoStep, 1.0f, heightScale);
-			ImGui::SliderFloat("Band width", &topoBandWidth, 0.1f, 1.0f);
-
-			static const char* displayOptions[] = { "GREYSCALE", "TOPOGRAPHICAL", "MONOCOLOR", "BIOMES"};
-			int currentDisplayOption = static_cast<int>(m);
-			bool change = false;
-
-			if (ImGui::BeginCombo("Mode", displayOptions[currentDisplayOption]))
-			{
-				for (int n = 0; n < IM_ARRAYSIZE(displayOptions); n++)
-				{
-					bool is_selected = (currentDisplayOption == n);
-					if (ImGui::Selectable(displayOptions[n], is_selected)) {
-						currentDisplayOption = n;
-						m = static_cast<utilities::heightMapMode>(n);
-						change = true;
-					}
-					if (is_selected)
-						ImGui::SetItemDefaultFocus();
-				}
-				ImGui::EndCombo();
-			}
-			if (ImGui::Checkbox("WireFrame", &wireFrame)) {
-				if (wireFrame) {
-					glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-					glDisable(GL_CULL_FACE);
-				}
-				else {
-					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-					//glEnable(GL_CULL_FACE);
-				}
-			}
-
-			ImGui::Checkbox("2D map", &map2d);
-			if (ImGuiButtonWrapper("Partial generation", !infGen)) {
-				infGen = !infGen;
-			}
-			ImGui::SameLine();
-			if(ImGuiButtonWrapper("Infinite generation", infGen)) {
-				infGen = !infGen;
-			}
-			return change;
-		}
-	}
-	bool SavingImGui()
-	{
-		if (ImGui::CollapsingHeader("Saving")) {
-			if (ImGui::Button("Save heightMap as an image")) {
-				std::cout << "[LOG] Well it will work one day i promise!" << std::endl;
-			}
-			if (ImGui::Button("Save heightMap as an 3d object")) {
-				std::cout << "[LOG] Well it will work one day i promise!" << std::endl;
-			}
-		}
-		return true;
-	}
-	bool ImGuiButtonWrapper(const char* label, bool disabled)
-	{
-		if (disabled) {
-			ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.1f, 0.8f, 0.1f, 1.0f));       
-			ImGui::BeginDisabled();
-		}
-
-		bool clicked = ImGui::Button(label);
-
-		if (disabled) {
-			ImGui::PopStyleColor(1);
-			ImGui::EndDisabled();
-		}
-		return clicked;
-	}
-}
\ No newline at end of file
+}
@@ -11,6 +11,10 @@
 #include "Erosion.h"
 #include "TerrainGenerator.h"
 #include "BiomeGenerator.h"
+#include "NormalMap.h"
+#include "ScratchArena.h"
+#include "Log.h"
+#include "StageGraph.h"
 
 namespace utilities
 {
@@ -22,13 +26,17 @@ namespace utilities
         BIOMES
 	};
 
+	//Index separating triangle strips, equal to the fixed restart index of GL_PRIMITIVE_RESTART_FIXED_INDEX for 32 bit indices
+	constexpr unsigned int STRIP_RESTART_INDEX = 0xFFFFFFFFu;
+
 	void ConvertToGrayscaleImage(float* data, unsigned char* image, const int& width, const int& height);
     void ParseNoiseIntoVertices(float* vertices, float* map, const int& width, const int& height, float scale, const unsigned int stride, unsigned int offset);
 	void GenerateVerticesForResolution(float* vertices, const int& height, const int& width, int resolution, const unsigned int& stride, unsigned int posOffset, unsigned int texOffset);
     void MeshIndicesStrips(unsigned int* indices, const int& width, const int& height);
-    bool CalculateHeightMapNormals(float* vertices, const unsigned int& stride, unsigned int offSet, const unsigned int& width, const unsigned int& height);
+    unsigned int GetStripIndexCount(const int& width, const int& height);
+	glm::vec3 getTopoColor(float hNorm);
 	bool PaintVerticesByHeight(float* vertices, const int& width, const int& height, const float& heightScale, const unsigned int& stride, heightMapMode m, unsigned int heightOffSet , unsigned int colorOffset);
-    std::vector<glm::vec3> GetBiomeColorMap(BiomeGenerator& biomeGen, const int& width, const int& height);
+    const glm::vec3* GetBiomeColorMap(BiomeGenerator& biomeGen, const int& width, const int& height, ScratchArena& scratch);
 
     void MapToVertices(float* map, float* vertices, unsigned int* indices, const int height, const int width, const unsigned int stride, const float& heightScale, heightMapMode mode, bool normalsCalculation, bool indexGeneration, bool paint);
     void PerformErosion(erosion::Erosion& erosion, float* vertices, float scalingFactor, std::optional<float*> Track, int stride, heightMapMode mode);
@@ -39,6 +47,9 @@ namespace utilities
     bool DisplayModeImGui(float& modelSclae, float& topoStep, float& topoBandWidth, float& heightScale, heightMapMode& m, bool& wireFrame, bool& map2d, bool& infGen);
 	bool SavingImGui();
 	bool ImGuiButtonWrapper(const char* label, bool disabled);
+	void JobSystemImGui();
+	void PerformanceImGui();
+	void StageGraphImGui(StageGraph& graph);
 
     //-----
 	//Other
@@ -52,6 +63,6 @@ namespace utilities
         auto end = std::chrono::high_resolution_clock::now();
 
         std::chrono::duration<double, std::milli> duration = end - start;
-        std::cout << "[LOG] Function '"<<funcName<<"' took: " << duration.count() << " ms" << std::endl;
+        LOG_INFO("Function '" << funcName << "' took: " << duration.count() << " ms");
     }
 }
\ No newline at end of file
@@ -0,0 +1,347 @@
+#include "utilities.h"
+
+#include <GL/glew.h>
+
+#include <iostream>
+#include <algorithm>
+#include "imgui/imgui.h"
+#include "ImPlot/implot.h"
+#include "JobSystem.h"
+#include "ScratchArena.h"
+#include "Trace.h"
+#include "PerfStats.h"
+#include "Log.h"
+
+//ImGui widgets declared in utilities.h, kept apart from utilities.cpp so the CPU helpers build without GL and ImGui
+
+namespace utilities
+{
+	//ImGui interface for modifying noise parameters
+	//@param noise - Perlin noise object
+	//@return - boolean value indicating if the noise parameters were modified
+	bool NoiseImGui(noise::NoiseConfigParameters& noiseConfig)
+	{
+		if (ImGui::CollapsingHeader("Noise Settings", ImGuiTreeNodeFlags_DefaultOpen)) {
+			bool regenerate = false;
+			regenerate |= ImGui::InputInt("Seed", &noiseConfig.seed);
+			regenerate |= ImGui::SliderInt("Octaves", &noiseConfig.octaves, 1, 8);
+			regenerate |= ImGui::SliderFloat("Offset x", &noiseConfig.xoffset, 0.0f, 5.0f);
+			regenerate |= ImGui::SliderFloat("Offset y", &noiseConfig.yoffset, 0.0f, 5.0f);
+			regenerate |= ImGui::SliderInt("Resolution", &noiseConfig.resolution, 100, 1000);
+			regenerate |= ImGui::SliderFloat("Scale", &noiseConfig.scale, 0.01f, 3.0f);
+			regenerate |= ImGui::SliderFloat("Constrast", &noiseConfig.constrast, 0.1f, 2.0f);
+			regenerate |= ImGui::SliderFloat("Redistribution", &noiseConfig.redistribution, 0.1f, 10.0f);
+			regenerate |= ImGui::SliderFloat("Lacunarity", &noiseConfig.lacunarity, 0.1f, 10.0f);
+			regenerate |= ImGui::SliderFloat("Persistance", &noiseConfig.persistance, 0.1f, 1.0f);
+
+			static const char* options[] = { "REFIT_ALL", "FLATTEN_NEGATIVES", "REVERT_NEGATIVES", "NOTHING" };
+			int current_option = static_cast<int>(noiseConfig.option);
+
+			if (ImGui::BeginCombo("Negatives: ", options[current_option]))
+			{
+				for (int n = 0; n < IM_ARRAYSIZE(options); n++)
+				{
+					bool is_selected = (current_option == n);
+					if (ImGui::Selectable(options[n], is_selected)) {
+						current_option = n;
+						noiseConfig.option = static_cast<noise::Options>(n);
+						regenerate = true;
+					}
+					if (is_selected)
+						ImGui::SetItemDefaultFocus();
+				}
+				ImGui::EndCombo();
+			}
+			if (noiseConfig.option == noise::Options::REVERT_NEGATIVES)
+				regenerate |= ImGui::SliderFloat("Revert Gain", &noiseConfig.revertGain, 0.1f, 1.0f);
+
+			// Ridged noise settings
+			regenerate |= ImGui::Checkbox("Ridge", &noiseConfig.Ridge);
+			if (noiseConfig.Ridge)
+			{
+				regenerate |= ImGui::SliderFloat("Ridge Gain", &noiseConfig.RidgeGain, 0.1f, 10.0f);
+				regenerate |= ImGui::SliderFloat("Ridge Offset", &noiseConfig.RidgeOffset, 0.1f, 10.0f);
+			}
+
+			// Island settings
+			regenerate |= ImGui::Checkbox("Island", &noiseConfig.island);
+			if (noiseConfig.island)
+			{
+				static const char* islandTypes[] = { "CONE", "DIAGONAL", "EUKLIDEAN_SQUARED",
+													 "SQUARE_BUMP","HYPERBOLOID", "SQUIRCLE",
+													 "TRIG" };
+				int current_island = static_cast<int>(noiseConfig.islandType);
+
+				if (ImGui::BeginCombo("Island type: ", islandTypes[current_island]))
+				{
+					for (int n = 0; n < IM_ARRAYSIZE(islandTypes); n++)
+					{
+						bool is_selected = (current_island == n);
+						if (ImGui::Selectable(islandTypes[n], is_selected)) {
+							current_island = n;
+							noiseConfig.islandType = static_cast<noise::IslandType>(n);
+							regenerate = true;
+						}
+						if (is_selected)
+							ImGui::SetItemDefaultFocus();
+					}
+					ImGui::EndCombo();
+				}
+				regenerate |= ImGui::SliderFloat("Mix Power", &noiseConfig.mixPower, 0.0f, 1.0f);
+			}
+			return regenerate;
+		}
+	}
+	//ImGui interface for modifying map size
+	//@param height - height of the noise map in chunks
+	//@param width - width of the noise map in chunks
+	bool MapSizeImGui(int& height, int& width)
+	{
+		if (ImGui::CollapsingHeader("Size settings", ImGuiTreeNodeFlags_DefaultOpen)) {
+			ImGui::Text("Resize map");
+			ImGui::InputInt("Height", &height);
+			ImGui::InputInt("Width", &width);
+			if (ImGui::Button("Resize")) {
+				return true;
+			}
+		}
+		return false;
+	}
+	bool DisplayModeImGui(float& modelScale, float& topoStep, float& topoBandWidth, float& heightScale, heightMapMode& m, bool& wireFrame, bool& map2d, bool& infGen)
+	{
+		if (ImGui::CollapsingHeader("Display settings:", ImGuiTreeNodeFlags_DefaultOpen)) {
+			ImGui::Text("Model scale:");
+			ImGui::SliderFloat("Model scale", &modelScale, 0.1f, 5.0f);
+			ImGui::Text("Isopleth:");
+			ImGui::SliderFloat("Step", &topoStep, 1.0f, heightScale);
+			ImGui::SliderFloat("Band width", &topoBandWidth, 0.1f, 1.0f);
+
+			static const char* displayOptions[] = { "GREYSCALE", "TOPOGRAPHICAL", "MONOCOLOR", "BIOMES"};
+			int currentDisplayOption = static_cast<int>(m);
+			bool change = false;
+
+			if (ImGui::BeginCombo("Mode", displayOptions[currentDisplayOption]))
+			{
+				for (int n = 0; n < IM_ARRAYSIZE(displayOptions); n++)
+				{
+					bool is_selected = (currentDisplayOption == n);
+					if (ImGui::Selectable(displayOptions[n], is_selected)) {
+						currentDisplayOption = n;
+						m = static_cast<utilities::heightMapMode>(n);
+						change = true;
+					}
+					if (is_selected)
+						ImGui::SetItemDefaultFocus();
+				}
+				ImGui::EndCombo();
+			}
+			if (ImGui::Checkbox("WireFrame", &wireFrame)) {
+				if (wireFrame) {
+					glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+					glDisable(GL_CULL_FACE);
+				}
+				else {
+					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+					//glEnable(GL_CULL_FACE);
+				}
+			}
+
+			ImGui::Checkbox("2D map", &map2d);
+			if (ImGuiButtonWrapper("Partial generation", !infGen)) {
+				infGen = !infGen;
+			}
+			ImGui::SameLine();
+			if(ImGuiButtonWrapper("Infinite generation", infGen)) {
+				infGen = !infGen;
+			}
+			return change;
+		}
+	}
+	bool SavingImGui()
+	{
+		if (ImGui::CollapsingHeader("Saving")) {
+			if (ImGui::Button("Save heightMap as an image")) {
+				LOG_INFO("Well it will work one day i promise!");
+			}
+			if (ImGui::Button("Save heightMap as an 3d object")) {
+				LOG_INFO("Well it will work one day i promise!");
+			}
+		}
+		return true;
+	}
+	bool ImGuiButtonWrapper(const char* label, bool disabled)
+	{
+		if (disabled) {
+			ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.1f, 0.8f, 0.1f, 1.0f));       
+			ImGui::BeginDisabled();
+		}
+
+		bool clicked = ImGui::Button(label);
+
+		if (disabled) {
+			ImGui::PopStyleColor(1);
+			ImGui::EndDisabled();
+		}
+		return clicked;
+	}
+
+	//ImGui interface of the job system: thread limit and utilization of every worker since the last reset
+	void JobSystemImGui()
+	{
+		if (ImGui::CollapsingHeader("Job system")) {
+			JobSystem& jobs = JobSystem::Get();
+			static int threads = jobs.GetWorkerCount() + 1;
+			ImGui::SliderInt("Threads", &threads, 1, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+			if (ImGui::IsItemDeactivatedAfterEdit()) {
+				jobs.SetWorkerLimit(threads);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Reset stats")) {
+				jobs.ResetWorkerStats();
+			}
+			bool tracing = IsTracingEnabled();
+			if (ImGui::Checkbox("Record trace", &tracing)) {
+				SetTracingEnabled(tracing);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Save trace")) {
+				WriteChromeTrace("trace.json");
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Clear trace")) {
+				ClearTrace();
+			}
+			static const char* logLevels[] = { "Debug", "Info", "Warning", "Error", "None" };
+			int logLevel = static_cast<int>(GetLogLevel());
+			if (ImGui::Combo("Log level", &logLevel, logLevels, IM_ARRAYSIZE(logLevels))) {
+				SetLogLevel(static_cast<LogLevel>(logLevel));
+			}
+			ImGui::Text("Scratch arena high water mark: %.2f MB", GetScratchHighWaterMark() / (1024.0 * 1024.0));
+			std::vector<WorkerStats> stats = jobs.GetWorkerStats();
+			for (size_t i = 0; i < stats.size(); i++) {
+				ImGui::Text("Worker %d: %5.1f%% busy, %llu jobs, %llu stolen", static_cast<int>(i), stats[i].GetUtilization() * 100.0f,
+					stats[i].jobsExecuted, stats[i].jobsStolen);
+			}
+		}
+	}
+
+	//Rolling graphs of the frame time, texture uploads and worker utilization next to the latest generation stage times
+	//and the memory held by every subsystem, all read from the PerfStats registry
+	void PerformanceImGui()
+	{
+		if (!ImGui::CollapsingHeader("Performance", ImGuiTreeNodeFlags_DefaultOpen)) {
+			return;
+		}
+		const PerfSnapshot stats = GetPerfSnapshot();
+		ImGui::Text("Frame: %.2f ms (avg %.2f, max %.2f)  Upload: %.1f KB  Workers: %.0f%% busy", stats.frameTimes.GetLatest(), stats.frameTimes.GetAverage(),
+			stats.frameTimes.GetMax(), stats.uploadBytes.GetLatest() / 1024.0f, stats.workerUtilization.GetLatest() * 100.0f);
+
+		const ImVec2 plotSize(-1, 150);
+		const ImPlotFlags plotFlags = ImPlotFlags_NoMenus | ImPlotFlags_NoBoxSelect;
+		if (!ImGui::BeginTable("Performance plots", 5, ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingStretchSame)) {
+			return;
+		}
+
+		//History plots, the newest sample is on the right
+		auto plotHistory = [&](const char* title, const char* unit, const PerfHistory& history, float scale, float minMax) {
+			float values[PERF_HISTORY_SIZE];
+			for (int i = 0; i < history.count; i++) {
+				values[i] = history.values[i] * scale;
+			}
+			ImGui::TableNextColumn();
+			if (ImPlot::BeginPlot(title, plotSize, plotFlags | ImPlotFlags_NoLegend)) {
+				ImPlot::SetupAxes(nullptr, unit, ImPlotAxisFlags_NoTickLabels, 0);
+				ImPlot::SetupAxisLimits(ImAxis_X1, 0, PERF_HISTORY_SIZE, ImGuiCond_Always);
+				ImPlot::SetupAxisLimits(ImAxis_Y1, 0, std::max(minMax, history.GetMax() * scale * 1.2f), ImGuiCond_Always);
+				ImPlot::PlotShaded(title, values, history.count, 0.0, 1.0, 0.0, 0, history.GetOffset());
+				ImPlot::PlotLine(title, values, history.count, 1.0, 0.0, 0, history.GetOffset());
+				ImPlot::EndPlot();
+			}
+		};
+		//Horizontal bars labelled with the entry names
+		auto plotBars = [&](const char* title, const char* unit, const std::vector<const char*>& labels, const std::vector<float>& values) {
+			ImGui::TableNextColumn();
+			if (ImPlot::BeginPlot(title, plotSize, plotFlags | ImPlotFlags_NoLegend)) {
+				ImPlot::SetupAxes(unit, nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+				if (!labels.empty()) {
+					std::vector<double> positions(labels.size());
+					for (size_t i = 0; i < positions.size(); i++) {
+						positions[i] = static_cast<double>(i);
+					}
+					ImPlot::SetupAxisTicks(ImAxis_Y1, positions.data(), static_cast<int>(positions.size()), labels.data());
+					ImPlot::PlotBars(title, values.data(), static_cast<int>(values.size()), 0.6, 0.0, ImPlotBarsFlags_Horizontal);
+				}
+				ImPlot::EndPlot();
+			}
+		};
+
+		plotHistory("Frame time", "ms", stats.frameTimes, 1.0f, 20.0f);
+
+		std::vector<const char*> labels;
+		std::vector<float> values;
+		for (const StageTiming& stage : stats.stages) {
+			labels.push_back(stage.name.c_str());
+			values.push_back(stage.history.GetLatest());
+		}
+		plotBars("Last stage times", "ms", labels, values);
+
+		plotHistory("Texture uploads", "KB", stats.uploadBytes, 1.0f / 1024.0f, 1.0f);
+		plotHistory("Worker utilization", "%", stats.workerUtilization, 100.0f, 100.0f);
+
+		labels.clear();
+		values.clear();
+		for (const MemoryUsage& usage : stats.memory) {
+			labels.push_back(usage.name.c_str());
+			values.push_back(static_cast<float>(usage.bytes / (1024.0 * 1024.0)));
+		}
+		plotBars("Memory", "MB", labels, values);
+
+		ImGui::EndTable();
+	}
+
+	//Table of the stages of a generation graph, what each of them did in the last evaluation and why it last ran
+	//A stage can be forced to run again with its button, f.e. to measure it
+	void StageGraphImGui(StageGraph& graph)
+	{
+		static const char* statusNames[] = { "Up to date", "Ran", "Failed", "Blocked", "Disabled" };
+		static const ImVec4 statusColors[] = { ImVec4(0.6f, 0.6f, 0.6f, 1.0f), ImVec4(0.3f, 1.0f, 0.3f, 1.0f), ImVec4(1.0f, 0.3f, 0.3f, 1.0f),
+			ImVec4(1.0f, 0.6f, 0.2f, 1.0f), ImVec4(0.4f, 0.4f, 0.4f, 1.0f) };
+
+		ImGui::Text("Evaluations: %llu", static_cast<unsigned long long>(graph.GetEvaluationCount()));
+		if (!ImGui::BeginTable("Generation stages", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+			return;
+		}
+		ImGui::TableSetupColumn("Stage");
+		ImGui::TableSetupColumn("Status");
+		ImGui::TableSetupColumn("Runs");
+		ImGui::TableSetupColumn("Last run");
+		ImGui::TableSetupColumn("Reason", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("");
+		ImGui::TableHeadersRow();
+
+		const std::vector<StageGraph::Stage>& stages = graph.GetStages();
+		for (int id = 0; id < static_cast<int>(stages.size()); id++) {
+			const StageGraph::Stage& stage = stages[id];
+			const int status = static_cast<int>(stage.status);
+			ImGui::PushID(id);
+			ImGui::TableNextColumn();
+			ImGui::Text("%s%s", stage.name.c_str(), stage.thread == StageThread::MAIN ? " (main)" : "");
+			ImGui::TableNextColumn();
+			ImGui::TextColored(statusColors[status], "%s", statusNames[status]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", stage.runs);
+			ImGui::TableNextColumn();
+			if (stage.runs > 0) {
+				ImGui::Text("%.2f ms, %llu frames ago", stage.lastTime, static_cast<unsigned long long>(graph.GetEvaluationCount() - stage.lastRunEvaluation));
+			}
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(stage.reason.c_str());
+			ImGui::TableNextColumn();
+			if (ImGui::SmallButton("Rerun")) {
+				graph.Invalidate(id);
+			}
+			ImGui::PopID();
+		}
+		ImGui::EndTable();
+	}
+}